@@ -0,0 +1,53 @@
+// 检查程序共用的计数、临时目录和结果汇总
+// 各检查程序只包含一次（单个翻译单元），失败计数直接定义在头文件中。
+
+#ifndef CHECKUTIL_H
+#define CHECKUTIL_H
+
+#include <QString>
+#include <QTemporaryDir>
+
+#include <cstdio>
+
+namespace checkutil {
+
+inline int g_failures = 0;
+
+// 打印每一项的结果
+inline void check(bool condition, const QString &what)
+{
+    std::printf("%-4s %s\n", condition ? "ok" : "FAIL", qPrintable(what));
+    if (!condition) {
+        g_failures++;
+    }
+}
+
+// 只打印失败的项（循环中的大量检查）
+inline void expect(bool condition, const QString &what)
+{
+    if (!condition) {
+        std::printf("FAIL %s\n", qPrintable(what));
+        g_failures++;
+    }
+}
+
+// 临时目录创建失败时打印原因并返回 false
+inline bool prepareTempDir(const QTemporaryDir &dir)
+{
+    if (!dir.isValid()) {
+        std::fprintf(stderr, "无法创建临时目录\n");
+        return false;
+    }
+    return true;
+}
+
+// 打印汇总，返回进程退出码
+inline int finish()
+{
+    std::printf("%s: %d 项失败\n", g_failures == 0 ? "通过" : "失败", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
+
+} // namespace checkutil
+
+#endif // CHECKUTIL_H
@@ -0,0 +1,153 @@
+// 帧存储引用计数检查
+// 在临时目录中按真实流程获取、释放、过期和回收帧，确认引用归零的帧文件确实被删除，
+// 仍被引用的帧保留，持久化引用在重新打开后恢复；并模拟保存引用计数之后异常退出，
+// 确认索引之外的帧和缺失的帧在重新打开时补齐，对齐之前不回收。任何一项不符合时返回非 0。
+//
+// 用法: framestore_check
+
+#include "storage/framestore.h"
+#include "checkutil.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QTemporaryDir>
+
+#include <cstdio>
+
+using namespace checkutil;
+
+namespace {
+
+QByteArray keyOf(int seed)
+{
+    QImage image(64, 48, QImage::Format_RGB32);
+    image.fill(QColor::fromHsv((seed * 47) % 360, 200, 200));
+    return FrameStore::hashImage(image);
+}
+
+// 模拟编码线程池写入帧文件
+bool writeBlob(const FrameStore &store, const QByteArray &key)
+{
+    QFile file(store.blobPath(key));
+    return file.open(QIODevice::WriteOnly) && file.write("jpeg") == 4;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    if (!prepareTempDir(dir)) {
+        return 1;
+    }
+
+    FrameStore store;
+    check(store.open(dir.path()), "打开帧存储");
+    store.setIndexedRecords(0);
+
+    // 获取 -> 写入 -> 第二条记录复用 -> 全部释放 -> 回收删除文件
+    QByteArray shared = keyOf(1);
+    check(store.acquire(shared, 4) == FrameStore::NeedsWrite, "新内容需要写入");
+    check(writeBlob(store, shared), "写入帧文件");
+    check(store.acquire(shared, 4) == FrameStore::AlreadyStored, "相同内容只增加引用");
+    check(store.refCount(shared) == 2, "两条记录引用同一帧");
+    store.collectGarbage();
+    check(QFile::exists(store.blobPath(shared)), "仍有引用时回收不删除文件");
+    store.release(shared);
+    store.release(shared);
+    store.release(shared);
+    check(store.refCount(shared) == 0, "重复释放不会使引用计数为负");
+    check(store.collectGarbage() == 4, "回收释放引用归零的帧");
+    check(!QFile::exists(store.blobPath(shared)), "引用归零的帧文件已删除");
+    check(!store.contains(shared), "引用归零的条目已移除");
+
+    // 撤销写入只撤销自己的引用
+    QByteArray aborted = keyOf(2);
+    check(store.acquire(aborted, 4) == FrameStore::NeedsWrite, "获取待写入的帧");
+    check(store.acquire(aborted, 4) == FrameStore::AlreadyStored, "写入前另一条记录复用");
+    store.abortWrite(aborted);
+    check(store.refCount(aborted) == 1, "撤销写入只减少一个引用");
+    check(store.acquire(aborted, 4) == FrameStore::NeedsWrite, "缺失的帧由下一帧重新写入");
+    store.release(aborted);
+    store.abortWrite(aborted);
+    check(!store.contains(aborted), "最后一个引用撤销后条目移除");
+
+    // 持久化引用：内存中的记录释放后仍保留，重新打开后恢复，过期后回收
+    QByteArray persisted = keyOf(3);
+    check(store.acquire(persisted, 4) == FrameStore::NeedsWrite, "获取历史记录的帧");
+    check(writeBlob(store, persisted), "写入历史记录的帧文件");
+    check(store.addPersistentRef(persisted, 1000, "editor"), "历史记录持有持久化引用");
+    store.release(persisted);
+    store.release(persisted);
+    check(store.refCount(persisted) == 1, "内存中的记录释放后只剩持久化引用");
+    store.collectGarbage();
+    check(QFile::exists(store.blobPath(persisted)), "历史记录引用的帧不被回收");
+    check(store.save(), "保存引用计数");
+
+    QByteArray memoryOnly = keyOf(4);
+    store.acquire(memoryOnly, 4);
+    writeBlob(store, memoryOnly);
+    check(store.save(), "保存只有内存引用的帧");
+
+    FrameStore reopened;
+    check(reopened.open(dir.path()), "重新打开帧存储");
+    check(reopened.refCount(persisted) == 1, "重新打开后恢复持久化引用");
+    check(reopened.refCount(memoryOnly) == 0, "内存中的引用不跨越重启");
+    check(reopened.collectGarbage() == 0, "与记录索引对齐之前不回收");
+    check(QFile::exists(reopened.blobPath(memoryOnly)), "对齐之前帧文件保留");
+    reopened.setIndexedRecords(reopened.indexedRecords());
+    reopened.collectGarbage();
+    check(!QFile::exists(reopened.blobPath(memoryOnly)), "只被内存记录引用的帧在重启后回收");
+
+    QVector<FrameUsage> frames = reopened.persistentFrames();
+    check(frames.size() == 1 && frames.first().key == persisted && frames.first().lastUsedMs == 1000
+          && frames.first().appName == "editor", "列出持久化引用的帧及其使用时间和应用");
+    reopened.expire(persisted);
+    check(reopened.refCount(persisted) == 0, "过期释放全部持久化引用");
+    check(reopened.collectGarbage() == 4, "过期的帧被回收");
+    check(!QFile::exists(reopened.blobPath(persisted)), "过期的帧文件已删除");
+
+    // 异常退出：引用计数保存之后又写入了帧并追加了记录，还有一个已保存的帧被删除
+    const QString crashRoot = QDir(dir.path()).filePath("crash");
+    QByteArray saved = keyOf(5);
+    QByteArray unsaved = keyOf(6);
+    QByteArray orphan = keyOf(7);
+    {
+        FrameStore crashed;
+        check(crashed.open(crashRoot), "打开异常退出前的帧存储");
+        crashed.setIndexedRecords(0);
+        crashed.acquire(saved, 4);
+        writeBlob(crashed, saved);
+        crashed.addPersistentRef(saved, 2000, "editor");
+        crashed.setIndexedRecords(1);
+        check(crashed.save(), "保存第 1 条记录之后的引用计数");
+
+        crashed.acquire(unsaved, 4);
+        writeBlob(crashed, unsaved);
+        crashed.addPersistentRef(unsaved, 3000, "editor");
+        crashed.acquire(orphan, 4);
+        writeBlob(crashed, orphan);
+        QFile::remove(crashed.blobPath(saved));
+    }
+
+    FrameStore recovered;
+    check(recovered.open(crashRoot), "异常退出后重新打开");
+    check(recovered.indexedRecords() == 1, "恢复已计入引用的记录数");
+    check(recovered.contains(unsaved) && recovered.contains(orphan), "登记索引之外的帧");
+    check(recovered.collectGarbage() == 0, "补齐引用之前不回收索引之外的帧");
+    check(recovered.acquire(saved, 4) == FrameStore::NeedsWrite, "缺失的帧由下一帧重新写入");
+    recovered.release(saved);
+
+    // 模拟记录索引的所有者补上第 2 条记录的引用
+    check(recovered.addPersistentRef(unsaved, 3000, "editor"), "补上保存之后追加的记录的引用");
+    recovered.setIndexedRecords(2);
+    check(recovered.collectGarbage() == 4, "对齐后回收没有引用的帧");
+    check(QFile::exists(recovered.blobPath(unsaved)), "记录索引引用的帧保留");
+    check(!QFile::exists(recovered.blobPath(orphan)), "没有记录引用的帧已删除");
+
+    return finish();
+}
@@ -0,0 +1,103 @@
+// 多屏截图基准测试
+// 比较逐屏串行抓取和按屏并行抓取整个虚拟桌面的耗时，需要在图形会话中运行。
+//
+// 用法: multiscreen_bench [迭代次数]
+
+#include "capture/multiscreencapture.h"
+
+#include <QElapsedTimer>
+#include <QGuiApplication>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct Timing {
+    double averageMs = 0.0;
+    double minMs = 0.0;
+    double maxMs = 0.0;
+    int failures = 0;
+};
+
+Timing measureDesktopGrab(MultiScreenCapture &capture, int iterations)
+{
+    QImage frame;
+    std::vector<double> samples;
+    Timing timing;
+
+    // 预热：建立后端连接、分配共享内存和缓冲区
+    capture.grabDesktop(frame);
+
+    for (int i = 0; i < iterations; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        if (!capture.grabDesktop(frame)) {
+            timing.failures++;
+        }
+        samples.push_back(timer.nsecsElapsed() / 1e6);
+    }
+
+    if (!samples.empty()) {
+        double total = 0.0;
+        for (double sample : samples) {
+            total += sample;
+        }
+        timing.averageMs = total / samples.size();
+        timing.minMs = *std::min_element(samples.begin(), samples.end());
+        timing.maxMs = *std::max_element(samples.begin(), samples.end());
+    }
+    return timing;
+}
+
+void printTiming(const char *name, const Timing &timing)
+{
+    std::printf("%-8s %10.2f %10.2f %10.2f %8d\n", name,
+                timing.averageMs, timing.minMs, timing.maxMs, timing.failures);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 30;
+    if (iterations <= 0) {
+        iterations = 30;
+    }
+
+    MultiScreenCapture capture;
+    QList<QRect> screens = MultiScreenCapture::currentScreens();
+    capture.setScreens(screens);
+
+    QRect desktop = capture.desktopRect();
+    std::printf("显示器 %d 块，虚拟桌面 %dx%d，迭代 %d 次\n",
+                screens.size(), desktop.width(), desktop.height(), iterations);
+    for (int i = 0; i < screens.size(); ++i) {
+        const QRect &screen = screens[i];
+        std::printf("  屏幕 %d: %dx%d @ (%d, %d)\n", i,
+                    screen.width(), screen.height(), screen.x(), screen.y());
+    }
+    if (screens.size() < 2) {
+        std::printf("只有一块显示器，串行与并行路径相同\n");
+    }
+
+    std::printf("%-8s %10s %10s %10s %8s\n", "模式", "平均 ms", "最快 ms", "最慢 ms", "失败");
+
+    capture.setParallel(false);
+    Timing serial = measureDesktopGrab(capture, iterations);
+    printTiming("串行", serial);
+
+    capture.setParallel(true);
+    Timing parallel = measureDesktopGrab(capture, iterations);
+    printTiming("并行", parallel);
+
+    if (parallel.averageMs > 0.0) {
+        std::printf("加速比 %.2fx\n", serial.averageMs / parallel.averageMs);
+    }
+
+    return (serial.failures == 0 && parallel.failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+// 录制回想拖动基准测试
+// 生成一组 JPEG 截图，按固定的拖动轨迹（匀速、加速、停顿、反向）驱动缩略图缓存，
+// 分别在关闭和开启预取时统计“滑块移动到准确的一帧显示出来”的延迟 p50 / p99。
+// 滑块已经移走、始终没有显示准确帧的位置单独计数。
+//
+// 用法: scrub_bench [帧数] [宽度] [高度]
+// 没有图形会话时加 -platform offscreen 运行。
+
+#include "settingsdialog/scrubprefetcher.h"
+#include "settingsdialog/thumbnailcache.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 每次滑块事件的间隔（约 60Hz 的鼠标移动）
+const int kEventIntervalMs = 16;
+
+// 缩略图尺寸与录制回想页面的详情区域一致
+const QSize kThumbnailSize(350, 250);
+
+struct ScrubStep {
+    int index = 0;
+    int pauseMs = kEventIntervalMs;   // 到下一次事件的间隔
+};
+
+struct Result {
+    std::vector<double> latenciesMs;  // 每个显示出准确帧的位置的延迟
+    int positions = 0;                // 滑块事件数
+    int immediate = 0;                // 缓存直接命中
+    int skipped = 0;                  // 准确帧还没解码完滑块就已移走
+};
+
+QByteArray encodeFrame(int index, const QSize &size)
+{
+    // 每帧内容不同：渐变背景加随帧号移动的色块和文字，接近真实截图的压缩比
+    QImage image(size, QImage::Format_RGB32);
+    QPainter painter(&image);
+    QLinearGradient gradient(0, 0, size.width(), size.height());
+    gradient.setColorAt(0, QColor::fromHsv((index * 7) % 360, 80, 230));
+    gradient.setColorAt(1, QColor::fromHsv((index * 7 + 120) % 360, 120, 120));
+    painter.fillRect(image.rect(), gradient);
+    for (int i = 0; i < 24; ++i) {
+        int x = (index * 37 + i * 131) % qMax(1, size.width() - 200);
+        int y = (index * 17 + i * 71) % qMax(1, size.height() - 120);
+        painter.fillRect(x, y, 200, 120, QColor::fromHsv((i * 29 + index) % 360, 200, 200));
+    }
+    painter.setPen(Qt::white);
+    painter.drawText(image.rect(), Qt::AlignCenter, QString("frame %1").arg(index));
+    painter.end();
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPEG", 85);
+    return data;
+}
+
+// 固定随机种子的拖动轨迹：若干段不同速度的拖动，中间夹着停顿和反向
+std::vector<ScrubStep> buildTrack(int frameCount)
+{
+    std::mt19937 random(20240601);
+    std::vector<ScrubStep> track;
+    int index = 0;
+    int direction = 1;
+    for (int segment = 0; segment < 40; ++segment) {
+        int stride = 1 + int(random() % 4);               // 每次移动 1-4 帧
+        int steps = 10 + int(random() % 30);
+        for (int i = 0; i < steps; ++i) {
+            int next = index + direction * stride;
+            if (next < 0 || next >= frameCount) {
+                direction = -direction;
+                next = qBound(0, index + direction * stride, frameCount - 1);
+            }
+            index = next;
+            ScrubStep step;
+            step.index = index;
+            track.push_back(step);
+        }
+
+        // 段尾：停顿看一会儿，或直接反向
+        if (random() % 3 == 0) {
+            track.back().pauseMs = 200 + int(random() % 400);
+        }
+        if (random() % 2 == 0) {
+            direction = -direction;
+        }
+    }
+    return track;
+}
+
+Result runTrack(const QVector<AppRecord> &records, const std::vector<ScrubStep> &track, bool prefetch)
+{
+    ThumbnailCache cache(kThumbnailSize);
+    cache.setLoader([](int, const AppRecord &record, const QSize &size) {
+        return ThumbnailCache::decodeScaled(record.encodedScreenshot, size);
+    });
+    ScrubPrefetcher prefetcher(&cache);
+    prefetcher.setSource(records.size(), [&records](int index) {
+        return records.at(index);
+    });
+    prefetcher.setEnabled(prefetch);
+
+    Result result;
+    QElapsedTimer clock;
+    clock.start();
+    qint64 shownKey = -1;
+    qint64 shownAt = 0;
+    bool waiting = false;
+
+    QObject::connect(&cache, &ThumbnailCache::thumbnailReady, [&](qint64 key, const QImage &) {
+        if (waiting && key == shownKey) {
+            result.latenciesMs.push_back((clock.nsecsElapsed() - shownAt) / 1e6);
+            waiting = false;
+        }
+    });
+
+    QEventLoop loop;
+    for (const ScrubStep &step : track) {
+        // 与 RecordingWidget::showRecord 相同：先请求显示，再通知预取
+        const AppRecord &record = records.at(step.index);
+        if (waiting) {
+            result.skipped++;
+        }
+        qint64 start = clock.nsecsElapsed();
+        bool exact = false;
+        cache.request(step.index, record, &exact);
+        prefetcher.positionChanged(step.index);
+        result.positions++;
+        shownKey = ThumbnailCache::keyOf(record);
+        if (exact) {
+            result.immediate++;
+            result.latenciesMs.push_back((clock.nsecsElapsed() - start) / 1e6);
+            waiting = false;
+        } else {
+            shownAt = start;
+            waiting = true;
+        }
+
+        // 在事件循环中等到下一次滑块事件，期间处理解码完成的通知
+        QTimer::singleShot(step.pauseMs, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    // 最后一个位置等它显示完
+    if (waiting) {
+        QTimer::singleShot(1000, &loop, &QEventLoop::quit);
+        loop.exec();
+        if (waiting) {
+            result.skipped++;
+        }
+    }
+    return result;
+}
+
+double percentile(std::vector<double> samples, double fraction)
+{
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t rank = size_t(fraction * (samples.size() - 1) + 0.5);
+    return samples[std::min(rank, samples.size() - 1)];
+}
+
+void printResult(const char *name, const Result &result)
+{
+    std::printf("%-8s %8d %8d %8d %10.2f %10.2f\n", name,
+                result.positions, result.immediate, result.skipped,
+                percentile(result.latenciesMs, 0.50), percentile(result.latenciesMs, 0.99));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    int frameCount = argc > 1 ? std::atoi(argv[1]) : 300;
+    int width = argc > 2 ? std::atoi(argv[2]) : 1920;
+    int height = argc > 3 ? std::atoi(argv[3]) : 1080;
+    if (frameCount <= 0 || width <= 0 || height <= 0) {
+        std::fprintf(stderr, "用法: scrub_bench [帧数] [宽度] [高度]\n");
+        return 1;
+    }
+
+    std::printf("生成 %d 帧 %dx%d 的 JPEG 截图...\n", frameCount, width, height);
+    QVector<AppRecord> records;
+    QDateTime base = QDateTime::currentDateTime();
+    qint64 totalBytes = 0;
+    for (int i = 0; i < frameCount; ++i) {
+        AppRecord record;
+        record.appName = "bench";
+        record.timestamp = base.addMSecs(qint64(i) * 1000);
+        record.encodedScreenshot = encodeFrame(i, QSize(width, height));
+        totalBytes += record.encodedScreenshot.size();
+        records.append(record);
+    }
+    std::printf("平均每帧 %.1f KB\n", totalBytes / 1024.0 / frameCount);
+
+    std::vector<ScrubStep> track = buildTrack(frameCount);
+    std::printf("拖动轨迹 %d 次滑块事件\n", int(track.size()));
+    std::printf("%-8s %8s %8s %8s %10s %10s\n", "模式", "位置", "命中", "未显示", "p50 ms", "p99 ms");
+
+    Result plain = runTrack(records, track, false);
+    printResult("无预取", plain);
+
+    Result prefetched = runTrack(records, track, true);
+    printResult("预取", prefetched);
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+// 段存储恢复检查
+// 在临时目录中模拟异常退出：索引文件落后于段文件、段文件末尾留下写了一半的记录、
+// 记录数据损坏，确认重新打开后从段文件逐条校验补回索引、截掉不完整的记录，
+// 之后仍能继续追加；并在多个线程同时追加后丢弃索引整体重建，确认所有记录的 CRC 都能校验通过。
+// 任何一项不符合时返回非 0。
+//
+// 用法: segmentstore_check
+
+#include "storage/segmentstore.h"
+#include "checkutil.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace checkutil;
+
+namespace {
+
+// 与 segmentstore.cpp 中的定长结构一致
+const qint64 kIndexHeaderSize = 4 + 4 + 4;
+const qint64 kIndexEntrySize = 8 + 4 + 8 + 4 + 8 + 4 + 32;
+
+// 第 seed 条记录的截图数据（长度各不相同）
+QByteArray payloadOf(int seed)
+{
+    QByteArray data(200 + seed * 37, '\0');
+    for (int i = 0; i < data.size(); ++i) {
+        data[i] = char((i * 31 + seed * 7) & 0xFF);
+    }
+    return data;
+}
+
+QByteArray keyOf(const QByteArray &data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha256).toHex();
+}
+
+bool appendRecord(SegmentStore &store, int seed)
+{
+    QByteArray data = payloadOf(seed);
+    return store.append(1000 + seed, QString("app%1").arg(seed % 3), keyOf(data), data);
+}
+
+// 已提交的记录都能按原样读回
+bool readsBack(const SegmentStore &store, const QVector<int> &seeds)
+{
+    if (store.count() != seeds.size()) {
+        return false;
+    }
+    for (int i = 0; i < seeds.size(); ++i) {
+        SegmentEntry entry = store.entry(i);
+        if (entry.timestampMs != 1000 + seeds[i] || store.appName(entry.appId) != QString("app%1").arg(seeds[i] % 3)
+            || store.read(entry) != payloadOf(seeds[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool resizeFile(const QString &filePath, qint64 size)
+{
+    QFile file(filePath);
+    return file.resize(size);
+}
+
+bool appendBytes(const QString &filePath, const QByteArray &bytes)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::Append) && file.write(bytes) == bytes.size();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+    if (!prepareTempDir(dir)) {
+        return 1;
+    }
+    const QString root = dir.filePath("segments");
+    const QString segmentPath = QDir(root).filePath("seg-000001.dat");
+    const QString indexPath = QDir(root).filePath("seg-000001.idx");
+
+    // 写入一批记录，其中一条与之前内容相同（同段内写成引用）
+    QVector<int> seeds;
+    {
+        SegmentStore store;
+        check(store.open(root), "打开段存储");
+        store.setSyncBatch(1000, 60 * 60 * 1000);
+        for (int seed : { 1, 2, 3, 4, 5, 2, 6, 7 }) {
+            check(appendRecord(store, seed), "追加记录");
+            seeds.append(seed);
+        }
+        check(store.sync(), "提交记录");
+        check(store.deduplicatedCount() == 1, "相同内容只保存一次");
+        check(readsBack(store, seeds), "提交后读回全部记录");
+    }
+    const qint64 committedSize = QFileInfo(segmentPath).size();
+
+    // 索引落后于段文件，且段文件末尾有写了一半的记录
+    check(resizeFile(indexPath, kIndexHeaderSize + 5 * kIndexEntrySize), "模拟索引只写入前 5 项");
+    check(appendBytes(segmentPath, QByteArray::fromHex("53524543") + QByteArray(40, '\x7f')), "模拟写了一半的记录");
+    {
+        SegmentStore store;
+        check(store.open(root), "重新打开段存储");
+        check(readsBack(store, seeds), "从段文件补回索引缺失的记录");
+        check(QFileInfo(segmentPath).size() == committedSize, "截掉段文件末尾不完整的记录");
+        check(QFileInfo(indexPath).size() == kIndexHeaderSize + seeds.size() * kIndexEntrySize, "重建索引文件");
+
+        store.setSyncBatch(1000, 60 * 60 * 1000);
+        check(appendRecord(store, 8), "恢复后继续追加");
+        check(store.sync(), "恢复后提交");
+        seeds.append(8);
+        check(readsBack(store, seeds), "恢复后追加的记录可以读回");
+    }
+
+    // 最后一条记录的数据损坏（CRC 不符），索引中也没有它：恢复时丢弃
+    {
+        QFile segment(segmentPath);
+        segment.open(QIODevice::ReadWrite);
+        segment.seek(segment.size() - 10);
+        QByteArray tail = segment.read(1);
+        segment.seek(segment.size() - 10);
+        segment.write(QByteArray(1, char(tail.at(0) ^ 0x5a)));
+    }
+    check(resizeFile(indexPath, kIndexHeaderSize), "模拟索引为空");
+    {
+        SegmentStore store;
+        check(store.open(root), "损坏后重新打开");
+        seeds.removeLast();
+        check(readsBack(store, seeds), "CRC 不符的记录被丢弃，之前的记录全部补回");
+    }
+
+    // 多个线程同时追加（提交、校验在各自线程中计算 CRC），之后丢弃索引整体重建
+    const QString concurrentRoot = dir.filePath("concurrent");
+    const int threadCount = 4;
+    const int perThread = 50;
+    {
+        SegmentStore store;
+        check(store.open(concurrentRoot), "打开并发写入的段存储");
+        store.setSyncBatch(8, 60 * 60 * 1000);
+        std::vector<std::unique_ptr<QThread>> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back(QThread::create([&store, t]() {
+                for (int i = 0; i < perThread; ++i) {
+                    appendRecord(store, 100 + t * perThread + i);
+                }
+            }));
+            threads.back()->start();
+        }
+        for (auto &thread : threads) {
+            thread->wait();
+        }
+        check(store.sync(), "提交并发写入的记录");
+        check(store.count() == threadCount * perThread, "并发追加的记录全部提交");
+    }
+    check(resizeFile(QDir(concurrentRoot).filePath("seg-000001.idx"), kIndexHeaderSize), "丢弃并发写入的索引");
+    {
+        SegmentStore store;
+        check(store.open(concurrentRoot), "重新打开并发写入的段存储");
+        check(store.count() == threadCount * perThread, "所有记录的 CRC 校验通过并补回索引");
+        bool intact = true;
+        for (int i = 0; i < store.count(); ++i) {
+            SegmentEntry entry = store.entry(i);
+            intact = intact && store.read(entry) == payloadOf(int(entry.timestampMs - 1000));
+        }
+        check(intact, "重建索引后的记录内容完整");
+    }
+
+    return finish();
+}
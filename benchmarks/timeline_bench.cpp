@@ -0,0 +1,244 @@
+// 时间线容器压缩率与随机访问检查
+// 生成一段接近办公场景的录制（文档逐字输入、光标闪烁、时钟跳动、偶尔滚动和切换应用），
+// 写入 .tlc 后报告相对于逐帧整帧 JPEG 的压缩比（目标 5 倍以上），并检查：
+//   - 随机跳转解码：每帧尺寸正确，与原图的平均误差在 JPEG 的正常范围内，
+//     与不经缓存、从关键帧重新解码的结果完全一致
+//   - 末尾截断：录制中断留下的不完整帧被忽略，之前的帧仍能解码
+// 检查失败时返回非 0；压缩比未达到目标只提示，不算失败（取决于画面内容）。
+//
+// 用法: timeline_bench [帧数] [宽度] [高度] [关键帧间隔]
+// 没有图形会话时加 -platform offscreen 运行。
+
+#include "storage/timelinecodec.h"
+#include "checkutil.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace checkutil;
+
+namespace {
+
+// 图块边长和 JPEG 质量与默认截图配置一致
+const int kTileSize = 64;
+const int kQuality = 85;
+
+// 目标压缩比
+const double kTargetRatio = 5.0;
+
+// 解码结果与原图的平均误差上限（每通道 0-255）
+const double kMaxMeanError = 6.0;
+
+// 每个场景（应用）持续的帧数，场景内文档逐字输入，过半后滚动一次
+const int kSceneFrames = 120;
+
+const char *const kText =
+    "The quarterly report summarises revenue, costs and the outlook for the next period. "
+    "Sales grew in every region, led by strong demand for the new product line. ";
+
+// 第 index 帧的画面（纯函数，随机访问时可以重新生成原图做比较）
+QImage renderFrame(int index, const QSize &size)
+{
+    const int scene = index / kSceneFrames;
+    const int step = index % kSceneFrames;
+
+    QImage image(size, QImage::Format_RGB32);
+    QPainter painter(&image);
+    painter.fillRect(image.rect(), QColor::fromHsv((scene * 67) % 360, 40, 90));
+
+    // 窗口：标题栏、工具栏、白色文档区
+    QRect window(size.width() / 20, size.height() / 20, size.width() * 9 / 10, size.height() * 8 / 10);
+    painter.fillRect(window, QColor(240, 240, 240));
+    painter.fillRect(QRect(window.topLeft(), QSize(window.width(), 32)), QColor::fromHsv((scene * 67) % 360, 120, 180));
+    painter.setPen(Qt::white);
+    painter.drawText(window.left() + 12, window.top() + 22, QString("Document %1 - Editor").arg(scene + 1));
+    for (int i = 0; i < 12; ++i) {
+        painter.fillRect(window.left() + 12 + i * 36, window.top() + 40, 28, 24, QColor(200, 200, 210));
+    }
+    QRect page = window.adjusted(40, 80, -40, -20);
+    painter.fillRect(page, Qt::white);
+
+    // 文档逐字输入，每帧多出几个字符；过半后向上滚动若干行
+    painter.setPen(Qt::black);
+    QFont font = painter.font();
+    font.setPixelSize(16);
+    painter.setFont(font);
+    const QString text = QString::fromLatin1(kText).repeated(40);
+    const int charsPerLine = qMax(20, page.width() / 9);
+    const int lineHeight = 22;
+    const int typed = 200 + step * 6;
+    const int scroll = step >= kSceneFrames / 2 ? 8 : 0;
+    int line = 0;
+    int cursorX = page.left() + 10;
+    int cursorY = page.top() + 10;
+    for (int offset = scroll * charsPerLine; offset < typed; offset += charsPerLine, ++line) {
+        int y = page.top() + 10 + line * lineHeight;
+        if (y + lineHeight > page.bottom()) {
+            break;
+        }
+        QString lineText = text.mid(offset, qMin(charsPerLine, typed - offset));
+        painter.drawText(page.left() + 10, y + 16, lineText);
+        cursorX = page.left() + 10 + painter.fontMetrics().horizontalAdvance(lineText);
+        cursorY = y;
+    }
+
+    // 光标闪烁
+    if (index % 2 == 0) {
+        painter.fillRect(cursorX + 1, cursorY + 2, 2, 18, Qt::black);
+    }
+
+    // 任务栏时钟每帧跳动
+    QRect taskbar(0, size.height() - 40, size.width(), 40);
+    painter.fillRect(taskbar, QColor(30, 30, 40));
+    painter.setPen(Qt::white);
+    int seconds = 9 * 3600 + index * 2;
+    painter.drawText(taskbar.adjusted(0, 0, -16, 0), Qt::AlignRight | Qt::AlignVCenter,
+                     QString("%1:%2:%3").arg(seconds / 3600, 2, 10, QChar('0'))
+                         .arg(seconds / 60 % 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0')));
+    painter.end();
+    return image;
+}
+
+QByteArray encodeJpeg(const QImage &image)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPEG", kQuality);
+    return data;
+}
+
+// 每隔几个像素采样一次的平均绝对误差
+double meanError(const QImage &a, const QImage &b)
+{
+    qint64 total = 0;
+    qint64 samples = 0;
+    for (int y = 0; y < a.height(); y += 3) {
+        const QRgb *rowA = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+        const QRgb *rowB = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+        for (int x = 0; x < a.width(); x += 3) {
+            total += qAbs(qRed(rowA[x]) - qRed(rowB[x])) + qAbs(qGreen(rowA[x]) - qGreen(rowB[x]))
+                + qAbs(qBlue(rowA[x]) - qBlue(rowB[x]));
+            samples += 3;
+        }
+    }
+    return samples > 0 ? double(total) / samples : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    int frameCount = argc > 1 ? std::atoi(argv[1]) : 360;
+    int width = argc > 2 ? std::atoi(argv[2]) : 1920;
+    int height = argc > 3 ? std::atoi(argv[3]) : 1080;
+    int keyframeInterval = argc > 4 ? std::atoi(argv[4]) : 30;
+    if (frameCount <= 1 || width <= 0 || height <= 0 || keyframeInterval <= 0) {
+        std::fprintf(stderr, "用法: timeline_bench [帧数] [宽度] [高度] [关键帧间隔]\n");
+        return 1;
+    }
+    const QSize size(width, height);
+
+    QTemporaryDir dir;
+    if (!prepareTempDir(dir)) {
+        return 1;
+    }
+    QString filePath = dir.filePath("bench.tlc");
+
+    // 编码：整帧 JPEG 与流水线中的记录相同，编码器据此统计对照字节数
+    std::printf("编码 %d 帧 %dx%d，关键帧间隔 %d...\n", frameCount, width, height, keyframeInterval);
+    TimelineEncoder encoder;
+    expect(encoder.open(filePath, kTileSize, keyframeInterval, kQuality), "创建时间线文件");
+    QElapsedTimer timer;
+    timer.start();
+    QDateTime base = QDateTime::currentDateTime();
+    for (int i = 0; i < frameCount; ++i) {
+        AppRecord record;
+        record.appName = QString("editor%1").arg(i / kSceneFrames);
+        record.timestamp = base.addSecs(i * 2);
+        record.screenshot = renderFrame(i, size);
+        record.encodedScreenshot = encodeJpeg(record.screenshot);
+        // 积压已满时等编码线程追上，基准中不丢帧
+        while (!encoder.appendFrame(record)) {
+            QThread::msleep(1);
+        }
+    }
+    encoder.close();
+    double elapsedMs = timer.elapsed();
+
+    std::printf("帧数 %d，关键帧 %d\n", encoder.frameCount(), encoder.keyframeCount());
+    std::printf("整帧 JPEG %.1f KB，时间线 %.1f KB，压缩比 %.2fx（目标 %.0fx%s）\n",
+                encoder.jpegBytes() / 1024.0, encoder.bytesWritten() / 1024.0, encoder.compressionRatio(),
+                kTargetRatio, encoder.compressionRatio() >= kTargetRatio ? "，已达到" : "，未达到");
+    std::printf("平均每帧 %.1f ms（含生成画面和整帧 JPEG）\n", elapsedMs / frameCount);
+    expect(encoder.frameCount() == frameCount, "所有帧都已写入");
+
+    // 随机跳转解码
+    TimelineDecoder decoder;
+    expect(decoder.open(filePath), "打开时间线文件");
+    expect(decoder.frameCount() == frameCount, "解码器读到全部帧");
+
+    std::mt19937 random(20240601);
+    const int seeks = qMin(60, frameCount);
+    double worstError = 0.0;
+    QElapsedTimer seekTimer;
+    qint64 seekNs = 0;
+    for (int n = 0; n < seeks; ++n) {
+        int index = int(random() % quint32(decoder.frameCount()));
+        seekTimer.start();
+        QImage decoded = decoder.frame(index);
+        seekNs += seekTimer.nsecsElapsed();
+        if (decoded.size() != size) {
+            expect(false, QString("第 %1 帧解码尺寸错误").arg(index));
+            continue;
+        }
+
+        // 不经缓存、从关键帧重新解码，结果必须完全一致
+        TimelineDecoder fresh;
+        fresh.open(filePath);
+        expect(fresh.frame(index) == decoded, QString("第 %1 帧随机跳转与从关键帧解码的结果不一致").arg(index));
+
+        double error = meanError(decoded, renderFrame(index, size));
+        worstError = qMax(worstError, error);
+        expect(error <= kMaxMeanError, QString("第 %1 帧与原图误差过大: %2").arg(index).arg(error));
+    }
+    std::printf("随机跳转 %d 次，平均 %.1f ms，最大平均误差 %.2f\n", seeks, seekNs / 1e6 / seeks, worstError);
+
+    // 末尾截断：模拟录制中断
+    QFile source(filePath);
+    source.open(QIODevice::ReadOnly);
+    QByteArray content = source.readAll();
+    source.close();
+    const TimelineFrameInfo &last = decoder.frameInfo(decoder.frameCount() - 1);
+    qint64 cuts[] = { content.size() - 1, last.dataOffset + last.dataSize / 2, last.dataOffset - 3 };
+    for (qint64 cut : cuts) {
+        QString truncatedPath = dir.filePath(QString("truncated_%1.tlc").arg(cut));
+        QFile truncated(truncatedPath);
+        truncated.open(QIODevice::WriteOnly);
+        truncated.write(content.left(int(cut)));
+        truncated.close();
+
+        TimelineDecoder recovered;
+        expect(recovered.open(truncatedPath), QString("打开截断到 %1 字节的文件").arg(cut));
+        expect(recovered.frameCount() == frameCount - 1,
+              QString("截断到 %1 字节后只忽略最后一帧（读到 %2 帧）").arg(cut).arg(recovered.frameCount()));
+        if (recovered.frameCount() > 0) {
+            int lastIndex = recovered.frameCount() - 1;
+            expect(recovered.frame(lastIndex).size() == size, QString("截断后第 %1 帧仍能解码").arg(lastIndex));
+        }
+    }
+
+    return finish();
+}
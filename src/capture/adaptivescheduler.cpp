@@ -0,0 +1,184 @@
+#include "adaptivescheduler.h"
+#include <QDebug>
+#include <QtMath>
+
+namespace {
+
+// 画面活动度的滑动平均系数，越大对最近的帧越敏感
+const double kActivitySmoothing = 0.3;
+
+// 有变化的帧至少计为这个活动度，打字等小范围变化也能缩短间隔
+const double kChangedFrameFloor = 0.5;
+
+// 输入空闲时间在此以内视为正在操作，超过上限视为离开
+const qint64 kInputActiveMs = 5000;
+const qint64 kInputAwayMs = 60000;
+
+// 查询输入空闲时间的周期，决定用户回来后多快恢复密集截图
+const int kInputPollMs = 1000;
+
+} // namespace
+
+AdaptiveScheduler::AdaptiveScheduler(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+    , m_inputPollTimer(new QTimer(this))
+    , m_adaptive(true)
+    , m_fixedInterval(5000)
+    , m_minInterval(2000)
+    , m_maxInterval(60000)
+    , m_switchDelay(500)
+    , m_frameActivity(0.5)
+    , m_inputIdleMs(-1)
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &AdaptiveScheduler::onTimeout);
+
+    m_inputPollTimer->setInterval(kInputPollMs);
+    connect(m_inputPollTimer, &QTimer::timeout, this, &AdaptiveScheduler::pollInputIdle);
+}
+
+void AdaptiveScheduler::setAdaptive(bool adaptive)
+{
+    m_adaptive = adaptive;
+}
+
+bool AdaptiveScheduler::isAdaptive() const
+{
+    return m_adaptive;
+}
+
+void AdaptiveScheduler::setFixedInterval(int intervalMs)
+{
+    m_fixedInterval = qMax(1, intervalMs);
+}
+
+void AdaptiveScheduler::setIntervalRange(int minMs, int maxMs)
+{
+    m_minInterval = qMax(1, minMs);
+    m_maxInterval = qMax(m_minInterval, maxMs);
+}
+
+void AdaptiveScheduler::setSwitchDelay(int delayMs)
+{
+    m_switchDelay = qMax(0, delayMs);
+}
+
+void AdaptiveScheduler::setInputIdleSource(const std::function<qint64()> &source)
+{
+    m_inputIdleSource = source;
+}
+
+void AdaptiveScheduler::start()
+{
+    scheduleNext(computeInterval());
+    if (m_inputIdleSource) {
+        m_inputPollTimer->start();
+    }
+}
+
+void AdaptiveScheduler::stop()
+{
+    m_timer->stop();
+    m_inputPollTimer->stop();
+}
+
+bool AdaptiveScheduler::isActive() const
+{
+    return m_timer->isActive();
+}
+
+void AdaptiveScheduler::reportFrame(bool changed, double changedRatio)
+{
+    double sample = changed ? qMin(1.0, kChangedFrameFloor + changedRatio) : 0.0;
+    m_frameActivity = kActivitySmoothing * sample + (1.0 - kActivitySmoothing) * m_frameActivity;
+
+    // 画面突然活跃时不必等完当前的长间隔
+    rescheduleIfSooner();
+}
+
+void AdaptiveScheduler::reportInputIdle(qint64 idleMs)
+{
+    m_inputIdleMs = idleMs;
+
+    // 用户回来操作时同样提前截图
+    rescheduleIfSooner();
+}
+
+void AdaptiveScheduler::notifyAppSwitch()
+{
+    if (!m_adaptive || !m_timer->isActive()) {
+        return;
+    }
+
+    // 切换应用意味着用户正在操作；连续快速切换时只在停下后截一次
+    m_frameActivity = 1.0;
+    m_inputIdleMs = 0;
+    scheduleNext(m_switchDelay);
+}
+
+double AdaptiveScheduler::activityLevel() const
+{
+    if (m_inputIdleMs < 0) {
+        return m_frameActivity;
+    }
+
+    // 输入活动度：操作中为 1，离开后为 0，中间线性过渡
+    double inputActivity = 1.0;
+    if (m_inputIdleMs >= kInputAwayMs) {
+        inputActivity = 0.0;
+    } else if (m_inputIdleMs > kInputActiveMs) {
+        inputActivity = 1.0 - double(m_inputIdleMs - kInputActiveMs) / (kInputAwayMs - kInputActiveMs);
+    }
+
+    // 无输入但画面在变（如播放视频）时仍按画面活动度截图
+    return qMax(m_frameActivity, inputActivity);
+}
+
+int AdaptiveScheduler::currentInterval() const
+{
+    return computeInterval();
+}
+
+void AdaptiveScheduler::onTimeout()
+{
+    // 按截图时的输入空闲时间计算下一次间隔
+    emit captureRequested();
+    pollInputIdle();
+    scheduleNext(computeInterval());
+}
+
+void AdaptiveScheduler::pollInputIdle()
+{
+    if (m_inputIdleSource) {
+        reportInputIdle(m_inputIdleSource());
+    }
+}
+
+int AdaptiveScheduler::computeInterval() const
+{
+    if (!m_adaptive) {
+        return m_fixedInterval;
+    }
+
+    // 按几何插值，活动度的每一档对应相同的倍率变化
+    double level = qBound(0.0, activityLevel(), 1.0);
+    double ratio = double(m_maxInterval) / m_minInterval;
+    return qRound(m_minInterval * qPow(ratio, 1.0 - level));
+}
+
+void AdaptiveScheduler::scheduleNext(int intervalMs)
+{
+    m_timer->start(intervalMs);
+}
+
+void AdaptiveScheduler::rescheduleIfSooner()
+{
+    if (!m_adaptive || !m_timer->isActive()) {
+        return;
+    }
+    int interval = computeInterval();
+    if (interval < m_timer->remainingTime()) {
+        scheduleNext(interval);
+    }
+}
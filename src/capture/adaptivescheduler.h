@@ -0,0 +1,67 @@
+#ifndef ADAPTIVESCHEDULER_H
+#define ADAPTIVESCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <functional>
+
+// 自适应截图调度器
+// 根据最近的画面变化率、用户输入活动和应用切换，在最小和最大间隔之间调整截图频率：
+// 忙碌时密集截图，空闲时拉长间隔。应用切换后经过短暂防抖立即截图一次。
+// 输入空闲时间由独立的短周期定时器查询，用户回来时不必等完当前的长间隔。
+// 关闭自适应时退化为固定间隔定时器。
+class AdaptiveScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AdaptiveScheduler(QObject *parent = nullptr);
+
+    // 配置
+    void setAdaptive(bool adaptive);
+    bool isAdaptive() const;
+    void setFixedInterval(int intervalMs);          // 关闭自适应时使用的间隔
+    void setIntervalRange(int minMs, int maxMs);    // 自适应间隔范围
+    void setSwitchDelay(int delayMs);               // 应用切换后的防抖延迟
+    void setInputIdleSource(const std::function<qint64()> &source); // 查询输入空闲时间（-1 表示未知）
+
+    // 控制
+    void start();
+    void stop();
+    bool isActive() const;
+
+    // 活动输入
+    void reportFrame(bool changed, double changedRatio); // 一帧的变化检测结果
+    void reportInputIdle(qint64 idleMs);                 // 距离最近一次输入的时间，-1 表示未知
+    void notifyAppSwitch();                              // 前台应用已切换
+
+    // 当前状态
+    double activityLevel() const;    // 0（空闲）~ 1（忙碌）
+    int currentInterval() const;     // 下一次截图的间隔（毫秒）
+
+signals:
+    // 到达截图时间
+    void captureRequested();
+
+private slots:
+    void onTimeout();
+    void pollInputIdle();
+
+private:
+    int computeInterval() const;
+    void scheduleNext(int intervalMs);
+    void rescheduleIfSooner();
+
+    QTimer *m_timer;            // 单次定时器，每次截图后按当前活动度重新设定
+    QTimer *m_inputPollTimer;   // 定期查询输入空闲时间
+    std::function<qint64()> m_inputIdleSource; // 输入空闲时间的来源
+    bool m_adaptive;            // 是否启用自适应
+    int m_fixedInterval;        // 固定间隔
+    int m_minInterval;          // 最小间隔
+    int m_maxInterval;          // 最大间隔
+    int m_switchDelay;          // 应用切换防抖延迟
+    double m_frameActivity;     // 画面变化活动度（指数滑动平均）
+    qint64 m_inputIdleMs;       // 最近一次上报的输入空闲时间
+};
+
+#endif // ADAPTIVESCHEDULER_H
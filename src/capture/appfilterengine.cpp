@@ -0,0 +1,256 @@
+#include "appfilterengine.h"
+#include <QDebug>
+
+namespace {
+
+const char *const kFieldPrefixes[AppFilterRule::FieldCount] = {
+    "name:",
+    "path:",
+    "title:"
+};
+
+// 路径统一用正斜杠，Windows 和规则中的写法都能匹配
+QString normalizeValue(const QString &value, int field)
+{
+    if (field == AppFilterRule::ExecutablePath) {
+        return QString(value).replace(QLatin1Char('\\'), QLatin1Char('/'));
+    }
+    return value;
+}
+
+// 通配符转换为整串匹配的正则表达式
+// 不用 QRegularExpression::wildcardToRegularExpression：它的 * 不跨越 '/'，不适合标题和路径前缀
+QString globToRegex(const QString &glob)
+{
+    QString regex = QStringLiteral("\\A");
+    for (const QChar &ch : glob) {
+        if (ch == QLatin1Char('*')) {
+            regex += QLatin1String(".*");
+        } else if (ch == QLatin1Char('?')) {
+            regex += QLatin1Char('.');
+        } else {
+            regex += QRegularExpression::escape(QString(ch));
+        }
+    }
+    return regex + QStringLiteral("\\z");
+}
+
+// 把规则转换为正则表达式片段
+QString rulePattern(const AppFilterRule &rule)
+{
+    if (rule.type == AppFilterRule::Glob) {
+        return globToRegex(normalizeValue(rule.pattern, rule.field));
+    }
+    // 正则规则按“包含”语义匹配，与常见的过滤写法一致
+    return rule.pattern;
+}
+
+} // namespace
+
+AppFilterRule AppFilterRule::fromString(const QString &text)
+{
+    AppFilterRule rule;
+    QString rest = text.trimmed();
+
+    if (rest.startsWith(QLatin1Char('+'))) {
+        rule.exclude = false;
+        rest = rest.mid(1);
+    } else if (rest.startsWith(QLatin1Char('-'))) {
+        rest = rest.mid(1);
+    }
+
+    for (int field = 0; field < FieldCount; ++field) {
+        QString prefix = QString::fromLatin1(kFieldPrefixes[field]);
+        if (rest.startsWith(prefix, Qt::CaseInsensitive)) {
+            rule.field = Field(field);
+            rest = rest.mid(prefix.size());
+            break;
+        }
+    }
+
+    if (rest.startsWith(QLatin1String("re:"), Qt::CaseInsensitive)) {
+        rule.type = Regex;
+        rest = rest.mid(3);
+    } else if (rest.startsWith(QLatin1String("glob:"), Qt::CaseInsensitive)) {
+        rule.type = Glob;
+        rest = rest.mid(5);
+    } else if (rest.contains(QLatin1Char('*')) || rest.contains(QLatin1Char('?'))) {
+        rule.type = Glob;
+    }
+
+    rule.pattern = rest;
+    return rule;
+}
+
+QString AppFilterRule::toString() const
+{
+    QString text;
+    if (!exclude) {
+        text += QLatin1Char('+');
+    }
+    if (field != ProcessName) {
+        text += QString::fromLatin1(kFieldPrefixes[field]);
+    }
+    if (type == Regex) {
+        text += QLatin1String("re:");
+    } else if (type == Glob && !pattern.contains(QLatin1Char('*')) && !pattern.contains(QLatin1Char('?'))) {
+        text += QLatin1String("glob:");
+    }
+    return text + pattern;
+}
+
+bool AppFilterRule::operator==(const AppFilterRule &other) const
+{
+    return field == other.field && type == other.type && exclude == other.exclude
+        && pattern.compare(other.pattern, Qt::CaseInsensitive) == 0;
+}
+
+std::shared_ptr<const CompiledAppFilter> CompiledAppFilter::compile(const QList<AppFilterRule> &rules,
+                                                                    QStringList *errors)
+{
+    std::shared_ptr<CompiledAppFilter> filter = std::make_shared<CompiledAppFilter>();
+    QStringList patterns[2][AppFilterRule::FieldCount];
+    QStringList separatePatterns[2][AppFilterRule::FieldCount];
+
+    for (const AppFilterRule &rule : rules) {
+        if (rule.pattern.isEmpty()) {
+            continue;
+        }
+
+        Matcher &matcher = rule.exclude ? filter->m_exclude[rule.field] : filter->m_include[rule.field];
+        if (rule.type == AppFilterRule::Exact) {
+            matcher.exact.insert(normalizeValue(rule.pattern, rule.field).toLower());
+        } else {
+            // 单独校验，避免一条无效规则让整个合并表达式失效
+            QString pattern = rulePattern(rule);
+            QRegularExpression check(pattern);
+            if (!check.isValid()) {
+                if (errors) {
+                    errors->append(QString("%1: %2").arg(rule.toString(), check.errorString()));
+                }
+                continue;
+            }
+            // 含捕获组的表达式（命名组、反向引用）合并后组号会错位或重名，单独匹配
+            if (check.captureCount() > 0) {
+                separatePatterns[rule.exclude ? 0 : 1][rule.field].append(pattern);
+            } else {
+                patterns[rule.exclude ? 0 : 1][rule.field].append(QString("(?:%1)").arg(pattern));
+            }
+        }
+
+        if (!rule.exclude) {
+            filter->m_hasInclude = true;
+        }
+        filter->m_ruleCount++;
+    }
+
+    const QRegularExpression::PatternOptions options = QRegularExpression::CaseInsensitiveOption
+        | QRegularExpression::UseUnicodePropertiesOption;
+    for (int direction = 0; direction < 2; ++direction) {
+        for (int field = 0; field < AppFilterRule::FieldCount; ++field) {
+            QStringList list = patterns[direction][field];
+            QStringList separate = separatePatterns[direction][field];
+            Matcher &matcher = direction == 0 ? filter->m_exclude[field] : filter->m_include[field];
+            if (!list.isEmpty()) {
+                matcher.combined = QRegularExpression(list.join(QLatin1Char('|')), options);
+                if (matcher.combined.isValid()) {
+                    matcher.combined.optimize();
+                } else {
+                    // 合并后无效时退回逐条匹配，不让一条规则使其它规则全部失效
+                    qDebug() << "合并的过滤表达式无效，改为逐条匹配:" << matcher.combined.errorString();
+                    matcher.combined = QRegularExpression();
+                    separate += list;
+                    list.clear();
+                }
+            }
+            for (const QString &pattern : separate) {
+                QRegularExpression expression(pattern, options);
+                expression.optimize();
+                matcher.separate.append(expression);
+            }
+            matcher.hasPatterns = !list.isEmpty() || !matcher.separate.isEmpty();
+        }
+    }
+
+    return filter;
+}
+
+bool CompiledAppFilter::Matcher::matches(const QString &value) const
+{
+    if (value.isEmpty()) {
+        return false;
+    }
+    if (!exact.isEmpty() && exact.contains(value.toLower())) {
+        return true;
+    }
+    if (!hasPatterns) {
+        return false;
+    }
+    if (!combined.pattern().isEmpty() && combined.match(value).hasMatch()) {
+        return true;
+    }
+    for (const QRegularExpression &expression : separate) {
+        if (expression.match(value).hasMatch()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CompiledAppFilter::shouldCapture(const AppFilterSubject &subject) const
+{
+    QString values[AppFilterRule::FieldCount] = {
+        subject.processName,
+        normalizeValue(subject.executablePath, AppFilterRule::ExecutablePath),
+        subject.windowTitle
+    };
+
+    if (m_hasInclude) {
+        for (int field = 0; field < AppFilterRule::FieldCount; ++field) {
+            if (m_include[field].matches(values[field])) {
+                return true;
+            }
+        }
+    }
+
+    for (int field = 0; field < AppFilterRule::FieldCount; ++field) {
+        if (m_exclude[field].matches(values[field])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int CompiledAppFilter::ruleCount() const
+{
+    return m_ruleCount;
+}
+
+AppFilterEngine::AppFilterEngine()
+    : m_compiled(CompiledAppFilter::compile(QList<AppFilterRule>()))
+{
+}
+
+QStringList AppFilterEngine::setRules(const QList<AppFilterRule> &rules)
+{
+    QStringList errors;
+    std::shared_ptr<const CompiledAppFilter> compiled = CompiledAppFilter::compile(rules, &errors);
+    m_rules = rules;
+    std::atomic_store(&m_compiled, compiled);
+
+    if (!errors.isEmpty()) {
+        qDebug() << "无效的过滤规则:" << errors;
+    }
+    return errors;
+}
+
+QList<AppFilterRule> AppFilterEngine::rules() const
+{
+    return m_rules;
+}
+
+bool AppFilterEngine::shouldCapture(const AppFilterSubject &subject) const
+{
+    std::shared_ptr<const CompiledAppFilter> compiled = std::atomic_load(&m_compiled);
+    return compiled->shouldCapture(subject);
+}
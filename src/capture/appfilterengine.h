@@ -0,0 +1,104 @@
+#ifndef APPFILTERENGINE_H
+#define APPFILTERENGINE_H
+
+#include <QList>
+#include <QRegularExpression>
+#include <QVector>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <memory>
+
+// 单条过滤规则
+// 文本形式：[+|-][name:|path:|title:][re:|glob:]模式
+//   +       包含规则（优先于排除规则），默认为排除
+//   name:   匹配进程名（默认），path: 匹配可执行文件路径，title: 匹配窗口标题
+//   re:     正则表达式；glob: 通配符；都不写时含 * 或 ? 视为通配符，否则精确匹配
+// 所有匹配均不区分大小写。例如 "explorer.exe"、"path:glob:C:/Windows/*"、"title:re:隐私|密码"、"+notepad.exe"
+struct AppFilterRule {
+    enum Field {
+        ProcessName = 0,
+        ExecutablePath,
+        WindowTitle,
+        FieldCount
+    };
+
+    enum MatchType {
+        Exact,
+        Glob,
+        Regex
+    };
+
+    Field field = ProcessName;
+    MatchType type = Exact;
+    QString pattern;
+    bool exclude = true;
+
+    // 文本形式互相转换
+    static AppFilterRule fromString(const QString &text);
+    QString toString() const;
+
+    bool operator==(const AppFilterRule &other) const;
+};
+
+// 待判断的应用
+struct AppFilterSubject {
+    QString processName;
+    QString executablePath;
+    QString windowTitle;
+};
+
+// 编译后的过滤器（不可变，可在多个线程中同时使用）
+// 每个字段的精确规则放入哈希集合，通配符和正则合并成一个带 JIT 的正则表达式，
+// 因此规则数量增长到数百条时，每次判断仍只是几次哈希查找和每字段一次正则匹配。
+class CompiledAppFilter
+{
+public:
+    // 编译规则，无效的正则会被跳过并写入 errors
+    static std::shared_ptr<const CompiledAppFilter> compile(const QList<AppFilterRule> &rules,
+                                                            QStringList *errors = nullptr);
+
+    // 包含规则命中时截图；否则排除规则命中时不截图；都未命中时截图
+    bool shouldCapture(const AppFilterSubject &subject) const;
+
+    int ruleCount() const;
+
+private:
+    // 同一字段、同一方向（排除或包含）的规则集合
+    struct Matcher {
+        QSet<QString> exact;             // 精确匹配（已转小写）
+        QRegularExpression combined;     // 通配符和正则合并后的表达式
+        QVector<QRegularExpression> separate; // 不能合并的表达式（含捕获组或合并后无效），逐条匹配
+        bool hasPatterns = false;
+
+        bool matches(const QString &value) const;
+    };
+
+    const QString &fieldValue(const AppFilterSubject &subject, int field) const;
+
+    Matcher m_exclude[AppFilterRule::FieldCount];
+    Matcher m_include[AppFilterRule::FieldCount];
+    bool m_hasInclude = false;
+    int m_ruleCount = 0;
+};
+
+// 应用过滤引擎
+// 规则修改时整体重新编译，再原子替换当前过滤器；判断时只读取一次指针，不加锁。
+class AppFilterEngine
+{
+public:
+    AppFilterEngine();
+
+    // 替换全部规则，返回编译错误（为空表示全部有效）
+    QStringList setRules(const QList<AppFilterRule> &rules);
+    QList<AppFilterRule> rules() const;
+
+    // 判断是否截图（线程安全）
+    bool shouldCapture(const AppFilterSubject &subject) const;
+
+private:
+    QList<AppFilterRule> m_rules;                        // 原始规则（只在 GUI 线程中修改）
+    std::shared_ptr<const CompiledAppFilter> m_compiled; // 当前过滤器，用 atomic_load/atomic_store 访问
+};
+
+#endif // APPFILTERENGINE_H
@@ -0,0 +1,102 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QWaitCondition>
+
+// 有界阻塞队列，用于连接流水线各阶段
+// 队列关闭后 push 失败，pop 在取完剩余元素后返回 false。
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(int capacity = 4)
+        : m_capacity(qMax(1, capacity))
+        , m_closed(false)
+    {
+    }
+
+    // 阻塞写入，队列满时等待；队列已关闭返回 false
+    bool push(const T &item)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_queue.size() >= m_capacity && !m_closed) {
+            m_notFull.wait(&m_mutex);
+        }
+        if (m_closed) {
+            return false;
+        }
+        m_queue.enqueue(item);
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    // 非阻塞写入，队列满或已关闭时返回 false
+    bool tryPush(const T &item)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_closed || m_queue.size() >= m_capacity) {
+            return false;
+        }
+        m_queue.enqueue(item);
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    // 阻塞读取，队列关闭且为空时返回 false
+    bool pop(T &item)
+    {
+        QMutexLocker locker(&m_mutex);
+        while (m_queue.isEmpty() && !m_closed) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_queue.isEmpty()) {
+            return false;
+        }
+        item = m_queue.dequeue();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    // 关闭队列，唤醒所有等待者
+    void close()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+    // 重新打开并清空队列
+    void reset(int capacity)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_capacity = qMax(1, capacity);
+        m_queue.clear();
+        m_closed = false;
+    }
+
+    int size() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_queue.size();
+    }
+
+    int capacity() const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_capacity;
+    }
+
+private:
+    mutable QMutex m_mutex;
+    QWaitCondition m_notEmpty;
+    QWaitCondition m_notFull;
+    QQueue<T> m_queue;
+    int m_capacity;
+    bool m_closed;
+};
+
+#endif // BOUNDEDQUEUE_H
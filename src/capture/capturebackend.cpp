@@ -0,0 +1,25 @@
+#include "capturebackend.h"
+
+#ifdef _WIN32
+#include "wincapturebackend.h"
+#elif defined(USE_X11_CAPTURE)
+#include "x11capturebackend.h"
+#endif
+
+CaptureBackend *CaptureBackend::create()
+{
+#ifdef _WIN32
+    return new WinCaptureBackend();
+#elif defined(USE_X11_CAPTURE)
+    return new X11CaptureBackend();
+#else
+    return nullptr;
+#endif
+}
+
+void CaptureBackend::prepareBuffer(QImage &buffer, const QSize &size)
+{
+    if (buffer.size() != size || buffer.format() != QImage::Format_RGB32) {
+        buffer = QImage(size, QImage::Format_RGB32);
+    }
+}
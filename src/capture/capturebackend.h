@@ -0,0 +1,55 @@
+#ifndef CAPTUREBACKEND_H
+#define CAPTUREBACKEND_H
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+
+// 平台无关的窗口句柄（Windows 下为 HWND，X11 下为 Window）
+typedef quintptr WindowHandle;
+
+// 截图后端接口
+// 负责查询前台窗口信息，并把屏幕内容抓取到调用方提供的缓冲区中。
+// 每个实例只应在同一时刻被一个线程使用。
+class CaptureBackend
+{
+public:
+    virtual ~CaptureBackend() {}
+
+    // 后端名称（用于日志）
+    virtual QString name() const = 0;
+
+    // 后端是否可用（例如无法连接 X 服务器时返回 false）
+    virtual bool isAvailable() const = 0;
+
+    // 当前激活窗口，失败返回 0
+    virtual WindowHandle activeWindow() = 0;
+
+    // 窗口在虚拟桌面坐标系下的矩形
+    virtual QRect windowRect(WindowHandle window) = 0;
+
+    // 窗口所属进程ID，失败返回 0
+    virtual qint64 windowProcessId(WindowHandle window) = 0;
+
+    // 窗口标题
+    virtual QString windowTitle(WindowHandle window) = 0;
+
+    // 进程可执行文件路径
+    virtual QString executablePath(qint64 processId) = 0;
+
+    // 距离最近一次用户输入（键盘或鼠标）的毫秒数，无法获取时返回 -1
+    virtual qint64 inputIdleTime() { return -1; }
+
+    // 抓取虚拟桌面上 rect 区域的内容到 buffer 中（Format_RGB32）
+    // buffer 尺寸和格式匹配时直接复用其内存，否则重新分配
+    virtual bool grab(const QRect &rect, QImage &buffer) = 0;
+
+    // 创建当前平台的默认后端，不支持的平台返回 nullptr
+    static CaptureBackend *create();
+
+protected:
+    // 确保 buffer 是 size 大小的 Format_RGB32 图像
+    static void prepareBuffer(QImage &buffer, const QSize &size);
+};
+
+#endif // CAPTUREBACKEND_H
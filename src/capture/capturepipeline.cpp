@@ -0,0 +1,531 @@
+#include "capturepipeline.h"
+#include "framekernels.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QScopedPointer>
+
+namespace {
+
+const char *const kStageNames[CapturePipeline::StageCount] = {
+    "capture",
+    "diff",
+    "commit"
+};
+
+// 段存储定期提交任务
+class SegmentSyncTask : public QRunnable
+{
+public:
+    explicit SegmentSyncTask(SegmentStore *store)
+        : m_store(store)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_store->sync();
+    }
+
+private:
+    SegmentStore *m_store;
+};
+
+} // namespace
+
+CapturePipeline::CapturePipeline(QObject *parent)
+    : QObject(parent)
+    , m_encoder(nullptr)
+    , m_segmentSyncTimer(nullptr)
+    , m_running(false)
+{
+    for (int stage = 0; stage < StageCount; ++stage) {
+        m_threads[stage] = nullptr;
+    }
+    m_clock.start();
+
+    m_encoder = new JpegEncoderPool(this);
+    connect(m_encoder, &JpegEncoderPool::encodeFinished, this,
+            [this](const QString &filePath, qint64 bytes, qint64) {
+                emit frameSaved(filePath, bytes);
+            });
+    connect(m_encoder, &JpegEncoderPool::encodeFailed, this,
+            [this](const QString &filePath, const QString &error) {
+                // 帧文件写入失败时标记为缺失，下次相同画面重新写入；
+                // 记录已经发出，它们持有的引用照常由持有者释放
+                QByteArray key = m_frameStore.keyForPath(filePath);
+                if (!key.isEmpty()) {
+                    m_frameStore.markMissing(key);
+                }
+                emit errorOccurred(error);
+            });
+    applyEncoderConfig(m_config);
+
+    // 截图停止一段时间后，批内剩余的记录也会按时提交
+    m_segmentSyncPool.setMaxThreadCount(1);
+    m_segmentSyncTimer = new QTimer(this);
+    m_segmentSyncTimer->setInterval(qMax(100, m_config.segmentSyncIntervalMs));
+    connect(m_segmentSyncTimer, &QTimer::timeout, this, [this]() {
+        if (m_segmentSyncPool.activeThreadCount() == 0) {
+            m_segmentSyncPool.start(new SegmentSyncTask(&m_segmentStore));
+        }
+    });
+}
+
+CapturePipeline::~CapturePipeline()
+{
+    stop();
+}
+
+void CapturePipeline::setConfig(const ScreenshotConfig &config)
+{
+    {
+        QMutexLocker locker(&m_configMutex);
+        m_config = config;
+    }
+    applyEncoderConfig(config);
+    applyStorageConfig(config);
+}
+
+void CapturePipeline::applyStorageConfig(const ScreenshotConfig &config)
+{
+    // 段的滚动和提交参数立即生效
+    m_segmentStore.setMaxSegmentBytes(config.segmentMaxBytes);
+    m_segmentStore.setMaxSegmentAgeMs(qint64(config.segmentMaxAgeMinutes) * 60 * 1000);
+    m_segmentStore.setSyncBatch(config.segmentSyncBatch, config.segmentSyncIntervalMs);
+    m_segmentSyncTimer->setInterval(qMax(100, config.segmentSyncIntervalMs));
+
+    // 运行中切换目录要等旧目录的写入积压完成，不在 GUI 线程中等待：
+    // 交给提交线程在处理下一帧之前切换（停止时补做），未运行时没有积压，直接切换
+    if (m_running) {
+        m_storagePending.store(true);
+        return;
+    }
+    m_storagePending.store(false);
+    switchStorage(config);
+}
+
+void CapturePipeline::applyPendingStorage()
+{
+    if (m_storagePending.exchange(false)) {
+        switchStorage(getConfig());
+    }
+}
+
+void CapturePipeline::switchStorage(const ScreenshotConfig &config)
+{
+    // 段存储：保存路径变化时切换目录（关闭时会提交未落盘的记录）
+    if (config.autoSave && config.saveFormat == SaveFormat::Segments) {
+        QString rootPath = QDir(QDir(config.savePath).filePath("segments")).absolutePath();
+        if (m_segmentStore.rootPath() != rootPath && !m_segmentStore.open(rootPath)) {
+            emit errorOccurred("Failed to open segment store: " + rootPath);
+        }
+    }
+
+    // 保存路径变化时切换帧存储，先保存旧目录的引用计数
+    if (config.autoSave && config.saveFormat == SaveFormat::Frames && config.deduplicateFrames) {
+        QString rootPath = QDir(QDir(config.savePath).filePath("frames")).absolutePath();
+        if (m_frameStore.rootPath() != rootPath) {
+            if (m_frameStore.isDirty()) {
+                // 旧目录中排队的帧文件写完后再保存引用计数（运行中时在提交线程中等待）
+                m_encoder->waitForDone();
+                m_frameStore.save();
+            }
+            if (m_frameStore.open(rootPath)) {
+                emit frameStoreOpened(rootPath);
+            } else {
+                emit errorOccurred("Failed to open frame store: " + rootPath);
+            }
+        }
+    }
+}
+
+void CapturePipeline::applyEncoderConfig(const ScreenshotConfig &config)
+{
+    m_encoder->setThreadCount(config.encoderThreads);
+    m_encoder->setMaxBacklog(config.encoderBacklog);
+    m_encoder->setPolicy(config.encoderPolicy);
+}
+
+ScreenshotConfig CapturePipeline::getConfig() const
+{
+    QMutexLocker locker(&m_configMutex);
+    return m_config;
+}
+
+void CapturePipeline::start()
+{
+    if (m_running) {
+        return;
+    }
+
+    int queueSize = getConfig().pipelineQueueSize;
+    for (int stage = 0; stage < StageCount; ++stage) {
+        m_queues[stage].reset(queueSize);
+    }
+
+    m_threads[CaptureStage] = new StageThread(this, &CapturePipeline::captureLoop);
+    m_threads[DiffStage] = new StageThread(this, &CapturePipeline::diffLoop);
+    m_threads[CommitStage] = new StageThread(this, &CapturePipeline::commitLoop);
+
+    for (int stage = 0; stage < StageCount; ++stage) {
+        m_threads[stage]->setObjectName(QString("CapturePipeline-%1").arg(kStageNames[stage]));
+        m_threads[stage]->start();
+    }
+
+    m_segmentSyncTimer->start();
+    m_running = true;
+    qDebug() << "截图流水线已启动，队列容量:" << queueSize;
+}
+
+void CapturePipeline::stop()
+{
+    if (!m_running) {
+        return;
+    }
+
+    // 关闭入口队列后，各阶段处理完剩余帧再依次关闭下游队列
+    m_queues[CaptureStage].close();
+    for (int stage = 0; stage < StageCount; ++stage) {
+        m_threads[stage]->wait();
+        delete m_threads[stage];
+        m_threads[stage] = nullptr;
+    }
+    m_encoder->waitForDone();
+    m_segmentSyncTimer->stop();
+    m_segmentSyncPool.waitForDone();
+    m_segmentStore.sync();
+    applyPendingStorage();
+
+    m_running = false;
+    qDebug() << "截图流水线已停止";
+}
+
+bool CapturePipeline::isRunning() const
+{
+    return m_running;
+}
+
+bool CapturePipeline::submit(const CaptureRequest &request)
+{
+    if (!m_running) {
+        return false;
+    }
+
+    PipelineFrame frame;
+    frame.request = request;
+    frame.enqueuedAt = nowNs();
+
+    // GUI 线程不能阻塞：采集跟不上时直接丢弃本次请求
+    if (!m_queues[CaptureStage].tryPush(frame)) {
+        recordDrop(CaptureStage);
+        return false;
+    }
+    return true;
+}
+
+QList<PipelineStageStats> CapturePipeline::getStats() const
+{
+    QList<PipelineStageStats> result;
+    for (int stage = 0; stage < StageCount; ++stage) {
+        const StageCounters &counters = m_counters[stage];
+        PipelineStageStats stats;
+        stats.name = kStageNames[stage];
+        stats.queueDepth = m_queues[stage].size();
+        stats.queueCapacity = m_queues[stage].capacity();
+        stats.processed = counters.processed.load();
+        stats.dropped = counters.dropped.load();
+        if (stats.processed > 0) {
+            stats.avgWaitMs = counters.totalWaitNs.load() / 1e6 / stats.processed;
+            stats.avgLatencyMs = counters.totalLatencyNs.load() / 1e6 / stats.processed;
+        }
+        stats.maxLatencyMs = counters.maxLatencyNs.load() / 1e6;
+        result.append(stats);
+    }
+
+    // 编码阶段：线程池中的 JPEG 压缩，在途数量由提交队列限制
+    PipelineStageStats encodeStats;
+    encodeStats.name = "encode";
+    encodeStats.queueDepth = m_encoder->pendingEncodes();
+    encodeStats.queueCapacity = m_queues[CommitStage].capacity();
+    encodeStats.processed = m_encoder->encodedCount();
+    encodeStats.avgLatencyMs = m_encoder->averageJpegEncodeMs();
+    encodeStats.maxLatencyMs = m_encoder->maxJpegEncodeMs();
+    result.append(encodeStats);
+
+    // 写入阶段：队列即编码线程池的文件任务积压（压缩失败的帧在这里重新编码）
+    PipelineStageStats writeStats;
+    writeStats.name = "write";
+    writeStats.queueDepth = m_encoder->backlog();
+    writeStats.queueCapacity = m_encoder->maxBacklog();
+    writeStats.processed = m_encoder->completedCount() + m_encoder->failedCount();
+    writeStats.dropped = m_encoder->droppedCount() + m_encoder->failedCount();
+    writeStats.avgLatencyMs = m_encoder->averageEncodeMs();
+    writeStats.maxLatencyMs = m_encoder->maxEncodeMs();
+    result.append(writeStats);
+    return result;
+}
+
+FramePoolStats CapturePipeline::framePoolStats() const
+{
+    return m_framePool.stats();
+}
+
+void CapturePipeline::setScreens(const QList<QRect> &screens)
+{
+    m_multiScreen.setScreens(screens);
+    m_framePool.setScreens(screens);
+}
+
+MultiScreenCapture *CapturePipeline::multiScreenCapture()
+{
+    return &m_multiScreen;
+}
+
+FrameStore *CapturePipeline::frameStore()
+{
+    return &m_frameStore;
+}
+
+SegmentStore *CapturePipeline::segmentStore()
+{
+    return &m_segmentStore;
+}
+
+void CapturePipeline::captureLoop()
+{
+    // 后端在本线程内创建和销毁，X11 连接不跨线程共享；截图本身交给多屏截图
+    QScopedPointer<CaptureBackend> backend(CaptureBackend::create());
+    if (backend && !backend->isAvailable()) {
+        backend.reset();
+    }
+
+    PipelineFrame frame;
+    while (m_queues[CaptureStage].pop(frame)) {
+        recordWait(CaptureStage, frame);
+        qint64 start = nowNs();
+
+        // 截图直接写入池中的缓冲区，随帧交给下游；最后一个持有者释放后回到池中
+        QRect rect = backend ? backend->windowRect(frame.request.window) : QRect();
+        frame.image = m_framePool.acquire(rect.size());
+        if (rect.isEmpty() || !m_multiScreen.grabRegion(rect, frame.image)) {
+            frame.image = QImage();
+            recordLatency(CaptureStage, start);
+            recordDrop(CaptureStage);
+            emit errorOccurred("Failed to capture screenshot");
+            continue;
+        }
+        recordLatency(CaptureStage, start);
+
+        frame.enqueuedAt = nowNs();
+        if (!m_queues[DiffStage].push(frame)) {
+            break;
+        }
+    }
+
+    m_queues[DiffStage].close();
+}
+
+void CapturePipeline::diffLoop()
+{
+    ChangeDetector detector;
+    quint64 referenceHash = 0;    // 上一条独立保存截图的记录的感知哈希，近似重复与它比较
+    QString referenceApp;
+    bool hasReference = false;
+    PipelineFrame frame;
+    while (m_queues[DiffStage].pop(frame)) {
+        recordWait(DiffStage, frame);
+        qint64 start = nowNs();
+        ScreenshotConfig config = getConfig();
+        bool saveFrames = config.autoSave && config.saveFormat == SaveFormat::Frames;
+        bool saveSegments = config.autoSave && config.saveFormat == SaveFormat::Segments;
+        bool hashFrames = config.deduplicateFrames
+            && ((saveFrames && m_frameStore.isOpen()) || (saveSegments && m_segmentStore.isOpen()));
+
+        // 画面未变化（或变化低于阈值）时跳过记录、编码和保存
+        if (config.skipUnchanged) {
+            detector.setTileSize(config.changeTileSize);
+            detector.setThreshold(config.changeThreshold);
+            frame.change = detector.detect(frame.image);
+            if (!frame.change.changed) {
+                recordLatency(DiffStage, start);
+                recordDrop(DiffStage);
+                emit frameUnchanged(frame.request.appName);
+                continue;
+            }
+        }
+
+        // 感知哈希：光标闪烁、时钟跳动这类微小变化通过了精确比较，但与参考帧的汉明距离很小。
+        // 参考帧只在独立保存截图时更新，缓慢累积的变化最终会超过阈值
+        frame.perceptualHash = FrameKernels::differenceHash(frame.image.constBits(), frame.image.bytesPerLine(),
+                                                            frame.image.width(), frame.image.height());
+        frame.nearDuplicate = hasReference
+            && config.nearDuplicatePolicy != NearDuplicatePolicy::Keep
+            && referenceApp == frame.request.appName
+            && FrameKernels::hammingDistance(frame.perceptualHash, referenceHash) <= config.nearDuplicateDistance;
+        if (frame.nearDuplicate && config.nearDuplicatePolicy == NearDuplicatePolicy::Suppress) {
+            recordLatency(DiffStage, start);
+            recordDrop(DiffStage);
+            emit frameUnchanged(frame.request.appName);
+            continue;
+        }
+
+        // 独立保存的帧交给编码线程池压缩，本线程继续处理下一帧；合并的帧沿用参考帧的数据
+        if (!frame.nearDuplicate) {
+            frame.encoded = m_encoder->encodeAsync(frame.image, config.imageQuality);
+            if (hashFrames) {
+                frame.frameKey = FrameStore::hashImage(frame.image);
+            }
+            referenceHash = frame.perceptualHash;
+            referenceApp = frame.request.appName;
+            hasReference = true;
+        }
+        recordLatency(DiffStage, start);
+
+        frame.enqueuedAt = nowNs();
+        if (!m_queues[CommitStage].push(frame)) {
+            break;
+        }
+    }
+
+    m_queues[CommitStage].close();
+}
+
+void CapturePipeline::commitLoop()
+{
+    AppRecord reference;          // 上一条独立保存截图的记录，合并的记录沿用它的压缩数据和帧键
+    PipelineFrame frame;
+    while (m_queues[CommitStage].pop(frame)) {
+        recordWait(CommitStage, frame);
+        qint64 start = nowNs();
+        applyPendingStorage();
+        ScreenshotConfig config = getConfig();
+        // 时间线格式由 ScreenMonitor 的时间线编码器保存，这里只写单帧文件或段存储
+        bool saveFrames = config.autoSave && config.saveFormat == SaveFormat::Frames;
+        bool saveSegments = config.autoSave && config.saveFormat == SaveFormat::Segments;
+
+        AppRecord record;
+        record.appName = frame.request.appName;
+        record.timestamp = frame.request.requestTime;
+        record.screenshot = frame.image;
+        record.appPath = frame.request.appPath;
+        record.windowTitle = frame.request.windowTitle;
+        if (frame.nearDuplicate) {
+            // 合并：沿用参考帧的截图、压缩数据和帧键，不重新编码。
+            // 截图也换成参考帧，内存缓存、时间线和存储、导出看到的是同一幅画面
+            record.screenshot = reference.screenshot;
+            record.encodedScreenshot = reference.encodedScreenshot;
+            record.frameKey = reference.frameKey;
+            record.perceptualHash = reference.perceptualHash;
+        } else {
+            // 按截图顺序等待压缩结果，压缩本身已在线程池中与后续帧并行进行
+            record.encodedScreenshot = frame.encoded.valid() ? frame.encoded.get() : QByteArray();
+            record.perceptualHash = frame.perceptualHash;
+            record.frameKey = frame.frameKey;
+        }
+
+        // 先保存再通知，记录中带上截图在段存储中的位置，ScreenMonitor 据此写入记录索引
+        if (frame.nearDuplicate) {
+            // 合并的记录只引用已保存的帧（段存储中写入引用记录）
+            if (saveFrames && !record.frameKey.isEmpty()) {
+                if (!m_frameStore.addRef(record.frameKey)) {
+                    record.frameKey.clear();
+                }
+            } else if (saveSegments) {
+                appendSegment(record);
+            }
+        } else {
+            if (saveFrames) {
+                saveFrame(record, frame, config);
+            } else if (saveSegments) {
+                appendSegment(record);
+            }
+
+            // 参考帧的截图一直保留到下一次独立保存（只多占用一个帧缓冲区）
+            reference = record;
+        }
+        recordLatency(CommitStage, start);
+
+        emit frameAccepted(record, frame.change);
+    }
+}
+
+void CapturePipeline::appendSegment(AppRecord &record)
+{
+    // 在提交线程中按截图顺序追加，写入只进页缓存，每批记录才有一次 fsync
+    SegmentEntry entry;
+    if (!m_segmentStore.append(record.timestamp.toMSecsSinceEpoch(), record.appName,
+                               record.frameKey, record.encodedScreenshot, &entry)) {
+        emit errorOccurred("Failed to append screenshot to segment store: " + record.appName);
+        return;
+    }
+    record.frameRef.segment = entry.dataSegment;
+    record.frameRef.offset = entry.dataOffset;
+    record.frameRef.length = entry.dataLength;
+}
+
+void CapturePipeline::saveFrame(AppRecord &record, const PipelineFrame &frame, const ScreenshotConfig &config)
+{
+    QString filePath;
+    if (!record.frameKey.isEmpty()) {
+        // 相同画面已在帧存储中，只增加引用计数，不再写盘
+        if (m_frameStore.acquire(record.frameKey, record.encodedScreenshot.size()) == FrameStore::AlreadyStored) {
+            return;
+        }
+        filePath = m_frameStore.blobPath(record.frameKey);
+        QDir().mkpath(QFileInfo(filePath).absolutePath());
+    } else {
+        filePath = buildFilePath(frame, config);
+    }
+
+    // 压缩数据已有，编码线程池只需写盘；按配置的积压策略，满时丢弃本次保存或等待空位
+    bool queued = record.encodedScreenshot.isEmpty()
+        ? m_encoder->submit(frame.image, filePath, config.imageQuality)
+        : m_encoder->submitEncoded(record.encodedScreenshot, filePath);
+    if (!queued) {
+        qDebug() << "编码积压已满，跳过保存:" << frame.request.appName;
+        if (!record.frameKey.isEmpty()) {
+            // 撤销本条记录的引用，记录不再指向帧存储
+            m_frameStore.abortWrite(record.frameKey);
+            record.frameKey.clear();
+        }
+    }
+}
+
+void CapturePipeline::recordWait(Stage stage, const PipelineFrame &frame)
+{
+    m_counters[stage].totalWaitNs += quint64(qMax<qint64>(0, nowNs() - frame.enqueuedAt));
+}
+
+void CapturePipeline::recordLatency(Stage stage, qint64 startNs)
+{
+    StageCounters &counters = m_counters[stage];
+    quint64 latency = quint64(qMax<qint64>(0, nowNs() - startNs));
+    counters.processed++;
+    counters.totalLatencyNs += latency;
+
+    quint64 currentMax = counters.maxLatencyNs.load();
+    while (latency > currentMax && !counters.maxLatencyNs.compare_exchange_weak(currentMax, latency)) {
+    }
+}
+
+void CapturePipeline::recordDrop(Stage stage)
+{
+    m_counters[stage].dropped++;
+}
+
+qint64 CapturePipeline::nowNs() const
+{
+    return m_clock.nsecsElapsed();
+}
+
+QString CapturePipeline::buildFilePath(const PipelineFrame &frame, const ScreenshotConfig &config) const
+{
+    // 生成文件名
+    QString timestamp = frame.request.requestTime.toString("yyyyMMdd_hhmmss");
+    QString fileName = QString("%1_%2.jpg").arg(frame.request.appName).arg(timestamp);
+    return QDir(config.savePath).filePath(fileName);
+}
@@ -0,0 +1,191 @@
+#ifndef CAPTUREPIPELINE_H
+#define CAPTUREPIPELINE_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QByteArray>
+#include <QList>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <future>
+#include "../common.h"
+#include "boundedqueue.h"
+#include "capturebackend.h"
+#include "changedetector.h"
+#include "framepool.h"
+#include "multiscreencapture.h"
+#include "../storage/framestore.h"
+#include "../storage/jpegencoderpool.h"
+#include "../storage/segmentstore.h"
+
+// 截图请求（GUI 线程 -> 采集阶段）
+struct CaptureRequest {
+    WindowHandle window = 0;   // 要截取的窗口
+    QString appName;           // 应用名
+    QString appPath;           // 可执行文件路径
+    QString windowTitle;       // 窗口标题
+    QDateTime requestTime;     // 请求时间
+};
+
+// 在流水线中流动的帧
+struct PipelineFrame {
+    CaptureRequest request;    // 原始请求
+    QImage image;              // 截图（Format_RGB32）
+    ChangeResult change;       // 变化检测结果
+    qint64 enqueuedAt = 0;     // 进入当前队列的时间（纳秒，流水线时钟）
+
+    // 变化检测阶段的结论，提交阶段据此生成记录
+    quint64 perceptualHash = 0;               // 感知哈希
+    bool nearDuplicate = false;               // 与参考帧近似重复，合并到参考帧
+    QByteArray frameKey;                      // 像素哈希（启用去重时）
+    std::shared_future<QByteArray> encoded;   // 编码线程池中的 JPEG 压缩结果
+};
+
+// 单个阶段的统计
+struct PipelineStageStats {
+    QString name;              // 阶段名称
+    int queueDepth = 0;        // 输入队列当前深度
+    int queueCapacity = 0;     // 输入队列容量
+    quint64 processed = 0;     // 已处理数量
+    quint64 dropped = 0;       // 丢弃数量（队列满或画面未变化）
+    double avgWaitMs = 0.0;    // 平均排队时间
+    double avgLatencyMs = 0.0; // 平均处理时间
+    double maxLatencyMs = 0.0; // 最大处理时间
+};
+
+// 截图流水线：采集 -> 变化检测 -> 提交（生成记录并保存）
+// 采集阶段把截图写入帧缓冲池中的缓冲区，记录和各接收方释放截图后缓冲区回到池中复用。
+// 三个阶段各自运行在独立的工作线程上，阶段之间用有界队列连接；
+// 变化检测阶段把通过的帧交给 JpegEncoderPool 在线程池中压缩为 JPEG（内存历史和磁盘
+// 共用同一份数据），提交阶段按截图顺序等待压缩结果，写入存储后发出记录。
+// 文件写入同样在线程池中完成。启用去重时按像素哈希写入帧存储，已存在的画面只增加引用计数。
+// GUI 线程只负责投递请求和接收轻量的完成通知；运行中切换保存路径时，
+// 存储的切换（等待旧目录的写入完成、保存引用计数、打开新目录）也交给提交线程执行。
+class CapturePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 阶段编号（编码和文件写入由编码线程池实现，不在此列）
+    enum Stage {
+        CaptureStage = 0,
+        DiffStage,
+        CommitStage,
+        StageCount
+    };
+
+    explicit CapturePipeline(QObject *parent = nullptr);
+    ~CapturePipeline();
+
+    // 配置（线程安全）
+    void setConfig(const ScreenshotConfig &config);
+    ScreenshotConfig getConfig() const;
+
+    // 控制
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    // 投递截图请求（非阻塞，采集队列已满时丢弃并返回 false）
+    bool submit(const CaptureRequest &request);
+
+    // 各阶段统计
+    QList<PipelineStageStats> getStats() const;
+
+    // 帧缓冲池统计（分配次数、复用率）
+    FramePoolStats framePoolStats() const;
+
+    // 显示器布局（虚拟桌面物理像素坐标），窗口跨屏时按屏并行抓取
+    void setScreens(const QList<QRect> &screens);
+    MultiScreenCapture *multiScreenCapture();
+
+    // 内容寻址的帧存储（位于保存路径下的 frames 目录）
+    FrameStore *frameStore();
+
+    // 段存储（位于保存路径下的 segments 目录）
+    SegmentStore *segmentStore();
+
+signals:
+    // 帧通过变化检测，已生成记录
+    void frameAccepted(const AppRecord &record, const ChangeResult &change);
+
+    // 帧与上一次记录的画面相比没有变化，已跳过
+    void frameUnchanged(const QString &appName);
+
+    // 帧已保存到磁盘
+    void frameSaved(const QString &filePath, qint64 bytes);
+
+    // 帧存储已打开（启动或切换保存路径后），持久化引用需要与记录索引对齐
+    void frameStoreOpened(const QString &rootPath);
+
+    // 错误信号
+    void errorOccurred(const QString &error);
+
+private:
+    // 阶段工作线程
+    class StageThread : public QThread
+    {
+    public:
+        StageThread(CapturePipeline *pipeline, void (CapturePipeline::*loop)())
+            : m_pipeline(pipeline), m_loop(loop) {}
+
+    protected:
+        void run() override { (m_pipeline->*m_loop)(); }
+
+    private:
+        CapturePipeline *m_pipeline;
+        void (CapturePipeline::*m_loop)();
+    };
+
+    // 阶段计数器（工作线程写，GUI 线程读）
+    struct StageCounters {
+        std::atomic<quint64> processed{0};
+        std::atomic<quint64> dropped{0};
+        std::atomic<quint64> totalWaitNs{0};
+        std::atomic<quint64> totalLatencyNs{0};
+        std::atomic<quint64> maxLatencyNs{0};
+    };
+
+    // 各阶段主循环
+    void captureLoop();
+    void diffLoop();
+    void commitLoop();
+
+    // 出队后记录排队时间，处理完成后记录处理时间
+    void recordWait(Stage stage, const PipelineFrame &frame);
+    void recordLatency(Stage stage, qint64 startNs);
+    void recordDrop(Stage stage);
+    qint64 nowNs() const;
+
+    QString buildFilePath(const PipelineFrame &frame, const ScreenshotConfig &config) const;
+    void applyEncoderConfig(const ScreenshotConfig &config);
+    void applyStorageConfig(const ScreenshotConfig &config);
+    void switchStorage(const ScreenshotConfig &config);
+    void applyPendingStorage();
+    void saveFrame(AppRecord &record, const PipelineFrame &frame, const ScreenshotConfig &config);
+    void appendSegment(AppRecord &record);
+
+    QElapsedTimer m_clock;                 // 流水线时钟（用于统计排队和处理时间）
+    mutable QMutex m_configMutex;          // 保护 m_config
+    ScreenshotConfig m_config;             // 配置
+
+    BoundedQueue<PipelineFrame> m_queues[StageCount]; // 各阶段输入队列
+    StageThread *m_threads[StageCount];               // 各阶段线程
+    StageCounters m_counters[StageCount];             // 各阶段计数器
+    JpegEncoderPool *m_encoder;                       // 编码线程池（编码并原子写入）
+    MultiScreenCapture m_multiScreen;                 // 多屏截图
+    FramePool m_framePool;                            // 截图帧缓冲池
+    FrameStore m_frameStore;                          // 去重后的帧存储
+    SegmentStore m_segmentStore;                      // 段存储
+    QTimer *m_segmentSyncTimer;                       // 定期提交段存储中停留的记录
+    QThreadPool m_segmentSyncPool;                    // 执行定期提交（fsync 不阻塞 GUI 线程）
+
+    bool m_running;                        // 是否运行中
+    std::atomic<bool> m_storagePending{false}; // 存储配置已变化，等提交线程在下一帧之前切换
+};
+
+#endif // CAPTUREPIPELINE_H
@@ -0,0 +1,120 @@
+#include "changedetector.h"
+#include "framekernels.h"
+#include <QtGlobal>
+
+double ChangeResult::changedRatio() const
+{
+    if (totalTiles <= 0) {
+        return 1.0;
+    }
+
+    return double(dirtyTiles.size()) / double(totalTiles);
+}
+
+QRect ChangeResult::tileRect(int index, const QSize &frameSize) const
+{
+    if (tileSize <= 0 || gridSize.width() <= 0) {
+        return QRect();
+    }
+
+    int column = index % gridSize.width();
+    int row = index / gridSize.width();
+    QRect rect(column * tileSize, row * tileSize, tileSize, tileSize);
+    return rect.intersected(QRect(QPoint(0, 0), frameSize));
+}
+
+ChangeDetector::ChangeDetector(int tileSize, double threshold)
+    : m_tileSize(qMax(8, tileSize))
+    , m_threshold(qBound(0.0, threshold, 1.0))
+{
+}
+
+void ChangeDetector::setTileSize(int tileSize)
+{
+    tileSize = qMax(8, tileSize);
+    if (tileSize != m_tileSize) {
+        m_tileSize = tileSize;
+        reset();
+    }
+}
+
+int ChangeDetector::tileSize() const
+{
+    return m_tileSize;
+}
+
+void ChangeDetector::setThreshold(double threshold)
+{
+    m_threshold = qBound(0.0, threshold, 1.0);
+}
+
+double ChangeDetector::threshold() const
+{
+    return m_threshold;
+}
+
+void ChangeDetector::reset()
+{
+    m_frameSize = QSize();
+    m_tileHashes.clear();
+}
+
+ChangeResult ChangeDetector::detect(const QImage &frame)
+{
+    ChangeResult result;
+    result.tileSize = m_tileSize;
+
+    if (frame.isNull()) {
+        result.changed = false;
+        result.fullFrame = false;
+        return result;
+    }
+
+    // 内核只处理 32 位像素
+    if (frame.depth() != 32) {
+        return detect(frame.convertToFormat(QImage::Format_RGB32));
+    }
+
+    int columns = (frame.width() + m_tileSize - 1) / m_tileSize;
+    int rows = (frame.height() + m_tileSize - 1) / m_tileSize;
+    result.gridSize = QSize(columns, rows);
+    result.totalTiles = columns * rows;
+
+    QVector<quint64> hashes(result.totalTiles);
+    for (int index = 0; index < result.totalTiles; ++index) {
+        hashes[index] = hashTile(frame, result.tileRect(index, frame.size()));
+    }
+
+    // 首帧或尺寸变化：整帧视为变化
+    if (frame.size() != m_frameSize || m_tileHashes.size() != hashes.size()) {
+        result.fullFrame = true;
+        result.changed = true;
+        result.dirtyTiles.reserve(result.totalTiles);
+        for (int index = 0; index < result.totalTiles; ++index) {
+            result.dirtyTiles.append(index);
+        }
+        m_frameSize = frame.size();
+        m_tileHashes = hashes;
+        return result;
+    }
+
+    result.fullFrame = false;
+    for (int index = 0; index < result.totalTiles; ++index) {
+        if (hashes[index] != m_tileHashes[index]) {
+            result.dirtyTiles.append(index);
+        }
+    }
+
+    result.changed = !result.dirtyTiles.isEmpty() && result.changedRatio() >= m_threshold;
+    if (result.changed) {
+        m_tileHashes = hashes;
+    }
+
+    return result;
+}
+
+quint64 ChangeDetector::hashTile(const QImage &frame, const QRect &rect) const
+{
+    const uchar *origin = frame.constScanLine(rect.top()) + rect.left() * 4;
+    return FrameKernels::hashTile(origin, frame.bytesPerLine(), rect.width(), rect.height());
+}
@@ -0,0 +1,57 @@
+#ifndef CHANGEDETECTOR_H
+#define CHANGEDETECTOR_H
+
+#include <QImage>
+#include <QMetaType>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+
+// 单帧变化检测结果
+struct ChangeResult {
+    bool changed = true;           // 是否视为发生变化（超过阈值）
+    bool fullFrame = true;         // 是否为整帧变化（首帧或尺寸变化）
+    int tileSize = 0;              // 图块边长（像素）
+    QSize gridSize;                // 图块网格（列数 x 行数）
+    int totalTiles = 0;            // 图块总数
+    QVector<int> dirtyTiles;       // 变化图块索引（行优先）
+
+    // 变化图块占比
+    double changedRatio() const;
+
+    // 图块索引对应的帧内矩形（边缘图块会被裁剪）
+    QRect tileRect(int index, const QSize &frameSize) const;
+};
+
+Q_DECLARE_METATYPE(ChangeResult)
+
+// 基于图块哈希的变化检测器
+// 把帧切成固定大小的图块并逐块哈希，与上一次被接受的帧比较。
+// 变化低于阈值的帧不会更新参考状态，避免缓慢的累积变化永远达不到阈值。
+class ChangeDetector
+{
+public:
+    explicit ChangeDetector(int tileSize = 64, double threshold = 0.0);
+
+    // 配置
+    void setTileSize(int tileSize);
+    int tileSize() const;
+    void setThreshold(double threshold);
+    double threshold() const;
+
+    // 检测帧变化，帧被接受时更新参考状态
+    ChangeResult detect(const QImage &frame);
+
+    // 清除参考状态，下一帧视为整帧变化
+    void reset();
+
+private:
+    quint64 hashTile(const QImage &frame, const QRect &rect) const;
+
+    int m_tileSize;                  // 图块边长
+    double m_threshold;              // 变化阈值（变化图块占比，0 表示任意变化）
+    QSize m_frameSize;               // 参考帧尺寸
+    QVector<quint64> m_tileHashes;   // 参考帧的图块哈希
+};
+
+#endif // CHANGEDETECTOR_H
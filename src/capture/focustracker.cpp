@@ -0,0 +1,19 @@
+#include "focustracker.h"
+
+#ifdef _WIN32
+#include "winfocustracker.h"
+#elif defined(USE_X11_CAPTURE)
+#include "x11focustracker.h"
+#endif
+
+FocusTracker *FocusTracker::create(QObject *parent)
+{
+#ifdef _WIN32
+    return new WinFocusTracker(parent);
+#elif defined(USE_X11_CAPTURE)
+    return new X11FocusTracker(parent);
+#else
+    Q_UNUSED(parent);
+    return nullptr;
+#endif
+}
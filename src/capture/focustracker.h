@@ -0,0 +1,34 @@
+#ifndef FOCUSTRACKER_H
+#define FOCUSTRACKER_H
+
+#include <QObject>
+
+// 前台窗口变化监听
+// 由窗口系统主动通知焦点切换，取代定时轮询：切换应用后几毫秒内即可响应，
+// 没有切换时不会产生任何唤醒。必须在 GUI 线程中创建和使用。
+class FocusTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FocusTracker(QObject *parent = nullptr) : QObject(parent) {}
+    virtual ~FocusTracker() {}
+
+    // 开始监听，平台不支持或初始化失败时返回 false（调用方应退回轮询）
+    virtual bool start() = 0;
+
+    // 停止监听
+    virtual void stop() = 0;
+
+    // 是否正在监听
+    virtual bool isActive() const = 0;
+
+    // 创建当前平台的监听器，不支持的平台返回 nullptr
+    static FocusTracker *create(QObject *parent = nullptr);
+
+signals:
+    // 前台窗口已变化（同一批事件只通知一次）
+    void activeWindowChanged();
+};
+
+#endif // FOCUSTRACKER_H
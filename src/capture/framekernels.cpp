@@ -0,0 +1,260 @@
+#include "framekernels.h"
+#include "framekernels_p.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#if defined(FRAMEKERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace FrameKernels {
+namespace detail {
+
+namespace {
+
+uint64_t scalarHashTile(const uint8_t *data, int stride, int width, int height)
+{
+    uint32_t lanes[kLaneCount];
+    for (int lane = 0; lane < kLaneCount; ++lane) {
+        lanes[lane] = laneSeed(lane);
+    }
+
+    for (int y = 0; y < height; ++y) {
+        hashRowTail(lanes, data + y * stride, 0, width);
+    }
+
+    return finalizeHash(lanes, width, height);
+}
+
+bool scalarTilesEqual(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height)
+{
+    size_t rowBytes = size_t(width) * 4;
+    for (int y = 0; y < height; ++y) {
+        if (std::memcmp(a + y * strideA, b + y * strideB, rowBytes) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int64_t scalarCountChangedPixels(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height)
+{
+    int64_t changed = 0;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *rowA = a + y * strideA;
+        const uint8_t *rowB = b + y * strideB;
+        for (int x = 0; x < width; ++x) {
+            changed += loadPixel(rowA + x * 4) != loadPixel(rowB + x * 4);
+        }
+    }
+    return changed;
+}
+
+void scalarAccumulateLuma(const uint8_t *row, int width, uint32_t *sums)
+{
+    accumulateLumaTail(row, 0, width, sums);
+}
+
+} // namespace
+
+const KernelTable scalarKernels = {
+    scalarHashTile,
+    scalarTilesEqual,
+    scalarCountChangedPixels,
+    scalarAccumulateLuma
+};
+
+} // namespace detail
+
+namespace {
+
+bool cpuSupports(Isa isa)
+{
+    if (isa == Isa::Scalar) {
+        return true;
+    }
+
+#if defined(FRAMEKERNELS_X86) && defined(_MSC_VER)
+    int info[4] = {0};
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse42 = (info[2] & (1 << 20)) != 0;
+    if (isa == Isa::SSE42) {
+        return sse42;
+    }
+
+    // AVX2 还需要操作系统保存 YMM 寄存器（OSXSAVE + XCR0）
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7) {
+        return false;
+    }
+    if ((_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(FRAMEKERNELS_X86)
+    __builtin_cpu_init();
+    if (isa == Isa::SSE42) {
+        return __builtin_cpu_supports("sse4.2");
+    }
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+const detail::KernelTable *tableFor(Isa isa)
+{
+#ifdef FRAMEKERNELS_X86
+    switch (isa) {
+    case Isa::AVX2:
+        return &detail::avx2Kernels;
+    case Isa::SSE42:
+        return &detail::sse42Kernels;
+    case Isa::Scalar:
+        break;
+    }
+#else
+    (void)isa;
+#endif
+    return &detail::scalarKernels;
+}
+
+Isa detectBestIsa()
+{
+    if (cpuSupports(Isa::AVX2)) {
+        return Isa::AVX2;
+    }
+    if (cpuSupports(Isa::SSE42)) {
+        return Isa::SSE42;
+    }
+    return Isa::Scalar;
+}
+
+std::atomic<int> &activeIsaStorage()
+{
+    static std::atomic<int> storage{int(detectBestIsa())};
+    return storage;
+}
+
+const detail::KernelTable *activeTable()
+{
+    return tableFor(Isa(activeIsaStorage().load(std::memory_order_relaxed)));
+}
+
+} // namespace
+
+uint64_t hashTile(const uint8_t *data, int stride, int width, int height)
+{
+    return activeTable()->hashTile(data, stride, width, height);
+}
+
+bool tilesEqual(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height)
+{
+    return activeTable()->tilesEqual(a, strideA, b, strideB, width, height);
+}
+
+int64_t countChangedPixels(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height)
+{
+    return activeTable()->countChangedPixels(a, strideA, b, strideB, width, height);
+}
+
+uint64_t differenceHash(const uint8_t *data, int stride, int width, int height)
+{
+    const int kGridColumns = 9;
+    const int kGridRows = 8;
+    if (width < kGridColumns || height < kGridRows) {
+        return 0;
+    }
+
+    // 逐行把像素亮度累加到列和（SIMD），每个网格行结束时再按列区间求和。
+    // 全程整数运算，各指令集实现得到的哈希完全相同
+    const detail::KernelTable *table = activeTable();
+    std::vector<uint32_t> columnSums(static_cast<size_t>(width));
+    uint64_t cells[kGridColumns];
+    uint64_t hash = 0;
+
+    for (int gridY = 0; gridY < kGridRows; ++gridY) {
+        int y0 = gridY * height / kGridRows;
+        int y1 = (gridY + 1) * height / kGridRows;
+        std::fill(columnSums.begin(), columnSums.end(), 0u);
+        for (int y = y0; y < y1; ++y) {
+            table->accumulateLuma(data + y * stride, width, columnSums.data());
+        }
+
+        for (int gridX = 0; gridX < kGridColumns; ++gridX) {
+            int x0 = gridX * width / kGridColumns;
+            int x1 = (gridX + 1) * width / kGridColumns;
+            uint64_t sum = 0;
+            for (int x = x0; x < x1; ++x) {
+                sum += columnSums[size_t(x)];
+            }
+            cells[gridX] = sum / uint64_t(x1 - x0) / uint64_t(y1 - y0);
+        }
+
+        // 左格比右格亮时置位
+        for (int gridX = 0; gridX < kGridColumns - 1; ++gridX) {
+            if (cells[gridX] > cells[gridX + 1]) {
+                hash |= uint64_t(1) << (gridY * (kGridColumns - 1) + gridX);
+            }
+        }
+    }
+    return hash;
+}
+
+int hammingDistance(uint64_t a, uint64_t b)
+{
+    uint64_t value = a ^ b;
+    int distance = 0;
+    while (value) {
+        value &= value - 1;
+        distance++;
+    }
+    return distance;
+}
+
+Isa activeIsa()
+{
+    return Isa(activeIsaStorage().load(std::memory_order_relaxed));
+}
+
+bool isSupported(Isa isa)
+{
+#ifndef FRAMEKERNELS_X86
+    if (isa != Isa::Scalar) {
+        return false;
+    }
+#endif
+    return cpuSupports(isa);
+}
+
+bool setActiveIsa(Isa isa)
+{
+    if (!isSupported(isa)) {
+        return false;
+    }
+
+    activeIsaStorage().store(int(isa), std::memory_order_relaxed);
+    return true;
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::AVX2:
+        return "AVX2";
+    case Isa::SSE42:
+        return "SSE4.2";
+    case Isa::Scalar:
+        break;
+    }
+    return "Scalar";
+}
+
+} // namespace FrameKernels
@@ -0,0 +1,50 @@
+#ifndef FRAMEKERNELS_H
+#define FRAMEKERNELS_H
+
+#include <cstdint>
+
+// 帧比较内核库
+// 所有函数处理 32 位像素（BGRA / Format_RGB32），width 以像素为单位，stride 以字节为单位。
+// 运行时根据 CPU 能力选择 AVX2、SSE4.2 或标量实现，各实现的结果完全一致，
+// 因此哈希值可以跨进程、跨机器比较。
+namespace FrameKernels {
+
+// 指令集
+enum class Isa {
+    Scalar,
+    SSE42,
+    AVX2
+};
+
+// 图块哈希（16 路 32 位乘法-异或混合，最终合并为 64 位）
+uint64_t hashTile(const uint8_t *data, int stride, int width, int height);
+
+// 两个图块是否逐像素相等
+bool tilesEqual(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height);
+
+// 两个区域中不同像素的数量
+int64_t countChangedPixels(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height);
+
+// 感知哈希（dHash）：整帧按面积平均缩小为 9x8 的亮度网格，
+// 每行相邻两格比较亮度得到 64 位。光标闪烁、时钟跳动等局部微小变化通常不改变哈希，
+// 相似画面的汉明距离很小。图像小于 9x8 时返回 0
+uint64_t differenceHash(const uint8_t *data, int stride, int width, int height);
+
+// 两个感知哈希之间的汉明距离（0-64）
+int hammingDistance(uint64_t a, uint64_t b);
+
+// 当前使用的指令集
+Isa activeIsa();
+
+// CPU 是否支持指定指令集
+bool isSupported(Isa isa);
+
+// 强制使用指定指令集（用于基准测试），不支持时返回 false
+bool setActiveIsa(Isa isa);
+
+// 指令集名称
+const char *isaName(Isa isa);
+
+} // namespace FrameKernels
+
+#endif // FRAMEKERNELS_H
@@ -0,0 +1,130 @@
+// AVX2 实现，本文件需要以 -mavx2（MSVC: /arch:AVX2）编译
+#include "framekernels_p.h"
+
+#ifdef FRAMEKERNELS_X86
+
+#include <immintrin.h>
+
+namespace FrameKernels {
+namespace detail {
+
+namespace {
+
+inline __m256i mixLanes(__m256i acc, __m256i pixels, __m256i prime)
+{
+    __m256i value = _mm256_mullo_epi32(_mm256_xor_si256(acc, pixels), prime);
+    return _mm256_xor_si256(value, _mm256_srli_epi32(value, 13));
+}
+
+uint64_t avx2HashTile(const uint8_t *data, int stride, int width, int height)
+{
+    alignas(32) uint32_t lanes[kLaneCount];
+    for (int lane = 0; lane < kLaneCount; ++lane) {
+        lanes[lane] = laneSeed(lane);
+    }
+
+    // 16 条通道对应 2 个寄存器，两条依赖链交错执行
+    const __m256i prime = _mm256_set1_epi32(int(kLanePrime));
+    __m256i low = _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes));
+    __m256i high = _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes + 8));
+    int vectorWidth = width & ~(kLaneCount - 1);
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = data + y * stride;
+        for (int x = 0; x < vectorWidth; x += kLaneCount) {
+            __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x * 4));
+            __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x * 4 + 32));
+            low = mixLanes(low, first, prime);
+            high = mixLanes(high, second, prime);
+        }
+
+        if (vectorWidth < width) {
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), low);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes + 8), high);
+            hashRowTail(lanes, row, vectorWidth, width);
+            low = _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes));
+            high = _mm256_load_si256(reinterpret_cast<const __m256i *>(lanes + 8));
+        }
+    }
+
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), low);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes + 8), high);
+    return finalizeHash(lanes, width, height);
+}
+
+bool avx2TilesEqual(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height)
+{
+    int rowBytes = width * 4;
+    int vectorBytes = rowBytes & ~31;
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *rowA = a + y * strideA;
+        const uint8_t *rowB = b + y * strideB;
+        for (int offset = 0; offset < vectorBytes; offset += 32) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rowA + offset));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rowB + offset));
+            if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != -1) {
+                return false;
+            }
+        }
+        if (std::memcmp(rowA + vectorBytes, rowB + vectorBytes, size_t(rowBytes - vectorBytes)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int64_t avx2CountChangedPixels(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height)
+{
+    int64_t changed = 0;
+    int vectorWidth = width & ~7;
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *rowA = a + y * strideA;
+        const uint8_t *rowB = b + y * strideB;
+        for (int x = 0; x < vectorWidth; x += 8) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rowA + x * 4));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rowB + x * 4));
+            int equalMask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(va, vb)));
+            changed += 8 - popcount8(unsigned(equalMask));
+        }
+        for (int x = vectorWidth; x < width; ++x) {
+            changed += loadPixel(rowA + x * 4) != loadPixel(rowB + x * 4);
+        }
+    }
+    return changed;
+}
+
+void avx2AccumulateLuma(const uint8_t *row, int width, uint32_t *sums)
+{
+    // 与 SSE4.2 实现相同，一次处理 8 个像素
+    const __m256i byteMask = _mm256_set1_epi32(0x00FF00FF);
+    const __m256i greenMask = _mm256_set1_epi32(0x000000FF);
+    const __m256i weightsBR = _mm256_set1_epi32(int((kLumaWeightR << 16) | kLumaWeightB));
+    const __m256i weightG = _mm256_set1_epi32(int(kLumaWeightG));
+    int vectorWidth = width & ~7;
+
+    for (int x = 0; x < vectorWidth; x += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x * 4));
+        __m256i blueRed = _mm256_madd_epi16(_mm256_and_si256(pixels, byteMask), weightsBR);
+        __m256i green = _mm256_madd_epi16(_mm256_and_si256(_mm256_srli_epi32(pixels, 8), greenMask), weightG);
+        __m256i *target = reinterpret_cast<__m256i *>(sums + x);
+        __m256i luma = _mm256_add_epi32(blueRed, green);
+        _mm256_storeu_si256(target, _mm256_add_epi32(_mm256_loadu_si256(target), luma));
+    }
+    accumulateLumaTail(row, vectorWidth, width, sums);
+}
+
+} // namespace
+
+const KernelTable avx2Kernels = {
+    avx2HashTile,
+    avx2TilesEqual,
+    avx2CountChangedPixels,
+    avx2AccumulateLuma
+};
+
+} // namespace detail
+} // namespace FrameKernels
+
+#endif // FRAMEKERNELS_X86
@@ -0,0 +1,101 @@
+#ifndef FRAMEKERNELS_P_H
+#define FRAMEKERNELS_P_H
+
+// 帧比较内核的内部声明，仅供 framekernels*.cpp 使用
+
+#include <cstdint>
+#include <cstring>
+
+namespace FrameKernels {
+namespace detail {
+
+// 哈希使用 16 条 32 位通道，第 x 个像素落在第 (x % 16) 条通道上。
+// 每条通道是一条串行的乘法依赖链，多条通道让 SIMD 实现有足够的指令级并行，
+// SIMD 实现一次处理 16 个像素，与标量实现逐位一致
+const int kLaneCount = 16;
+const uint32_t kLanePrime = 0x85EBCA6Bu;
+
+inline uint32_t laneSeed(int lane)
+{
+    return 0x9E3779B9u * uint32_t(lane + 1);
+}
+
+inline uint32_t mixLane(uint32_t acc, uint32_t pixel)
+{
+    uint32_t value = (acc ^ pixel) * kLanePrime;
+    return value ^ (value >> 13);
+}
+
+inline uint32_t loadPixel(const uint8_t *data)
+{
+    uint32_t pixel;
+    std::memcpy(&pixel, data, sizeof(pixel));
+    return pixel;
+}
+
+// 像素亮度（BT.601 整数权重，结果为亮度 x 256，范围 0-65280）
+const uint32_t kLumaWeightB = 29;
+const uint32_t kLumaWeightG = 150;
+const uint32_t kLumaWeightR = 77;
+
+inline uint32_t pixelLuma(uint32_t pixel)
+{
+    return (pixel & 0xFFu) * kLumaWeightB
+         + ((pixel >> 8) & 0xFFu) * kLumaWeightG
+         + ((pixel >> 16) & 0xFFu) * kLumaWeightR;
+}
+
+// 对一行中 [from, width) 范围内的像素累加亮度
+inline void accumulateLumaTail(const uint8_t *row, int from, int width, uint32_t *sums)
+{
+    for (int x = from; x < width; ++x) {
+        sums[x] += pixelLuma(loadPixel(row + x * 4));
+    }
+}
+
+inline int popcount8(unsigned value)
+{
+    value = value - ((value >> 1) & 0x55u);
+    value = (value & 0x33u) + ((value >> 2) & 0x33u);
+    return int((value + (value >> 4)) & 0x0Fu);
+}
+
+// 对一行中 [from, width) 范围内的像素做标量哈希
+inline void hashRowTail(uint32_t lanes[kLaneCount], const uint8_t *row, int from, int width)
+{
+    for (int x = from; x < width; ++x) {
+        uint32_t &lane = lanes[x & (kLaneCount - 1)];
+        lane = mixLane(lane, loadPixel(row + x * 4));
+    }
+}
+
+// 合并所有通道，尺寸参与哈希，避免不同尺寸的空白图块冲突
+inline uint64_t finalizeHash(const uint32_t lanes[kLaneCount], int width, int height)
+{
+    uint64_t hash = (uint64_t(uint32_t(width)) << 32) | uint32_t(height);
+    for (int lane = 0; lane < kLaneCount; ++lane) {
+        hash ^= lanes[lane];
+        hash *= 0x9E3779B97F4A7C15ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+// 一组内核实现
+struct KernelTable {
+    uint64_t (*hashTile)(const uint8_t *data, int stride, int width, int height);
+    bool (*tilesEqual)(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height);
+    int64_t (*countChangedPixels)(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height);
+    void (*accumulateLuma)(const uint8_t *row, int width, uint32_t *sums);  // sums[x] += 亮度(x)
+};
+
+extern const KernelTable scalarKernels;
+#ifdef FRAMEKERNELS_X86
+extern const KernelTable sse42Kernels;
+extern const KernelTable avx2Kernels;
+#endif
+
+} // namespace detail
+} // namespace FrameKernels
+
+#endif // FRAMEKERNELS_P_H
@@ -0,0 +1,136 @@
+// SSE4.2 实现，本文件需要以 -msse4.2 编译（MSVC 无需额外选项）
+#include "framekernels_p.h"
+
+#ifdef FRAMEKERNELS_X86
+
+#include <nmmintrin.h>
+
+namespace FrameKernels {
+namespace detail {
+
+namespace {
+
+inline __m128i mixLanes(__m128i acc, __m128i pixels, __m128i prime)
+{
+    __m128i value = _mm_mullo_epi32(_mm_xor_si128(acc, pixels), prime);
+    return _mm_xor_si128(value, _mm_srli_epi32(value, 13));
+}
+
+uint64_t sse42HashTile(const uint8_t *data, int stride, int width, int height)
+{
+    alignas(16) uint32_t lanes[kLaneCount];
+    for (int lane = 0; lane < kLaneCount; ++lane) {
+        lanes[lane] = laneSeed(lane);
+    }
+
+    // 16 条通道对应 4 个寄存器
+    const int kVectors = kLaneCount / 4;
+    const __m128i prime = _mm_set1_epi32(int(kLanePrime));
+    __m128i acc[kVectors];
+    for (int i = 0; i < kVectors; ++i) {
+        acc[i] = _mm_load_si128(reinterpret_cast<const __m128i *>(lanes + i * 4));
+    }
+    int vectorWidth = width & ~(kLaneCount - 1);
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *row = data + y * stride;
+        for (int x = 0; x < vectorWidth; x += kLaneCount) {
+            for (int i = 0; i < kVectors; ++i) {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + (x + i * 4) * 4));
+                acc[i] = mixLanes(acc[i], pixels, prime);
+            }
+        }
+
+        if (vectorWidth < width) {
+            for (int i = 0; i < kVectors; ++i) {
+                _mm_store_si128(reinterpret_cast<__m128i *>(lanes + i * 4), acc[i]);
+            }
+            hashRowTail(lanes, row, vectorWidth, width);
+            for (int i = 0; i < kVectors; ++i) {
+                acc[i] = _mm_load_si128(reinterpret_cast<const __m128i *>(lanes + i * 4));
+            }
+        }
+    }
+
+    for (int i = 0; i < kVectors; ++i) {
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes + i * 4), acc[i]);
+    }
+    return finalizeHash(lanes, width, height);
+}
+
+bool sse42TilesEqual(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height)
+{
+    int rowBytes = width * 4;
+    int vectorBytes = rowBytes & ~15;
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *rowA = a + y * strideA;
+        const uint8_t *rowB = b + y * strideB;
+        for (int offset = 0; offset < vectorBytes; offset += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rowA + offset));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rowB + offset));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) {
+                return false;
+            }
+        }
+        if (std::memcmp(rowA + vectorBytes, rowB + vectorBytes, size_t(rowBytes - vectorBytes)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int64_t sse42CountChangedPixels(const uint8_t *a, int strideA, const uint8_t *b, int strideB, int width, int height)
+{
+    int64_t changed = 0;
+    int vectorWidth = width & ~3;
+
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *rowA = a + y * strideA;
+        const uint8_t *rowB = b + y * strideB;
+        for (int x = 0; x < vectorWidth; x += 4) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rowA + x * 4));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rowB + x * 4));
+            int equalMask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(va, vb)));
+            changed += 4 - popcount8(unsigned(equalMask));
+        }
+        for (int x = vectorWidth; x < width; ++x) {
+            changed += loadPixel(rowA + x * 4) != loadPixel(rowB + x * 4);
+        }
+    }
+    return changed;
+}
+
+void sse42AccumulateLuma(const uint8_t *row, int width, uint32_t *sums)
+{
+    // B 和 R 在每个 32 位像素的两个 16 位半字中，一次 madd 得到 B*wb + R*wr
+    const __m128i byteMask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i greenMask = _mm_set1_epi32(0x000000FF);
+    const __m128i weightsBR = _mm_set1_epi32(int((kLumaWeightR << 16) | kLumaWeightB));
+    const __m128i weightG = _mm_set1_epi32(int(kLumaWeightG));
+    int vectorWidth = width & ~3;
+
+    for (int x = 0; x < vectorWidth; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x * 4));
+        __m128i blueRed = _mm_madd_epi16(_mm_and_si128(pixels, byteMask), weightsBR);
+        __m128i green = _mm_madd_epi16(_mm_and_si128(_mm_srli_epi32(pixels, 8), greenMask), weightG);
+        __m128i *target = reinterpret_cast<__m128i *>(sums + x);
+        __m128i luma = _mm_add_epi32(blueRed, green);
+        _mm_storeu_si128(target, _mm_add_epi32(_mm_loadu_si128(target), luma));
+    }
+    accumulateLumaTail(row, vectorWidth, width, sums);
+}
+
+} // namespace
+
+const KernelTable sse42Kernels = {
+    sse42HashTile,
+    sse42TilesEqual,
+    sse42CountChangedPixels,
+    sse42AccumulateLuma
+};
+
+} // namespace detail
+} // namespace FrameKernels
+
+#endif // FRAMEKERNELS_X86
@@ -0,0 +1,215 @@
+#include "framepool.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <atomic>
+
+namespace {
+
+// 新分配的缓冲区按此粒度向上取整，窗口尺寸略有变化时仍能复用
+const qint64 kBlockGranularity = 64 * 1024;
+
+// 复用时允许的最大浪费（容量超出需要的比例）
+const int kMaxSlackDivisor = 4;
+
+// 空闲缓冲区上限：最大一块屏幕的整帧 × 该数量（覆盖流水线队列中同时流动的帧）
+const int kPooledFrames = 4;
+
+// 尚未设置显示器布局时的空闲缓冲区上限
+const qint64 kDefaultMaxPooledBytes = 64 * 1024 * 1024;
+
+// 缓冲区按缓存行对齐，方便变化检测和哈希的 SIMD 内核
+const size_t kBlockAlignment = 64;
+
+} // namespace
+
+struct FramePool::Block {
+    uchar *data = nullptr;
+    qint64 capacity = 0;
+    std::shared_ptr<State> state;   // 使用中的缓冲区持有池状态，池销毁后仍能归还
+
+    ~Block() { qFreeAligned(data); }
+};
+
+struct FramePool::State {
+    mutable QMutex mutex;              // 保护以下成员
+    QVector<Block *> pooled;           // 空闲缓冲区
+    QList<QRect> screens;
+    qint64 pooledBytes = 0;
+    qint64 maxPooledBytes = kDefaultMaxPooledBytes;
+    bool closed = false;               // 池已销毁，归还的缓冲区直接释放
+
+    std::atomic<quint64> acquired{0};
+    std::atomic<quint64> hits{0};
+    std::atomic<quint64> allocations{0};
+    std::atomic<quint64> recycled{0};
+    std::atomic<quint64> discarded{0};
+    std::atomic<int> outstanding{0};
+    std::atomic<qint64> outstandingBytes{0};
+
+    // 取出容量足够且浪费最少的空闲缓冲区（调用方持有锁）
+    Block *takeLocked(qint64 bytes)
+    {
+        int best = -1;
+        for (int i = 0; i < pooled.size(); ++i) {
+            qint64 capacity = pooled[i]->capacity;
+            if (capacity < bytes || capacity > bytes + bytes / kMaxSlackDivisor) {
+                continue;
+            }
+            if (best < 0 || capacity < pooled[best]->capacity) {
+                best = i;
+            }
+        }
+        if (best < 0) {
+            return nullptr;
+        }
+        Block *block = pooled[best];
+        pooled.remove(best);
+        pooledBytes -= block->capacity;
+        return block;
+    }
+
+    // 按字节上限淘汰最早归还的空闲缓冲区（调用方持有锁），被淘汰的放入 dropped
+    void shrinkLocked(QVector<Block *> &dropped)
+    {
+        while (!pooled.isEmpty() && pooledBytes > maxPooledBytes) {
+            Block *block = pooled.takeFirst();
+            pooledBytes -= block->capacity;
+            dropped.append(block);
+        }
+    }
+};
+
+FramePool::FramePool()
+    : m_state(std::make_shared<State>())
+{
+}
+
+FramePool::~FramePool()
+{
+    QVector<Block *> dropped;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        m_state->closed = true;
+        dropped.swap(m_state->pooled);
+        m_state->pooledBytes = 0;
+    }
+    qDeleteAll(dropped);
+}
+
+void FramePool::setScreens(const QList<QRect> &screens)
+{
+    qint64 largestFrame = 0;
+    for (const QRect &screen : screens) {
+        largestFrame = qMax(largestFrame, qint64(screen.width()) * screen.height() * 4);
+    }
+
+    QVector<Block *> dropped;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        if (m_state->screens == screens) {
+            return;
+        }
+        m_state->screens = screens;
+        m_state->maxPooledBytes = largestFrame > 0 ? largestFrame * kPooledFrames : kDefaultMaxPooledBytes;
+
+        // 布局变化后窗口尺寸随之变化，旧尺寸的空闲缓冲区大多用不上
+        dropped.swap(m_state->pooled);
+        m_state->pooledBytes = 0;
+    }
+    m_state->discarded += quint64(dropped.size());
+    qDeleteAll(dropped);
+}
+
+QImage FramePool::acquire(const QSize &size)
+{
+    if (size.isEmpty()) {
+        return QImage();
+    }
+
+    int bytesPerLine = size.width() * 4;
+    qint64 bytes = qint64(bytesPerLine) * size.height();
+
+    Block *block = nullptr;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        block = m_state->takeLocked(bytes);
+    }
+
+    m_state->acquired++;
+    if (block) {
+        m_state->hits++;
+    } else {
+        qint64 capacity = (bytes + kBlockGranularity - 1) / kBlockGranularity * kBlockGranularity;
+        uchar *data = static_cast<uchar *>(qMallocAligned(size_t(capacity), kBlockAlignment));
+        if (!data) {
+            return QImage();
+        }
+        block = new Block;
+        block->data = data;
+        block->capacity = capacity;
+        block->state = m_state;
+        m_state->allocations++;
+    }
+    m_state->outstanding++;
+    m_state->outstandingBytes += block->capacity;
+
+    return QImage(block->data, size.width(), size.height(), bytesPerLine, QImage::Format_RGB32,
+                  &FramePool::releaseBlock, block);
+}
+
+void FramePool::releaseBlock(void *info)
+{
+    Block *block = static_cast<Block *>(info);
+    std::shared_ptr<State> state = block->state;
+    state->outstanding--;
+    state->outstandingBytes -= block->capacity;
+
+    QVector<Block *> dropped;
+    {
+        QMutexLocker locker(&state->mutex);
+        if (state->closed || block->capacity > state->maxPooledBytes) {
+            dropped.append(block);
+        } else {
+            state->pooled.append(block);
+            state->pooledBytes += block->capacity;
+            state->shrinkLocked(dropped);
+        }
+    }
+
+    if (!dropped.contains(block)) {
+        state->recycled++;
+    }
+    state->discarded += quint64(dropped.size());
+    qDeleteAll(dropped);
+}
+
+void FramePool::trim()
+{
+    QVector<Block *> dropped;
+    {
+        QMutexLocker locker(&m_state->mutex);
+        dropped.swap(m_state->pooled);
+        m_state->pooledBytes = 0;
+    }
+    m_state->discarded += quint64(dropped.size());
+    qDeleteAll(dropped);
+}
+
+FramePoolStats FramePool::stats() const
+{
+    FramePoolStats result;
+    result.acquired = m_state->acquired.load();
+    result.hits = m_state->hits.load();
+    result.allocations = m_state->allocations.load();
+    result.recycled = m_state->recycled.load();
+    result.discarded = m_state->discarded.load();
+    result.outstanding = m_state->outstanding.load();
+    result.outstandingBytes = m_state->outstandingBytes.load();
+
+    QMutexLocker locker(&m_state->mutex);
+    result.pooled = m_state->pooled.size();
+    result.pooledBytes = m_state->pooledBytes;
+    result.maxPooledBytes = m_state->maxPooledBytes;
+    return result;
+}
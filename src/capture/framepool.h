@@ -0,0 +1,60 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QSize>
+#include <memory>
+
+// 帧缓冲池统计
+struct FramePoolStats {
+    quint64 acquired = 0;      // 取出的缓冲区总数
+    quint64 hits = 0;          // 复用池中缓冲区的次数
+    quint64 allocations = 0;   // 新分配的次数
+    quint64 recycled = 0;      // 归还到池中的次数
+    quint64 discarded = 0;     // 归还时池已满或尺寸不合适而释放的次数
+    int outstanding = 0;       // 正在使用的缓冲区
+    int pooled = 0;            // 池中空闲的缓冲区
+    qint64 outstandingBytes = 0;
+    qint64 pooledBytes = 0;
+    qint64 maxPooledBytes = 0; // 空闲缓冲区的字节上限（按显示器布局计算）
+
+    double hitRate() const { return acquired > 0 ? double(hits) / acquired : 0.0; }
+};
+
+// 截图帧缓冲池
+// 每次截图都是几 MB 到几十 MB 的整块内存，逐帧分配释放会让堆反复向系统申请和归还大块内存。
+// acquire() 返回的 QImage 直接使用池中的内存：QImage 的隐式共享就是引用计数句柄，
+// 记录、缓存和信号接收方持有的都是同一块内存，最后一个副本销毁时缓冲区自动回到池中。
+// 空闲缓冲区的总字节数按当前显示器布局限制，布局变化后旧尺寸的空闲缓冲区被释放。
+// 线程安全：可以在任意线程中取出，缓冲区在最后释放它的线程中归还。池对象销毁后
+// 仍在使用的缓冲区照常有效，归还时直接释放。
+class FramePool
+{
+public:
+    FramePool();
+    ~FramePool();
+
+    // 显示器布局（虚拟桌面物理像素坐标），决定空闲缓冲区的字节上限
+    void setScreens(const QList<QRect> &screens);
+
+    // 取出 size 大小的 Format_RGB32 图像，内容未初始化
+    QImage acquire(const QSize &size);
+
+    // 释放所有空闲缓冲区
+    void trim();
+
+    FramePoolStats stats() const;
+
+private:
+    struct State;
+    struct Block;
+
+    // QImage 的清理函数，最后一个副本销毁时调用
+    static void releaseBlock(void *info);
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif // FRAMEPOOL_H
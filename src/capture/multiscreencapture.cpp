@@ -0,0 +1,258 @@
+#include "multiscreencapture.h"
+#include "capturebackend.h"
+#include <QAtomicInt>
+#include <QDebug>
+#include <QGuiApplication>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QScreen>
+#include <QSemaphore>
+#include <QThreadStorage>
+
+#include <cstring>
+
+namespace {
+
+// 每个抓取线程一个后端，线程退出时由 QThreadStorage 释放
+QThreadStorage<CaptureBackend *> g_backends;
+
+CaptureBackend *threadBackend()
+{
+    if (!g_backends.hasLocalData()) {
+        CaptureBackend *backend = CaptureBackend::create();
+        if (backend && !backend->isAvailable()) {
+            delete backend;
+            backend = nullptr;
+        }
+        g_backends.setLocalData(backend);
+    }
+    return g_backends.localData();
+}
+
+// 抓取 source 区域，直接写入目标帧的对应位置
+// 各任务写入的像素区域互不重叠，可以直接并行写同一块内存
+struct GrabTarget {
+    uchar *bits = nullptr;       // 目标帧首地址
+    int bytesPerLine = 0;        // 目标帧行字节数
+    QPoint origin;               // 目标帧左上角对应的虚拟桌面坐标
+};
+
+bool grabInto(const QRect &source, const GrabTarget &target)
+{
+    CaptureBackend *backend = threadBackend();
+    if (!backend) {
+        return false;
+    }
+
+    // 不拥有内存的 QImage 指向目标帧中的对应区域，行宽沿用目标帧的 bytesPerLine，
+    // 后端发现尺寸和格式匹配时直接写入，不经过中间缓冲区
+    uchar *bits = target.bits + (source.y() - target.origin.y()) * target.bytesPerLine
+        + (source.x() - target.origin.x()) * 4;
+    QImage view(bits, source.width(), source.height(), target.bytesPerLine, QImage::Format_RGB32);
+    if (!backend->grab(source, view) || view.size() != source.size()) {
+        return false;
+    }
+
+    // 后端重新分配了缓冲区（正常情况下不会发生），逐行拷回目标帧
+    if (view.constBits() != bits) {
+        int rowBytes = source.width() * 4;
+        for (int y = 0; y < source.height(); ++y) {
+            std::memcpy(bits + y * target.bytesPerLine, view.constScanLine(y), rowBytes);
+        }
+    }
+    return true;
+}
+
+class GrabTask : public QRunnable
+{
+public:
+    GrabTask(const QList<QRect> &parts, const GrabTarget &target, QSemaphore *done, QAtomicInt *failures)
+        : m_parts(parts), m_target(target), m_done(done), m_failures(failures)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        for (const QRect &part : m_parts) {
+            if (!grabInto(part, m_target)) {
+                m_failures->ref();
+            }
+        }
+        m_done->release();
+    }
+
+private:
+    QList<QRect> m_parts;
+    GrabTarget m_target;
+    QSemaphore *m_done;
+    QAtomicInt *m_failures;
+};
+
+} // namespace
+
+MultiScreenCapture::MultiScreenCapture()
+    : m_parallel(true)
+{
+    // 线程常驻，避免过期后重新建立 X11 连接或 GDI 资源
+    m_pool.setExpiryTimeout(-1);
+}
+
+MultiScreenCapture::~MultiScreenCapture()
+{
+    m_pool.waitForDone();
+}
+
+void MultiScreenCapture::setScreens(const QList<QRect> &screens)
+{
+    QMutexLocker locker(&m_mutex);
+    m_screens = screens;
+    m_pool.setMaxThreadCount(qMax(1, m_screens.size()));
+}
+
+QList<QRect> MultiScreenCapture::screens() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_screens;
+}
+
+void MultiScreenCapture::setParallel(bool parallel)
+{
+    QMutexLocker locker(&m_mutex);
+    m_parallel = parallel;
+}
+
+bool MultiScreenCapture::isParallel() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_parallel;
+}
+
+bool MultiScreenCapture::grabRegion(const QRect &rect, QImage &frame)
+{
+    if (rect.isEmpty()) {
+        return false;
+    }
+
+    QList<QRect> screenList;
+    bool parallel = true;
+    {
+        QMutexLocker locker(&m_mutex);
+        screenList = m_screens;
+        parallel = m_parallel;
+    }
+
+    // 按显示器拆分；尚未设置布局时整块交给后端
+    QList<QRect> parts;
+    for (const QRect &screen : screenList) {
+        QRect part = rect.intersected(screen);
+        if (!part.isEmpty()) {
+            parts.append(part);
+        }
+    }
+    if (screenList.isEmpty()) {
+        parts.append(rect);
+    }
+    if (parts.isEmpty()) {
+        return false;
+    }
+
+    // 完全落在一块屏幕内（最常见的情况）：直接抓到调用方缓冲区
+    if (parts.size() == 1 && parts.first() == rect) {
+        CaptureBackend *backend = threadBackend();
+        return backend && backend->grab(rect, frame);
+    }
+
+    if (frame.size() != rect.size() || frame.format() != QImage::Format_RGB32) {
+        frame = QImage(rect.size(), QImage::Format_RGB32);
+    }
+
+    // 屏幕之间的空隙（不规则排列的多屏）填黑
+    qint64 covered = 0;
+    for (const QRect &part : parts) {
+        covered += qint64(part.width()) * part.height();
+    }
+    if (covered < qint64(rect.width()) * rect.height()) {
+        frame.fill(Qt::black);
+    }
+
+    GrabTarget target;
+    target.bits = frame.bits();
+    target.bytesPerLine = frame.bytesPerLine();
+    target.origin = rect.topLeft();
+
+    // 只有一块屏幕上的一部分（窗口伸出屏幕外），同样不必切换线程
+    if (parts.size() == 1) {
+        return grabInto(parts.first(), target);
+    }
+
+    QSemaphore done;
+    QAtomicInt failures(0);
+    int taskCount = 0;
+    if (parallel) {
+        for (const QRect &part : parts) {
+            m_pool.start(new GrabTask(QList<QRect>() << part, target, &done, &failures));
+            taskCount++;
+        }
+    } else {
+        m_pool.start(new GrabTask(parts, target, &done, &failures));
+        taskCount = 1;
+    }
+    done.acquire(taskCount);
+
+    if (failures.load() > 0) {
+        qDebug() << "多屏截图失败的显示器数量:" << failures.load();
+        return false;
+    }
+    return true;
+}
+
+bool MultiScreenCapture::grabDesktop(QImage &frame)
+{
+    return grabRegion(desktopRect(), frame);
+}
+
+bool MultiScreenCapture::grabScreens(QList<QImage> &frames)
+{
+    QList<QRect> screenList = screens();
+    frames.clear();
+    for (int i = 0; i < screenList.size(); ++i) {
+        frames.append(QImage(screenList[i].size(), QImage::Format_RGB32));
+    }
+
+    QSemaphore done;
+    QAtomicInt failures(0);
+    for (int i = 0; i < screenList.size(); ++i) {
+        GrabTarget target;
+        target.bits = frames[i].bits();
+        target.bytesPerLine = frames[i].bytesPerLine();
+        target.origin = screenList[i].topLeft();
+        m_pool.start(new GrabTask(QList<QRect>() << screenList[i], target, &done, &failures));
+    }
+    done.acquire(screenList.size());
+
+    return !screenList.isEmpty() && failures.load() == 0;
+}
+
+QRect MultiScreenCapture::desktopRect() const
+{
+    QMutexLocker locker(&m_mutex);
+    QRect rect;
+    for (const QRect &screen : m_screens) {
+        rect = rect.united(screen);
+    }
+    return rect;
+}
+
+QList<QRect> MultiScreenCapture::currentScreens()
+{
+    // QScreen::geometry() 是逻辑坐标，后端使用物理像素，按缩放比例换算
+    QList<QRect> result;
+    for (QScreen *screen : QGuiApplication::screens()) {
+        QRect geometry = screen->geometry();
+        qreal ratio = screen->devicePixelRatio();
+        result.append(QRect(qRound(geometry.x() * ratio), qRound(geometry.y() * ratio),
+                            qRound(geometry.width() * ratio), qRound(geometry.height() * ratio)));
+    }
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef MULTISCREENCAPTURE_H
+#define MULTISCREENCAPTURE_H
+
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QPoint>
+#include <QRect>
+#include <QThreadPool>
+
+// 多屏截图
+// 按显示器拆分截图区域，每块屏幕由独立的工作线程抓取后拼接成一帧。
+// 每个工作线程持有自己的 CaptureBackend（线程局部），互不共享连接和缓冲区。
+// 所有坐标均为虚拟桌面的物理像素坐标。
+class MultiScreenCapture
+{
+public:
+    MultiScreenCapture();
+    ~MultiScreenCapture();
+
+    // 显示器布局（线程安全），通常在 GUI 线程中由 currentScreens() 获取后设置
+    void setScreens(const QList<QRect> &screens);
+    QList<QRect> screens() const;
+
+    // 是否并行抓取（关闭时在工作线程中逐屏抓取，用于对比测试）
+    void setParallel(bool parallel);
+    bool isParallel() const;
+
+    // 抓取 rect 区域：只抓与之相交的显示器，多屏时并行，不在任何屏幕内的部分填黑
+    // 只涉及一块屏幕时直接在调用线程中抓取，省去线程切换
+    bool grabRegion(const QRect &rect, QImage &frame);
+
+    // 抓取整个虚拟桌面（所有显示器的外接矩形）
+    bool grabDesktop(QImage &frame);
+
+    // 逐屏抓取，frames 与 screens() 一一对应
+    bool grabScreens(QList<QImage> &frames);
+
+    // 所有显示器的外接矩形
+    QRect desktopRect() const;
+
+    // 当前系统的显示器布局（必须在 GUI 线程中调用）
+    static QList<QRect> currentScreens();
+
+private:
+    QThreadPool m_pool;          // 抓取线程，每个线程常驻并持有自己的后端
+    mutable QMutex m_mutex;      // 保护以下成员
+    QList<QRect> m_screens;      // 显示器布局
+    bool m_parallel;             // 是否并行
+};
+
+#endif // MULTISCREENCAPTURE_H
@@ -0,0 +1,193 @@
+#include "wincapturebackend.h"
+#include <QDebug>
+#include <QFileInfo>
+
+#include <cstring>
+#include <psapi.h>
+
+WinCaptureBackend::WinCaptureBackend()
+    : m_memoryDC(nullptr)
+    , m_dibSection(nullptr)
+    , m_oldBitmap(nullptr)
+    , m_dibBits(nullptr)
+{
+    m_memoryDC = CreateCompatibleDC(nullptr);
+}
+
+WinCaptureBackend::~WinCaptureBackend()
+{
+    releaseDibSection();
+    if (m_memoryDC) {
+        DeleteDC(m_memoryDC);
+    }
+}
+
+QString WinCaptureBackend::name() const
+{
+    return "GDI";
+}
+
+bool WinCaptureBackend::isAvailable() const
+{
+    return m_memoryDC != nullptr;
+}
+
+WindowHandle WinCaptureBackend::activeWindow()
+{
+    return reinterpret_cast<WindowHandle>(GetForegroundWindow());
+}
+
+QRect WinCaptureBackend::windowRect(WindowHandle window)
+{
+    RECT rect;
+    if (!window || !GetWindowRect(reinterpret_cast<HWND>(window), &rect)) {
+        return QRect();
+    }
+
+    return QRect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
+}
+
+qint64 WinCaptureBackend::windowProcessId(WindowHandle window)
+{
+    if (!window) {
+        return 0;
+    }
+
+    DWORD processId = 0;
+    GetWindowThreadProcessId(reinterpret_cast<HWND>(window), &processId);
+    return processId;
+}
+
+QString WinCaptureBackend::windowTitle(WindowHandle window)
+{
+    HWND hwnd = reinterpret_cast<HWND>(window);
+    if (!hwnd) {
+        return "";
+    }
+
+    int length = GetWindowTextLengthW(hwnd);
+    if (length == 0) {
+        return "";
+    }
+
+    wchar_t *buffer = new wchar_t[length + 1];
+    GetWindowTextW(hwnd, buffer, length + 1);
+
+    QString title = QString::fromWCharArray(buffer);
+    delete[] buffer;
+
+    return title;
+}
+
+QString WinCaptureBackend::executablePath(qint64 processId)
+{
+    if (processId <= 0) {
+        return "";
+    }
+
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, DWORD(processId));
+    if (!hProcess) {
+        return "";
+    }
+
+    wchar_t processPath[MAX_PATH];
+    QString path;
+    if (GetModuleFileNameExW(hProcess, NULL, processPath, MAX_PATH)) {
+        path = QString::fromWCharArray(processPath);
+    }
+
+    CloseHandle(hProcess);
+    return path;
+}
+
+bool WinCaptureBackend::ensureDibSection(int width, int height)
+{
+    if (m_dibSection && m_dibSize == QSize(width, height)) {
+        return true;
+    }
+
+    releaseDibSection();
+
+    BITMAPINFO bmi = {0};
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height; // 负值表示自上而下
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    m_dibSection = CreateDIBSection(m_memoryDC, &bmi, DIB_RGB_COLORS, &m_dibBits, nullptr, 0);
+    if (!m_dibSection) {
+        m_dibBits = nullptr;
+        return false;
+    }
+
+    m_oldBitmap = SelectObject(m_memoryDC, m_dibSection);
+    m_dibSize = QSize(width, height);
+    return true;
+}
+
+void WinCaptureBackend::releaseDibSection()
+{
+    if (!m_dibSection) {
+        return;
+    }
+
+    SelectObject(m_memoryDC, m_oldBitmap);
+    DeleteObject(m_dibSection);
+    m_dibSection = nullptr;
+    m_oldBitmap = nullptr;
+    m_dibBits = nullptr;
+    m_dibSize = QSize();
+}
+
+qint64 WinCaptureBackend::inputIdleTime()
+{
+    LASTINPUTINFO info;
+    info.cbSize = sizeof(info);
+    if (!GetLastInputInfo(&info)) {
+        return -1;
+    }
+
+    // 两者都是 32 位毫秒计数，无符号相减可正确处理约 49.7 天的回绕
+    return qint64(DWORD(GetTickCount() - info.dwTime));
+}
+
+bool WinCaptureBackend::grab(const QRect &rect, QImage &buffer)
+{
+    if (!m_memoryDC || rect.isEmpty()) {
+        return false;
+    }
+
+    if (!ensureDibSection(rect.width(), rect.height())) {
+        return false;
+    }
+
+    // 屏幕DC覆盖整个虚拟桌面，坐标可以为负（主屏左侧/上方的显示器）
+    HDC screenDC = GetDC(nullptr);
+    BOOL ok = BitBlt(m_memoryDC, 0, 0, rect.width(), rect.height(),
+                     screenDC, rect.x(), rect.y(), SRCCOPY | CAPTUREBLT);
+    ReleaseDC(nullptr, screenDC);
+
+    if (!ok) {
+        qDebug() << "BitBlt 失败，错误码:" << GetLastError();
+        return false;
+    }
+
+    GdiFlush();
+    prepareBuffer(buffer, rect.size());
+
+    // DIB 行宽按 4 字节对齐，32 位像素正好没有填充
+    const uchar *src = static_cast<const uchar *>(m_dibBits);
+    int rowBytes = rect.width() * 4;
+    for (int y = 0; y < rect.height(); ++y) {
+        uchar *dst = buffer.scanLine(y);
+        std::memcpy(dst, src + y * rowBytes, rowBytes);
+        quint32 *pixels = reinterpret_cast<quint32 *>(dst);
+        for (int x = 0; x < rect.width(); ++x) {
+            pixels[x] |= 0xff000000u;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef WINCAPTUREBACKEND_H
+#define WINCAPTUREBACKEND_H
+
+#include "capturebackend.h"
+
+#include <windows.h>
+
+// Windows 截图后端
+// 使用 GDI BitBlt 直接拷贝到常驻的 DIB Section，再按行复制到调用方缓冲区，
+// 绕开 QScreen::grabWindow 每次创建 QPixmap 的开销。
+class WinCaptureBackend : public CaptureBackend
+{
+public:
+    WinCaptureBackend();
+    ~WinCaptureBackend() override;
+
+    QString name() const override;
+    bool isAvailable() const override;
+
+    WindowHandle activeWindow() override;
+    QRect windowRect(WindowHandle window) override;
+    qint64 windowProcessId(WindowHandle window) override;
+    QString windowTitle(WindowHandle window) override;
+    QString executablePath(qint64 processId) override;
+    qint64 inputIdleTime() override;
+
+    bool grab(const QRect &rect, QImage &buffer) override;
+
+private:
+    bool ensureDibSection(int width, int height);
+    void releaseDibSection();
+
+    HDC m_memoryDC;          // 内存DC
+    HBITMAP m_dibSection;    // 常驻的 DIB Section
+    HGDIOBJ m_oldBitmap;     // 内存DC原有位图
+    void *m_dibBits;         // DIB 像素数据
+    QSize m_dibSize;         // DIB 尺寸
+};
+
+#endif // WINCAPTUREBACKEND_H
@@ -0,0 +1,65 @@
+#include "winfocustracker.h"
+#include <QDebug>
+
+WinFocusTracker *WinFocusTracker::s_instance = nullptr;
+
+WinFocusTracker::WinFocusTracker(QObject *parent)
+    : FocusTracker(parent)
+    , m_hook(nullptr)
+{
+}
+
+WinFocusTracker::~WinFocusTracker()
+{
+    stop();
+}
+
+bool WinFocusTracker::start()
+{
+    if (m_hook) {
+        return true;
+    }
+    if (s_instance) {
+        qDebug() << "已有焦点监听实例在运行";
+        return false;
+    }
+
+    m_hook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                             &WinFocusTracker::winEventProc, 0, 0,
+                             WINEVENT_OUTOFCONTEXT);
+    if (!m_hook) {
+        qDebug() << "SetWinEventHook 失败，错误码:" << GetLastError();
+        return false;
+    }
+
+    s_instance = this;
+    qDebug() << "Windows 焦点监听已启动";
+    return true;
+}
+
+void WinFocusTracker::stop()
+{
+    if (!m_hook) {
+        return;
+    }
+
+    UnhookWinEvent(m_hook);
+    m_hook = nullptr;
+    s_instance = nullptr;
+}
+
+bool WinFocusTracker::isActive() const
+{
+    return m_hook != nullptr;
+}
+
+void CALLBACK WinFocusTracker::winEventProc(HWINEVENTHOOK, DWORD event, HWND, LONG objectId,
+                                            LONG, DWORD, DWORD)
+{
+    // 只关心窗口本身成为前台，忽略子对象事件
+    if (event != EVENT_SYSTEM_FOREGROUND || objectId != OBJID_WINDOW || !s_instance) {
+        return;
+    }
+
+    emit s_instance->activeWindowChanged();
+}
@@ -0,0 +1,31 @@
+#ifndef WINFOCUSTRACKER_H
+#define WINFOCUSTRACKER_H
+
+#include "focustracker.h"
+
+#include <windows.h>
+
+// Windows 前台窗口监听
+// 通过 SetWinEventHook(EVENT_SYSTEM_FOREGROUND) 接收前台窗口切换事件。
+// 使用进程外钩子，回调经由调用线程的消息循环投递，因此必须在 GUI 线程中启动。
+class WinFocusTracker : public FocusTracker
+{
+    Q_OBJECT
+
+public:
+    explicit WinFocusTracker(QObject *parent = nullptr);
+    ~WinFocusTracker() override;
+
+    bool start() override;
+    void stop() override;
+    bool isActive() const override;
+
+private:
+    static void CALLBACK winEventProc(HWINEVENTHOOK hook, DWORD event, HWND window,
+                                      LONG objectId, LONG childId, DWORD threadId, DWORD timestamp);
+
+    HWINEVENTHOOK m_hook;               // 事件钩子
+    static WinFocusTracker *s_instance; // 回调无法携带上下文，同一时刻只允许一个实例
+};
+
+#endif // WINFOCUSTRACKER_H
@@ -0,0 +1,370 @@
+#include "x11capturebackend.h"
+#include <QByteArray>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QPoint>
+
+#include <cstring>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+
+// X11 头文件放在 Qt 头文件之后，避免宏污染
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#ifdef USE_XSS
+#include <X11/extensions/scrnsaver.h>
+#endif
+
+namespace {
+
+// 窗口在查询过程中被销毁时会产生 BadWindow 等错误，
+// 默认处理函数会直接退出进程，这里只记录日志
+int ignoreXErrors(Display *, XErrorEvent *event)
+{
+    qDebug() << "X11 错误，代码:" << event->error_code << "请求:" << event->request_code;
+    return 0;
+}
+
+} // namespace
+
+struct X11CaptureBackend::Private
+{
+    Display *display = nullptr;
+    Window root = 0;
+    int screen = 0;
+
+    Atom netActiveWindow = 0;
+    Atom netWmPid = 0;
+    Atom netWmName = 0;
+    Atom utf8String = 0;
+
+    // 共享内存图像，尺寸不变时复用
+    bool hasShm = false;
+    XImage *shmImage = nullptr;
+    XShmSegmentInfo shmInfo;
+
+#ifdef USE_XSS
+    // MIT-SCREEN-SAVER 扩展直接提供输入空闲时间
+    XScreenSaverInfo *screenSaverInfo = nullptr;
+#endif
+
+    // 没有屏幕保护扩展时以鼠标位置变化近似判断输入活动
+    QPoint lastPointer;
+    QElapsedTimer pointerIdleTimer;
+
+    bool ensureShmImage(int width, int height);
+    void releaseShmImage();
+    QByteArray windowProperty(Window window, Atom property, Atom type, long maxLength) const;
+};
+
+bool X11CaptureBackend::Private::ensureShmImage(int width, int height)
+{
+    if (shmImage && shmImage->width == width && shmImage->height == height) {
+        return true;
+    }
+
+    releaseShmImage();
+
+    shmImage = XShmCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                               ZPixmap, nullptr, &shmInfo, width, height);
+    if (!shmImage) {
+        return false;
+    }
+
+    shmInfo.shmid = shmget(IPC_PRIVATE, shmImage->bytes_per_line * shmImage->height, IPC_CREAT | 0600);
+    if (shmInfo.shmid < 0) {
+        XDestroyImage(shmImage);
+        shmImage = nullptr;
+        return false;
+    }
+
+    shmInfo.shmaddr = shmImage->data = static_cast<char *>(shmat(shmInfo.shmid, nullptr, 0));
+    shmInfo.readOnly = False;
+    if (shmInfo.shmaddr == reinterpret_cast<char *>(-1)) {
+        shmctl(shmInfo.shmid, IPC_RMID, nullptr);
+        shmImage->data = nullptr;
+        XDestroyImage(shmImage);
+        shmImage = nullptr;
+        return false;
+    }
+
+    if (!XShmAttach(display, &shmInfo)) {
+        // 已映射到本进程，需要先解除映射再删除段
+        shmdt(shmInfo.shmaddr);
+        shmctl(shmInfo.shmid, IPC_RMID, nullptr);
+        shmImage->data = nullptr;
+        XDestroyImage(shmImage);
+        shmImage = nullptr;
+        return false;
+    }
+
+    // 等待服务器完成映射后立即标记删除，进程退出时由内核回收
+    XSync(display, False);
+    shmctl(shmInfo.shmid, IPC_RMID, nullptr);
+    return true;
+}
+
+void X11CaptureBackend::Private::releaseShmImage()
+{
+    if (!shmImage) {
+        return;
+    }
+
+    XShmDetach(display, &shmInfo);
+    XSync(display, False);
+    shmdt(shmInfo.shmaddr);
+    shmImage->data = nullptr;
+    XDestroyImage(shmImage);
+    shmImage = nullptr;
+}
+
+QByteArray X11CaptureBackend::Private::windowProperty(Window window, Atom property, Atom type, long maxLength) const
+{
+    Atom actualType = 0;
+    int actualFormat = 0;
+    unsigned long itemCount = 0;
+    unsigned long bytesAfter = 0;
+    unsigned char *data = nullptr;
+
+    if (XGetWindowProperty(display, window, property, 0, maxLength, False, type,
+                           &actualType, &actualFormat, &itemCount, &bytesAfter, &data) != Success) {
+        return QByteArray();
+    }
+
+    QByteArray result;
+    if (data && itemCount > 0 && actualType == type) {
+        // format 为 32 时 Xlib 以 long 存储每一项
+        int itemSize = (actualFormat == 32) ? int(sizeof(long)) : actualFormat / 8;
+        result = QByteArray(reinterpret_cast<const char *>(data), int(itemCount) * itemSize);
+    }
+
+    if (data) {
+        XFree(data);
+    }
+    return result;
+}
+
+X11CaptureBackend::X11CaptureBackend()
+    : d(new Private)
+{
+    d->display = XOpenDisplay(nullptr);
+    if (!d->display) {
+        qDebug() << "无法连接 X 服务器";
+        return;
+    }
+
+    XSetErrorHandler(ignoreXErrors);
+
+    d->screen = DefaultScreen(d->display);
+    d->root = RootWindow(d->display, d->screen);
+    d->netActiveWindow = XInternAtom(d->display, "_NET_ACTIVE_WINDOW", False);
+    d->netWmPid = XInternAtom(d->display, "_NET_WM_PID", False);
+    d->netWmName = XInternAtom(d->display, "_NET_WM_NAME", False);
+    d->utf8String = XInternAtom(d->display, "UTF8_STRING", False);
+    d->hasShm = XShmQueryExtension(d->display);
+
+#ifdef USE_XSS
+    int eventBase = 0;
+    int errorBase = 0;
+    if (XScreenSaverQueryExtension(d->display, &eventBase, &errorBase)) {
+        d->screenSaverInfo = XScreenSaverAllocInfo();
+    }
+#endif
+
+    qDebug() << "X11 截图后端已初始化，XShm:" << d->hasShm;
+}
+
+X11CaptureBackend::~X11CaptureBackend()
+{
+    if (d->display) {
+        d->releaseShmImage();
+#ifdef USE_XSS
+        if (d->screenSaverInfo) {
+            XFree(d->screenSaverInfo);
+        }
+#endif
+        XCloseDisplay(d->display);
+    }
+    delete d;
+}
+
+QString X11CaptureBackend::name() const
+{
+    return d->hasShm ? "X11 (XShm)" : "X11";
+}
+
+bool X11CaptureBackend::isAvailable() const
+{
+    return d->display != nullptr;
+}
+
+WindowHandle X11CaptureBackend::activeWindow()
+{
+    if (!d->display) {
+        return 0;
+    }
+
+    QByteArray value = d->windowProperty(d->root, d->netActiveWindow, XA_WINDOW, 1);
+    if (value.size() < int(sizeof(long))) {
+        return 0;
+    }
+
+    return static_cast<WindowHandle>(*reinterpret_cast<const unsigned long *>(value.constData()));
+}
+
+QRect X11CaptureBackend::windowRect(WindowHandle window)
+{
+    if (!d->display || !window) {
+        return QRect();
+    }
+
+    XWindowAttributes attributes;
+    if (!XGetWindowAttributes(d->display, window, &attributes)) {
+        return QRect();
+    }
+
+    int rootX = 0;
+    int rootY = 0;
+    Window child = 0;
+    if (!XTranslateCoordinates(d->display, window, d->root, 0, 0, &rootX, &rootY, &child)) {
+        return QRect();
+    }
+
+    return QRect(rootX, rootY, attributes.width, attributes.height);
+}
+
+qint64 X11CaptureBackend::windowProcessId(WindowHandle window)
+{
+    if (!d->display || !window) {
+        return 0;
+    }
+
+    QByteArray value = d->windowProperty(window, d->netWmPid, XA_CARDINAL, 1);
+    if (value.size() < int(sizeof(long))) {
+        return 0;
+    }
+
+    return static_cast<qint64>(*reinterpret_cast<const unsigned long *>(value.constData()));
+}
+
+QString X11CaptureBackend::windowTitle(WindowHandle window)
+{
+    if (!d->display || !window) {
+        return "";
+    }
+
+    QByteArray title = d->windowProperty(window, d->netWmName, d->utf8String, 1024);
+    if (!title.isEmpty()) {
+        return QString::fromUtf8(title);
+    }
+
+    // 旧式窗口管理器只设置 WM_NAME
+    char *name = nullptr;
+    if (XFetchName(d->display, window, &name) && name) {
+        QString result = QString::fromLocal8Bit(name);
+        XFree(name);
+        return result;
+    }
+
+    return "";
+}
+
+QString X11CaptureBackend::executablePath(qint64 processId)
+{
+    if (processId <= 0) {
+        return "";
+    }
+
+    return QFileInfo(QString("/proc/%1/exe").arg(processId)).symLinkTarget();
+}
+
+qint64 X11CaptureBackend::inputIdleTime()
+{
+    if (!d->display) {
+        return -1;
+    }
+
+#ifdef USE_XSS
+    if (d->screenSaverInfo && XScreenSaverQueryInfo(d->display, d->root, d->screenSaverInfo)) {
+        return qint64(d->screenSaverInfo->idle);
+    }
+#endif
+
+    Window rootReturn = 0;
+    Window childReturn = 0;
+    int rootX = 0;
+    int rootY = 0;
+    int windowX = 0;
+    int windowY = 0;
+    unsigned int mask = 0;
+    if (!XQueryPointer(d->display, d->root, &rootReturn, &childReturn,
+                       &rootX, &rootY, &windowX, &windowY, &mask)) {
+        return -1;
+    }
+
+    // 首次查询没有参照，视为刚有输入
+    QPoint pointer(rootX, rootY);
+    if (!d->pointerIdleTimer.isValid() || pointer != d->lastPointer) {
+        d->lastPointer = pointer;
+        d->pointerIdleTimer.start();
+    }
+    return d->pointerIdleTimer.elapsed();
+}
+
+bool X11CaptureBackend::grab(const QRect &rect, QImage &buffer)
+{
+    if (!d->display) {
+        return false;
+    }
+
+    // 裁剪到根窗口范围内，越界的 XGetImage 请求会失败
+    QRect rootRect(0, 0, DisplayWidth(d->display, d->screen), DisplayHeight(d->display, d->screen));
+    QRect area = rect.intersected(rootRect);
+    if (area.isEmpty()) {
+        return false;
+    }
+
+    XImage *image = nullptr;
+    bool fromShm = false;
+    if (d->hasShm && d->ensureShmImage(area.width(), area.height())) {
+        if (XShmGetImage(d->display, d->root, d->shmImage, area.x(), area.y(), AllPlanes)) {
+            image = d->shmImage;
+            fromShm = true;
+        }
+    }
+
+    if (!image) {
+        image = XGetImage(d->display, d->root, area.x(), area.y(), area.width(), area.height(),
+                          AllPlanes, ZPixmap);
+        if (!image) {
+            return false;
+        }
+    }
+
+    bool ok = image->bits_per_pixel == 32;
+    if (ok) {
+        prepareBuffer(buffer, area.size());
+
+        // 24 位深度下填充字节未定义，Format_RGB32 要求其为 0xff
+        int rowBytes = area.width() * 4;
+        for (int y = 0; y < area.height(); ++y) {
+            uchar *dst = buffer.scanLine(y);
+            std::memcpy(dst, image->data + y * image->bytes_per_line, rowBytes);
+            quint32 *pixels = reinterpret_cast<quint32 *>(dst);
+            for (int x = 0; x < area.width(); ++x) {
+                pixels[x] |= 0xff000000u;
+            }
+        }
+    } else {
+        qDebug() << "不支持的 X11 像素格式，bpp:" << image->bits_per_pixel;
+    }
+
+    if (!fromShm) {
+        XDestroyImage(image);
+    }
+    return ok;
+}
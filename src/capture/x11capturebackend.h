@@ -0,0 +1,34 @@
+#ifndef X11CAPTUREBACKEND_H
+#define X11CAPTUREBACKEND_H
+
+#include "capturebackend.h"
+
+// Linux X11 截图后端
+// 使用 XShm 共享内存图像抓屏，像素直接落在共享内存中，避免经由 socket 传输整帧。
+// X 服务器不支持 MIT-SHM 时退回到 XGetImage。
+// 每个实例持有独立的 Display 连接。
+class X11CaptureBackend : public CaptureBackend
+{
+public:
+    X11CaptureBackend();
+    ~X11CaptureBackend() override;
+
+    QString name() const override;
+    bool isAvailable() const override;
+
+    WindowHandle activeWindow() override;
+    QRect windowRect(WindowHandle window) override;
+    qint64 windowProcessId(WindowHandle window) override;
+    QString windowTitle(WindowHandle window) override;
+    QString executablePath(qint64 processId) override;
+    qint64 inputIdleTime() override;
+
+    bool grab(const QRect &rect, QImage &buffer) override;
+
+private:
+    // X11 头文件中的宏会与 Qt 冲突，相关类型只放在 .cpp 中
+    struct Private;
+    Private *d;
+};
+
+#endif // X11CAPTUREBACKEND_H
@@ -0,0 +1,95 @@
+#include "x11focustracker.h"
+#include <QDebug>
+#include <QSocketNotifier>
+
+// X11 头文件放在 Qt 头文件之后，避免宏污染
+#include <X11/Xlib.h>
+
+struct X11FocusTracker::Private
+{
+    Display *display = nullptr;
+    Window root = 0;
+    Atom netActiveWindow = 0;
+};
+
+X11FocusTracker::X11FocusTracker(QObject *parent)
+    : FocusTracker(parent)
+    , d(new Private)
+    , m_notifier(nullptr)
+{
+}
+
+X11FocusTracker::~X11FocusTracker()
+{
+    stop();
+    delete d;
+}
+
+bool X11FocusTracker::start()
+{
+    if (d->display) {
+        return true;
+    }
+
+    d->display = XOpenDisplay(nullptr);
+    if (!d->display) {
+        qDebug() << "焦点监听无法连接 X 服务器";
+        return false;
+    }
+
+    d->root = DefaultRootWindow(d->display);
+    // only_if_exists：窗口管理器不支持 EWMH 时该原子不存在，监听没有意义
+    d->netActiveWindow = XInternAtom(d->display, "_NET_ACTIVE_WINDOW", True);
+    if (d->netActiveWindow == None) {
+        qDebug() << "窗口管理器不支持 _NET_ACTIVE_WINDOW，焦点监听不可用";
+        XCloseDisplay(d->display);
+        d->display = nullptr;
+        return false;
+    }
+
+    XSelectInput(d->display, d->root, PropertyChangeMask);
+    XFlush(d->display);
+
+    m_notifier = new QSocketNotifier(ConnectionNumber(d->display), QSocketNotifier::Read, this);
+    // Qt 5.15 起 activated 有两个重载，这里用字符串形式连接以兼容各版本
+    connect(m_notifier, SIGNAL(activated(int)), this, SLOT(processEvents()));
+
+    qDebug() << "X11 焦点监听已启动";
+    return true;
+}
+
+void X11FocusTracker::stop()
+{
+    if (!d->display) {
+        return;
+    }
+
+    delete m_notifier;
+    m_notifier = nullptr;
+
+    XCloseDisplay(d->display);
+    d->display = nullptr;
+}
+
+bool X11FocusTracker::isActive() const
+{
+    return d->display != nullptr;
+}
+
+void X11FocusTracker::processEvents()
+{
+    // Xlib 可能一次读入多个事件并缓存在队列中，必须全部取完，
+    // 否则 socket 上已无数据，剩余事件要等到下一次通知才会被处理
+    bool changed = false;
+    while (XPending(d->display) > 0) {
+        XEvent event;
+        XNextEvent(d->display, &event);
+        if (event.type == PropertyNotify && event.xproperty.atom == d->netActiveWindow) {
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        emit activeWindowChanged();
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef X11FOCUSTRACKER_H
+#define X11FOCUSTRACKER_H
+
+#include "focustracker.h"
+
+class QSocketNotifier;
+
+// X11 前台窗口监听
+// 在根窗口上订阅 PropertyNotify，窗口管理器更新 _NET_ACTIVE_WINDOW 时收到通知。
+// 使用独立的 Display 连接，其 socket 交给 Qt 事件循环监视，空闲时不占用 CPU。
+class X11FocusTracker : public FocusTracker
+{
+    Q_OBJECT
+
+public:
+    explicit X11FocusTracker(QObject *parent = nullptr);
+    ~X11FocusTracker() override;
+
+    bool start() override;
+    void stop() override;
+    bool isActive() const override;
+
+private slots:
+    // 读取并处理连接上所有待处理的事件
+    void processEvents();
+
+private:
+
+    // X11 头文件中的宏会与 Qt 冲突，相关类型只放在 .cpp 中
+    struct Private;
+    Private *d;
+    QSocketNotifier *m_notifier;   // 监视 X 连接的可读事件
+};
+
+#endif // X11FOCUSTRACKER_H
@@ -2,17 +2,114 @@
 #define COMMON_H
 
 #include <QString>
+#include <QByteArray>
 #include <QDateTime>
-#include <QPixmap>
+#include <QImage>
 #include <QIcon>
+#include <QHash>
+#include <QMap>
+#include <QMetaType>
+
+// 截图数据在段存储中的位置
+struct FrameRef {
+    quint32 segment = 0;     // 段编号（段从 1 开始编号，0 表示不在段存储中）
+    quint64 offset = 0;      // 数据在段文件中的偏移
+    quint32 length = 0;      // 数据长度
+
+    bool isValid() const { return segment != 0 && length != 0; }
+};
+
+// 段存储中一个旧段被压缩或删除后截图位置的变化
+// 时间范围内、位于该段中的记录按旧数据偏移查找新位置；removed 为真或新位置无效时截图已删除
+struct FrameRelocation {
+    quint32 segment = 0;     // 段编号
+    qint64 fromMs = 0;       // 段中记录的时间范围（含两端）
+    qint64 toMs = 0;
+    bool removed = false;    // 整段已删除
+    QHash<quint64, FrameRef> moves; // 旧数据偏移 -> 新位置
+};
+
+Q_DECLARE_METATYPE(FrameRelocation)
 
 // 应用记录结构体
 struct AppRecord {
     QString appName;
     QDateTime timestamp;
-    QPixmap screenshot;
+    QImage screenshot;       // 使用 QImage，可以在工作线程中创建和传递；历史记录中为空
+    QByteArray encodedScreenshot; // JPEG 压缩后的截图，历史记录只保存这一份
     QString appPath;
     QString windowTitle;
+    QByteArray frameKey;     // 帧存储中的内容键（像素 SHA-256），未启用去重时为空
+    quint64 perceptualHash = 0; // 感知哈希（dHash），相似画面的汉明距离小，可用于聚类
+    FrameRef frameRef;       // 截图在段存储中的位置，保存格式不是段存储时无效
+
+    // 截图：有原图时直接返回，否则按需解码压缩数据
+    QImage image() const {
+        if (!screenshot.isNull() || encodedScreenshot.isEmpty()) {
+            return screenshot;
+        }
+        return QImage::fromData(encodedScreenshot, "JPEG");
+    }
+};
+
+Q_DECLARE_METATYPE(AppRecord)
+
+// 编码积压已满时的处理策略
+enum class BacklogPolicy {
+    Block,      // 阻塞提交方，直到有空位
+    DropNewest  // 丢弃新提交的任务
+};
+
+// 近似重复帧（感知哈希汉明距离不超过阈值）的处理策略
+enum class NearDuplicatePolicy {
+    Keep,       // 照常记录，只保存感知哈希
+    Suppress,   // 跳过该帧，与画面未变化相同
+    Merge       // 记录该时刻，但沿用上一帧的截图，不重新编码和保存
+};
+
+// 自动保存的格式
+enum class SaveFormat {
+    Frames,     // 每张截图一个 JPEG（按内容去重）
+    Segments,   // 追加写入少量大的段文件，带索引
+    Timeline    // 每次录制一个时间线文件，关键帧加变化图块
+};
+
+// 截图配置结构体
+struct ScreenshotConfig {
+    int captureInterval = 5000;    // 截图间隔（毫秒，关闭自适应调度时使用）
+    bool adaptiveCapture = true;   // 根据画面变化和输入活动自动调整截图间隔
+    int minCaptureInterval = 2000; // 自适应调度最小间隔（毫秒）
+    int maxCaptureInterval = 60000; // 自适应调度最大间隔（毫秒）
+    int switchCaptureDelay = 500;  // 应用切换后补拍的防抖延迟（毫秒）
+    int imageQuality = 85;         // 图像质量（1-100）
+    QString savePath = "./screenshots/"; // 保存路径
+    bool autoSave = false;         // 是否自动保存
+    bool deduplicateFrames = true; // 自动保存时按像素内容去重，相同画面只保存一份
+    SaveFormat saveFormat = SaveFormat::Segments; // 自动保存的格式
+    qint64 segmentMaxBytes = 256 * 1024 * 1024; // 段文件大小上限，超过后滚动到新段
+    int segmentMaxAgeMinutes = 60; // 段文件时长上限（分钟）
+    int segmentSyncBatch = 16;     // 段存储每累计多少条记录 fsync 一次
+    int segmentSyncIntervalMs = 5000; // 段存储未提交记录的最长停留时间（毫秒）
+    int timelineKeyframeInterval = 30; // 时间线关键帧间隔（帧数），决定随机访问的最大解码量
+    bool retentionEnabled = true;  // 按保留策略在后台清理和压缩自动保存的截图
+    int retentionMaxAgeDays = 90;  // 截图最长保留天数（0 表示不限）
+    qint64 retentionMaxBytes = qint64(20) * 1024 * 1024 * 1024; // 自动保存的总字节上限（0 表示不限）
+    QMap<QString, qint64> retentionAppQuotas; // 应用名 -> 该应用截图的字节上限
+    int retentionDownscaleAfterDays = 7; // 超过多少天的截图缩小保存（0 表示不缩小）
+    int retentionDownscaleWidth = 1280;  // 缩小后的最大宽度（像素）
+    int retentionDownscaleQuality = 60;  // 缩小后重新压缩的 JPEG 质量
+    int retentionIntervalMinutes = 30;   // 保留策略的执行间隔（分钟）
+    int maxCacheSize = 100;        // 最大缓存数量
+    qint64 recordMemoryBudget = 256 * 1024 * 1024; // 内存中历史记录的字节上限（压缩后）
+    bool skipUnchanged = true;     // 画面未变化时跳过记录和保存
+    int changeTileSize = 64;       // 变化检测图块边长（像素）
+    double changeThreshold = 0.0;  // 变化图块占比阈值（0 表示任意变化都记录）
+    NearDuplicatePolicy nearDuplicatePolicy = NearDuplicatePolicy::Keep; // 近似重复帧的处理策略
+    int nearDuplicateDistance = 4; // 近似重复的汉明距离阈值（0-64）
+    int pipelineQueueSize = 4;     // 截图流水线各阶段队列容量
+    int encoderThreads = 2;        // JPEG 编码线程数
+    int encoderBacklog = 8;        // JPEG 编码最大积压数
+    BacklogPolicy encoderPolicy = BacklogPolicy::DropNewest; // 编码积压已满时的策略
 };
 
 #endif // COMMON_H 
\ No newline at end of file
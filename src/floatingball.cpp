@@ -8,6 +8,13 @@
 #include <QMessageBox>
 #include <QDebug> // Added for qDebug
 
+namespace {
+
+// 左上角应用图标的绘制尺寸，与 IconStore::BallIconSize 一致
+const int kAppIconSize = 24;
+
+} // namespace
+
 // 构造函数
 FloatingBall::FloatingBall(QWidget *parent)
     : QWidget(parent)
@@ -144,9 +151,20 @@ bool FloatingBall::isBallVisible() const
 }
 
 void FloatingBall::setAppIcon(const QIcon &icon)
+{
+    setAppIcon(icon, QPixmap());
+}
+
+void FloatingBall::setAppIcon(const QIcon &icon, const QPixmap &prerendered)
 {
     qDebug() << "设置应用图标:" << (icon.isNull() ? "空图标" : "有效图标");
     m_appIcon = icon;
+    m_appIconPixmap = prerendered;
+    
+    // 没有预渲染的位图时只在设置时渲染一次，避免每次重绘都缩放
+    if (m_appIconPixmap.isNull() && !m_appIcon.isNull()) {
+        m_appIconPixmap = m_appIcon.pixmap(QSize(kAppIconSize, kAppIconSize));
+    }
     update();
 }
 
@@ -194,12 +212,9 @@ void FloatingBall::paintEvent(QPaintEvent *event)
         }
     }
     // 左上角绘制应用图标
-    if (!m_appIcon.isNull()) {
-        int iconSize = 24;
-        QRect iconRect(2, 2, iconSize, iconSize);
-        
-        // 直接绘制图标，不添加背景
-        m_appIcon.paint(&painter, iconRect);
+    if (!m_appIconPixmap.isNull()) {
+        // 直接绘制预渲染的位图，不添加背景
+        painter.drawPixmap(QRect(2, 2, kAppIconSize, kAppIconSize), m_appIconPixmap);
     }
 }
 
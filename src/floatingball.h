@@ -75,6 +75,7 @@ public:
     bool isBallVisible() const;
 
     void setAppIcon(const QIcon &icon);
+    void setAppIcon(const QIcon &icon, const QPixmap &prerendered); // 使用已按绘制尺寸渲染好的位图
     QIcon getAppIcon() const;
 
 protected:
@@ -133,6 +134,7 @@ private:
     bool m_menuVisible;                       // 菜单是否正在显示
 
     QIcon m_appIcon; // 当前激活应用的图标
+    QPixmap m_appIconPixmap; // 按绘制尺寸渲染好的图标，绘制时不再缩放
 };
 
 #endif // FLOATINGBALL_H 
\ No newline at end of file
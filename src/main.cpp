@@ -48,7 +48,10 @@ int main(int argc, char* argv[])
 
 	// 配置屏幕监控
 	ScreenshotConfig config;
-	config.captureInterval = 10000; // 10秒截图一次
+	config.adaptiveCapture = true;
+	config.minCaptureInterval = 2000;  // 画面变化频繁时最快 2 秒截图一次
+	config.maxCaptureInterval = 10000; // 画面静止时最慢 10 秒截图一次
+	config.captureInterval = 10000;    // 关闭自适应调度时 10 秒截图一次
 	config.autoSave = true;
 	config.savePath = "./screenshots/";
 	config.imageQuality = 85;
@@ -65,11 +68,11 @@ int main(int argc, char* argv[])
 		[ball](const QString& appName, const AppInfo& appInfo) {
 			qDebug() << "应用信息更新完成:" << appName;
 			// 设置悬浮球左上角图标
-			ball->setAppIcon(appInfo.appIcon);
+			ball->setAppIcon(appInfo.appIcon, appInfo.ballIcon);
 		});
 
 	QObject::connect(screenMonitor, &ScreenMonitor::screenshotCaptured,
-		[settingsDialog](const QString& appName, const QPixmap& screenshot) {
+		[settingsDialog](const QString& appName, const QImage& screenshot) {
 			qDebug() << "截图完成:" << appName << "尺寸:" << screenshot.size();
 
 			// 预留：这里可以添加截图处理逻辑
@@ -103,31 +106,12 @@ int main(int argc, char* argv[])
 		[screenMonitor](const QStringList& filteredApps) {
 			qDebug() << "应用过滤列表已更新:" << filteredApps;
 			
-			// 清除现有的应用过滤器
-			QStringList currentFilters = screenMonitor->getAppFilters();
-			for (const QString& filter : currentFilters) {
-				screenMonitor->removeAppFilter(filter);
-			}
-			
-			// 添加新的应用过滤器（排除这些应用）
-			for (const QString& appName : filteredApps) {
-				screenMonitor->addAppFilter(appName, true); // true 表示排除
-			}
+			// 整体替换应用过滤规则（默认排除，支持通配符、正则和标题规则）
+			screenMonitor->setAppFilters(filteredApps);
 			
 			qDebug() << "已更新 ScreenMonitor 的应用过滤器";
 		});
 
-	// 连接记录管理信号
-	QObject::connect(screenMonitor, &ScreenMonitor::appRecordAdded,
-		[settingsDialog](const AppRecord& record) {
-			settingsDialog->addAppRecord(record);
-		});
-
-	QObject::connect(screenMonitor, &ScreenMonitor::appRecordsCleared,
-		[settingsDialog]() {
-			settingsDialog->clearAppRecords();
-		});
-
 	// 连接信号槽
 	QObject::connect(trayIcon, &TrayIcon::exitRequested, [&app]() {
 		app.quit();
@@ -11,48 +11,153 @@
 #include <QFile>
 #include <QTextStream>
 #include <QStyle> // 添加QStyle头文件
+#include "capture/framekernels.h"
+#include "capture/capturepipeline.h"
+#include <cstring>
 
 // Windows API 头文件
+#ifdef _WIN32
 #include <windows.h>
-#include <psapi.h>
-#include <tlhelp32.h>
 #include <shellapi.h>
+#endif
 
 ScreenMonitor::ScreenMonitor(QObject *parent)
     : QObject(parent)
     , m_appCheckTimer(nullptr)
-    , m_screenshotTimer(nullptr)
+    , m_focusTracker(nullptr)
+    , m_scheduler(nullptr)
     , m_currentActiveApp("")
     , m_lastActiveApp("")
     , m_isMonitoring(false)
     , m_screenshotCounter(0)
     , m_floatingBall(nullptr)
+    , m_backend(nullptr)
+    , m_pipeline(nullptr)
+    , m_timelineEncoder(nullptr)
+    , m_exporter(nullptr)
+    , m_retention(nullptr)
 {
+    qRegisterMetaType<AppRecord>("AppRecord");
+    qRegisterMetaType<ChangeResult>("ChangeResult");
+    
     initializeMonitoring();
 }
 
 ScreenMonitor::~ScreenMonitor()
 {
     stopMonitoring();
+    // 导出和保留任务会访问流水线的存储，先于流水线结束
+    delete m_exporter;
+    m_exporter = nullptr;
+    delete m_retention;
+    m_retention = nullptr;
+    if (m_metadataCache.isDirty()) {
+        m_metadataCache.save(ProcessMetadataCache::defaultCacheFile());
+    }
+    if (m_iconStore.isDirty()) {
+        m_iconStore.save();
+    }
+    if (m_pipeline && m_pipeline->frameStore()->isDirty()) {
+        m_pipeline->frameStore()->save();
+    }
+    m_recordIndex.close();
+    delete m_backend;
 }
 
 void ScreenMonitor::initializeMonitoring()
 {
+    // 创建平台截图后端
+    m_backend = CaptureBackend::create();
+    if (m_backend && !m_backend->isAvailable()) {
+        delete m_backend;
+        m_backend = nullptr;
+    }
+    if (m_backend) {
+        qDebug() << "截图后端:" << m_backend->name();
+    } else {
+        qDebug() << "当前平台没有可用的截图后端，无法获取激活窗口";
+    }
+    qDebug() << "帧比较内核:" << FrameKernels::isaName(FrameKernels::activeIsa());
+    
+    // 上次运行留下的进程元数据，应用切换时不必重新提取图标和版本信息
+    m_metadataCache.load(ProcessMetadataCache::defaultCacheFile());
+    m_iconStore.open(IconStore::defaultAtlasFile(), qApp->devicePixelRatio());
+    
+    // 前台窗口切换由窗口系统通知；不可用时退回每秒轮询
+    m_focusTracker = FocusTracker::create(this);
+    if (m_focusTracker) {
+        connect(m_focusTracker, &FocusTracker::activeWindowChanged, this, &ScreenMonitor::checkActiveApplication);
+    }
+    
     // 初始化定时器
     m_appCheckTimer = new QTimer(this);
     m_appCheckTimer->setInterval(1000); // 每秒检查一次激活应用
     connect(m_appCheckTimer, &QTimer::timeout, this, &ScreenMonitor::checkActiveApplication);
     
-    m_screenshotTimer = new QTimer(this);
-    connect(m_screenshotTimer, &QTimer::timeout, this, &ScreenMonitor::captureScreenshot);
+    m_scheduler = new AdaptiveScheduler(this);
+    if (m_backend) {
+        CaptureBackend *backend = m_backend;
+        m_scheduler->setInputIdleSource([backend]() { return backend->inputIdleTime(); });
+    }
+    applySchedulerConfig();
+    connect(m_scheduler, &AdaptiveScheduler::captureRequested, this, &ScreenMonitor::captureScreenshot);
+    
+    // 截图流水线，完成通知以排队方式回到 GUI 线程
+    m_pipeline = new CapturePipeline(this);
+    m_pipeline->setConfig(m_config);
+    connect(m_pipeline, &CapturePipeline::frameAccepted, this, &ScreenMonitor::onFrameAccepted);
+    connect(m_pipeline, &CapturePipeline::frameUnchanged, this, [this](const QString &) {
+        m_scheduler->reportFrame(false, 0.0);
+    });
+    connect(m_pipeline, &CapturePipeline::frameSaved, this, [this](const QString &filePath, qint64 bytes) {
+        qDebug() << "Screenshot saved:" << filePath << bytes << "bytes";
+        emit screenshotSaved(filePath);
+    });
+    connect(m_pipeline, &CapturePipeline::errorOccurred, this, &ScreenMonitor::errorOccurred);
+    connect(m_pipeline, &CapturePipeline::frameStoreOpened, this, &ScreenMonitor::reconcileFrameRefs);
+    
+    // 内存中的记录持有帧存储的引用（段存储中的记录不占用），被淘汰或清空时释放
+    FrameStore *frameStore = m_pipeline->frameStore();
+    m_records.setReleaseHandler([frameStore](const AppRecord &record) {
+        if (!record.frameKey.isEmpty() && !record.frameRef.isValid()) {
+            frameStore->release(record.frameKey);
+        }
+    });
+    
+    m_timelineEncoder = new TimelineEncoder(this);
+    connect(m_timelineEncoder, &TimelineEncoder::errorOccurred, this, &ScreenMonitor::errorOccurred);
+    
+    m_exporter = new RecordExporter(this);
+    connect(m_exporter, &RecordExporter::progress, this, &ScreenMonitor::exportProgress);
+    connect(m_exporter, &RecordExporter::finished, this, &ScreenMonitor::exportFinished);
+    connect(m_exporter, &RecordExporter::errorOccurred, this, &ScreenMonitor::errorOccurred);
+    
+    // 保留策略在最低优先级的线程中执行，旧段压缩或删除后同步更新记录索引中的截图位置
+    m_retention = new RetentionEngine(this);
+    m_retention->setStores(m_pipeline->segmentStore(), m_pipeline->frameStore(), m_config.savePath);
+    m_retention->setConfig(m_config);
+    connect(m_retention, &RetentionEngine::framesRelocated, this, [this](const FrameRelocation &relocation) {
+        int relocated = m_recordIndex.relocateFrames(relocation);
+        qDebug() << "段" << relocation.segment << (relocation.removed ? "已删除" : "已压缩")
+                 << "，更新记录索引" << relocated << "条";
+    });
+    connect(m_retention, &RetentionEngine::errorOccurred, this, &ScreenMonitor::errorOccurred);
+    m_retention->start();
+    
+    // 显示器布局，插拔或调整分辨率时更新
+    updateScreens();
+    connect(qApp, &QGuiApplication::screenAdded, this, &ScreenMonitor::updateScreens);
+    connect(qApp, &QGuiApplication::screenRemoved, this, &ScreenMonitor::updateScreens);
     
     // 创建保存目录
     createSaveDirectory();
+    openRecordIndex();
     
     // 添加一些默认的应用过滤器
-    addAppFilter("explorer.exe", true);  // 排除资源管理器
-    addAppFilter("dwm.exe", true);       // 排除桌面窗口管理器
-    addAppFilter("taskmgr.exe", true);   // 排除任务管理器
+    setAppFilters(QStringList()
+                  << "explorer.exe"      // 排除资源管理器
+                  << "dwm.exe"           // 排除桌面窗口管理器
+                  << "taskmgr.exe");     // 排除任务管理器
 }
 
 void ScreenMonitor::startMonitoring()
@@ -62,8 +167,27 @@ void ScreenMonitor::startMonitoring()
     }
     
     m_isMonitoring = true;
-    m_appCheckTimer->start();
-    m_screenshotTimer->start(m_config.captureInterval);
+    m_pipeline->start();
+    
+    // 时间线格式：每次开始监控新建一个文件
+    if (m_config.autoSave && m_config.saveFormat == SaveFormat::Timeline) {
+        QString fileName = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + ".tlc";
+        if (m_timelineEncoder->open(QDir(m_config.savePath).filePath("timeline/" + fileName),
+                                    m_config.changeTileSize, m_config.timelineKeyframeInterval,
+                                    m_config.imageQuality)) {
+            m_retention->setActiveTimeline(m_timelineEncoder->filePath());
+        }
+    }
+    if (m_focusTracker && m_focusTracker->start()) {
+        qDebug() << "使用事件驱动的前台窗口监听";
+    } else {
+        qDebug() << "焦点监听不可用，退回定时轮询";
+        m_appCheckTimer->start();
+    }
+    m_scheduler->start();
+    
+    // 立即获取当前激活应用，不必等待第一次切换事件
+    checkActiveApplication();
     
     qDebug() << "Screen monitoring started";
 }
@@ -75,8 +199,26 @@ void ScreenMonitor::stopMonitoring()
     }
     
     m_isMonitoring = false;
+    if (m_focusTracker) {
+        m_focusTracker->stop();
+    }
     m_appCheckTimer->stop();
-    m_screenshotTimer->stop();
+    m_scheduler->stop();
+    m_pipeline->stop();
+    m_timelineEncoder->close();
+    m_retention->setActiveTimeline(QString());
+    
+    // 保存新解析的进程元数据
+    if (m_metadataCache.isDirty()) {
+        m_metadataCache.save(ProcessMetadataCache::defaultCacheFile());
+    }
+    if (m_iconStore.isDirty()) {
+        m_iconStore.save();
+    }
+    if (m_pipeline && m_pipeline->frameStore()->isDirty()) {
+        m_pipeline->frameStore()->save();
+    }
+    m_recordIndex.flush();
     
     qDebug() << "Screen monitoring stopped";
 }
@@ -90,13 +232,25 @@ void ScreenMonitor::setConfig(const ScreenshotConfig &config)
 {
     m_config = config;
     
-    // 如果正在监控，更新截图定时器间隔
-    if (m_isMonitoring && m_screenshotTimer) {
-        m_screenshotTimer->setInterval(m_config.captureInterval);
+    // 同步流水线配置（变化检测、编码质量、保存路径）
+    m_pipeline->setConfig(m_config);
+    
+    // 历史记录内存上限
+    m_records.setByteBudget(m_config.recordMemoryBudget);
+    
+    // 保留策略和单帧文件目录
+    m_retention->setStores(m_pipeline->segmentStore(), m_pipeline->frameStore(), m_config.savePath);
+    m_retention->setConfig(m_config);
+    
+    // 更新截图调度参数，正在监控时按新参数重新计时
+    applySchedulerConfig();
+    if (m_isMonitoring) {
+        m_scheduler->start();
     }
     
     // 创建保存目录
     createSaveDirectory();
+    openRecordIndex();
 }
 
 ScreenshotConfig ScreenMonitor::getConfig() const
@@ -106,42 +260,117 @@ ScreenshotConfig ScreenMonitor::getConfig() const
 
 void ScreenMonitor::addAppFilter(const QString &appName, bool exclude)
 {
-    m_appFilters[appName.toLower()] = exclude;
+    AppFilterRule rule = AppFilterRule::fromString(appName);
+    rule.exclude = exclude;
+    
+    QList<AppFilterRule> rules = m_filterEngine.rules();
+    if (!rules.contains(rule)) {
+        rules.append(rule);
+        m_filterEngine.setRules(rules);
+    }
+}
+
+void ScreenMonitor::setAppFilters(const QStringList &filters)
+{
+    // 整体替换，只编译一次
+    QList<AppFilterRule> rules;
+    for (const QString &filter : filters) {
+        AppFilterRule rule = AppFilterRule::fromString(filter);
+        if (!rule.pattern.isEmpty() && !rules.contains(rule)) {
+            rules.append(rule);
+        }
+    }
+    
+    QStringList errors = m_filterEngine.setRules(rules);
+    for (const QString &error : errors) {
+        emit errorOccurred("Invalid app filter rule: " + error);
+    }
 }
 
 void ScreenMonitor::removeAppFilter(const QString &appName)
 {
-    m_appFilters.remove(appName.toLower());
+    AppFilterRule target = AppFilterRule::fromString(appName);
+    QList<AppFilterRule> rules = m_filterEngine.rules();
+    
+    // 文本形式不含方向时，包含和排除规则都移除
+    int removed = 0;
+    for (int i = rules.size() - 1; i >= 0; --i) {
+        const AppFilterRule &rule = rules[i];
+        if (rule.field == target.field && rule.type == target.type
+            && rule.pattern.compare(target.pattern, Qt::CaseInsensitive) == 0) {
+            rules.removeAt(i);
+            removed++;
+        }
+    }
+    
+    if (removed > 0) {
+        m_filterEngine.setRules(rules);
+    }
 }
 
 QStringList ScreenMonitor::getAppFilters() const
 {
-    return m_appFilters.keys();
+    QStringList filters;
+    for (const AppFilterRule &rule : m_filterEngine.rules()) {
+        filters.append(rule.toString());
+    }
+    return filters;
 }
 
 QPixmap ScreenMonitor::captureCurrentWindow()
 {
-    HWND hwnd = GetForegroundWindow();
-    if (!hwnd) {
+    if (!grabCurrentWindow(m_captureBuffer)) {
         return QPixmap();
     }
     
+    return QPixmap::fromImage(m_captureBuffer);
+}
+
+bool ScreenMonitor::grabCurrentWindow(QImage &image)
+{
+    if (!m_backend) {
+        return false;
+    }
+    
+    WindowHandle window = m_backend->activeWindow();
+    if (!window) {
+        return false;
+    }
+    
     // 获取窗口矩形
-    RECT rect;
-    GetWindowRect(hwnd, &rect);
+    QRect windowRect = m_backend->windowRect(window);
+    if (windowRect.isEmpty()) {
+        return false;
+    }
     
-    // 使用Qt截图
-    QScreen *screen = QApplication::primaryScreen();
+    // 优先使用后端按显示器抓取到复用缓冲区
+    if (m_pipeline->multiScreenCapture()->grabRegion(windowRect, image)) {
+        return true;
+    }
+    
+    // 后端失败时退回Qt截图，使用窗口中心所在的屏幕（坐标相对于该屏幕）
+    QScreen *screen = QGuiApplication::screenAt(windowRect.center());
     if (!screen) {
-        return QPixmap();
+        screen = QApplication::primaryScreen();
+    }
+    if (!screen) {
+        return false;
     }
     
-    QRect windowRect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top);
-    return screen->grabWindow(0, windowRect.x(), windowRect.y(), windowRect.width(), windowRect.height());
+    QRect screenRect = screen->geometry();
+    image = screen->grabWindow(0, windowRect.x() - screenRect.x(), windowRect.y() - screenRect.y(),
+                               windowRect.width(), windowRect.height())
+                .toImage().convertToFormat(QImage::Format_RGB32);
+    return !image.isNull();
 }
 
 QPixmap ScreenMonitor::captureFullScreen()
 {
+    // 所有显示器并行抓取后拼接成一帧
+    if (m_pipeline->multiScreenCapture()->grabDesktop(m_captureBuffer)) {
+        return QPixmap::fromImage(m_captureBuffer);
+    }
+    
     QScreen *screen = QApplication::primaryScreen();
     if (!screen) {
         return QPixmap();
@@ -150,6 +379,28 @@ QPixmap ScreenMonitor::captureFullScreen()
     return screen->grabWindow(0);
 }
 
+QList<QImage> ScreenMonitor::captureAllScreens()
+{
+    QList<QImage> frames;
+    if (!m_pipeline->multiScreenCapture()->grabScreens(frames)) {
+        frames.clear();
+    }
+    return frames;
+}
+
+void ScreenMonitor::updateScreens()
+{
+    QList<QRect> screens = MultiScreenCapture::currentScreens();
+    m_pipeline->setScreens(screens);
+    
+    // 新增的屏幕也要跟踪几何变化
+    for (QScreen *screen : QGuiApplication::screens()) {
+        connect(screen, &QScreen::geometryChanged, this, &ScreenMonitor::updateScreens, Qt::UniqueConnection);
+    }
+    
+    qDebug() << "显示器布局:" << screens;
+}
+
 void ScreenMonitor::checkActiveApplication()
 {
     QString currentApp = getActiveApplication();
@@ -163,6 +414,11 @@ void ScreenMonitor::checkActiveApplication()
             updateAppInfo(currentApp);
         }
         
+        // 切换后补拍一次新应用的画面
+        if (!currentApp.isEmpty()) {
+            m_scheduler->notifyAppSwitch();
+        }
+        
         // 发送应用切换信号
         emit activeApplicationChanged(oldApp, currentApp);
         
@@ -172,52 +428,71 @@ void ScreenMonitor::checkActiveApplication()
 
 void ScreenMonitor::captureScreenshot()
 {
-    if (!m_isMonitoring || m_currentActiveApp.isEmpty()) {
+    if (!m_isMonitoring || m_currentActiveApp.isEmpty() || !m_backend) {
         return;
     }
     
-    // 检查是否应该截图这个应用
-    if (!shouldCaptureApp(m_currentActiveApp)) {
+    WindowHandle window = m_backend->activeWindow();
+    if (!window) {
         return;
     }
     
-    // 截图当前窗口
-    QPixmap screenshot = captureCurrentWindow();
-    if (screenshot.isNull()) {
-        emit errorOccurred("Failed to capture screenshot");
+    // 检查是否应该截图这个应用（标题规则使用当前标题，切换后标题可能已变化）
+    QString windowTitle = getWindowTitleFromWindow(window);
+    if (!shouldCaptureApp(m_currentActiveApp, windowTitle)) {
         return;
     }
     
+    // 只投递请求，截图、变化检测、编码和保存都在流水线工作线程中完成
+    const AppInfo &appInfo = m_appCache[m_currentActiveApp];
+    CaptureRequest request;
+    request.window = window;
+    request.appName = m_currentActiveApp;
+    request.appPath = appInfo.executablePath;
+    request.windowTitle = windowTitle;
+    request.requestTime = QDateTime::currentDateTime();
+    
+    if (!m_pipeline->submit(request)) {
+        qDebug() << "截图流水线繁忙，跳过本次截图";
+    }
+}
+
+void ScreenMonitor::onFrameAccepted(const AppRecord &record, const ChangeResult &change)
+{
+    m_lastChange = change;
+    m_scheduler->reportFrame(change.changed, change.changedRatio());
+    
     // 更新应用缓存
-    if (!m_appCache.contains(m_currentActiveApp)) {
+    if (!m_appCache.contains(record.appName)) {
         AppInfo appInfo;
-        appInfo.processName = m_currentActiveApp;
+        appInfo.processName = record.appName;
         appInfo.windowTitle = ""; // 可以后续获取
-        m_appCache[m_currentActiveApp] = appInfo;
+        m_appCache[record.appName] = appInfo;
     }
     
-    m_appCache[m_currentActiveApp].lastScreenshot = screenshot;
-    m_appCache[m_currentActiveApp].lastCaptureTime = QDateTime::currentDateTime();
-    
-    // 创建应用记录
-    AppRecord record;
-    record.appName = m_currentActiveApp;
-    record.timestamp = QDateTime::currentDateTime();
-    record.screenshot = screenshot;
-    record.appPath = m_appCache[m_currentActiveApp].executablePath;
-    record.windowTitle = m_appCache[m_currentActiveApp].windowTitle;
+    m_appCache[record.appName].lastScreenshot = record.screenshot;
+    m_appCache[record.appName].lastCaptureTime = record.timestamp;
     
-    // 添加到记录列表
-    m_appRecords.append(record);
+    // 时间线编码器在后台线程中与上一帧比较，只写入变化图块
+    if (m_timelineEncoder->isOpen() && !m_timelineEncoder->appendFrame(record)) {
+        qDebug() << "时间线编码积压已满，跳过一帧:" << record.appName;
+    }
     
-    // 限制记录数量，保持最新的100条记录
-    if (m_appRecords.size() > 100) {
-        m_appRecords.removeFirst();
+    // 自动保存时把元数据追加到记录索引，截图位置指向流水线已写入的存储。
+    // 引用去重帧的历史记录另外持有一个持久化引用，由保留策略释放
+    if (m_config.autoSave && m_recordIndex.isOpen()) {
+        if (!m_recordIndex.append(record)) {
+            emit errorOccurred("Failed to append record to history index: " + record.appName);
+        } else {
+            reconcileFrameRefs();
+        }
     }
     
-    // 自动保存
-    if (m_config.autoSave) {
-        saveScreenshot(screenshot, m_currentActiveApp);
+    // 添加到历史记录，只保留压缩数据，超出字节上限时淘汰最旧的记录
+    int evicted = m_records.append(record);
+    if (evicted > 0) {
+        qDebug() << "历史记录超出内存上限，淘汰" << evicted << "条，当前"
+                 << m_records.count() << "条 /" << m_records.byteSize() / 1024 << "KB";
     }
     
     // 清理旧缓存
@@ -226,96 +501,61 @@ void ScreenMonitor::captureScreenshot()
     }
     
     // 发送截图完成信号
-    emit screenshotCaptured(m_currentActiveApp, screenshot);
+    emit screenshotCaptured(record.appName, record.screenshot);
     
-    // 发送记录添加信号
-    emit appRecordAdded(record);
+    // 发送记录添加信号（不带原图，接收方按需解码）；界面直接订阅记录存储
+    emit appRecordAdded(*m_records.last());
     
     m_screenshotCounter++;
-    qDebug() << "Screenshot captured for" << m_currentActiveApp << "(" << m_screenshotCounter << ")";
+    qDebug() << "Screenshot captured for" << record.appName << "(" << m_screenshotCounter << ")";
 }
 
 QString ScreenMonitor::getActiveApplication()
 {
-    HWND hwnd = GetForegroundWindow();
-    if (!hwnd) {
-        return "";
-    }
-    
-    return getProcessNameFromWindow(hwnd);
-}
-
-QString ScreenMonitor::getProcessNameFromWindow(HWND hwnd)
-{
-    DWORD processId;
-    GetWindowThreadProcessId(hwnd, &processId);
-    
-    if (processId == 0) {
+    if (!m_backend) {
         return "";
     }
     
-    HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
-    if (!hProcess) {
+    WindowHandle window = m_backend->activeWindow();
+    if (!window) {
         return "";
     }
     
-    char processName[MAX_PATH];
-    if (GetModuleFileNameExA(hProcess, NULL, processName, MAX_PATH)) {
-        CloseHandle(hProcess);
-        QFileInfo fileInfo(QString::fromLocal8Bit(processName));
-        return fileInfo.fileName();
-    }
-    
-    CloseHandle(hProcess);
-    return "";
+    return getProcessNameFromWindow(window);
 }
 
-QString ScreenMonitor::getExecutablePathFromProcess(DWORD processId) const
+QString ScreenMonitor::getProcessNameFromWindow(WindowHandle window)
 {
-    HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, processId);
-    if (!hProcess) {
+    qint64 processId = m_backend->windowProcessId(window);
+    if (processId == 0) {
         return "";
     }
     
-    char processPath[MAX_PATH];
-    if (GetModuleFileNameExA(hProcess, NULL, processPath, MAX_PATH)) {
-        CloseHandle(hProcess);
-        return QString::fromLocal8Bit(processPath);
+    QString processPath = getExecutablePathFromProcess(processId);
+    if (processPath.isEmpty()) {
+        return "";
     }
     
-    CloseHandle(hProcess);
-    return "";
+    return QFileInfo(processPath).fileName();
 }
 
-bool ScreenMonitor::shouldCaptureApp(const QString &appName)
+QString ScreenMonitor::getExecutablePathFromProcess(qint64 processId) const
 {
-    QString lowerAppName = appName.toLower();
-    
-    // 检查是否在过滤列表中
-    if (m_appFilters.contains(lowerAppName)) {
-        return !m_appFilters[lowerAppName]; // 如果exclude为true，则不截图
+    if (!m_backend) {
+        return "";
     }
     
-    return true; // 默认截图
+    return m_backend->executablePath(processId);
 }
 
-void ScreenMonitor::saveScreenshot(const QPixmap &screenshot, const QString &appName)
+bool ScreenMonitor::shouldCaptureApp(const QString &appName, const QString &windowTitle)
 {
-    if (screenshot.isNull()) {
-        return;
-    }
-    
-    // 生成文件名
-    QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
-    QString fileName = QString("%1_%2.jpg").arg(appName).arg(timestamp);
-    QString filePath = m_config.savePath + fileName;
-    
-    // 保存图片
-    if (screenshot.save(filePath, "JPEG", m_config.imageQuality)) {
-        qDebug() << "Screenshot saved:" << filePath;
-    } else {
-        emit errorOccurred("Failed to save screenshot: " + filePath);
-    }
+    // 按进程名、可执行文件路径和窗口标题匹配编译好的过滤规则
+    AppFilterSubject subject;
+    subject.processName = appName;
+    subject.executablePath = m_appCache.value(appName).executablePath;
+    subject.windowTitle = windowTitle;
+    return m_filterEngine.shouldCapture(subject);
 }
 
 void ScreenMonitor::cleanupOldScreenshots()
@@ -344,6 +584,61 @@ void ScreenMonitor::cleanupOldScreenshots()
     }
 }
 
+void ScreenMonitor::openRecordIndex()
+{
+    // 保存路径变化时才重新打开，已有的索引只映射不解析
+    QString indexPath = QDir(QDir(m_config.savePath).filePath("index")).absolutePath();
+    if (m_recordIndex.isOpen() && m_recordIndex.rootPath() == indexPath) {
+        return;
+    }
+    if (!m_recordIndex.open(indexPath)) {
+        emit errorOccurred("Failed to open history index: " + indexPath);
+        return;
+    }
+    reconcileFrameRefs();
+}
+
+void ScreenMonitor::reconcileFrameRefs()
+{
+    // 记录索引中引用去重帧的记录各持有一个持久化引用。帧存储记着已计入的记录数，
+    // 这里补上其后的记录：平时只有刚追加的一条，异常退出后是引用计数保存之后追加的全部记录
+    FrameStore *frameStore = m_pipeline->frameStore();
+    if (!m_recordIndex.isOpen() || !frameStore->isOpen()) {
+        return;
+    }
+    // 运行中切换保存路径时两者先后打开，属于同一个保存路径时才对齐
+    if (QFileInfo(frameStore->rootPath()).absolutePath() != QFileInfo(m_recordIndex.rootPath()).absolutePath()) {
+        return;
+    }
+
+    const int count = m_recordIndex.count();
+    qint64 from = frameStore->indexedRecords();
+    if (from > count) {
+        // 记录索引末尾的记录在异常退出时丢失，它们的引用留到保留策略过期时释放
+        qDebug() << "记录索引短于帧存储已计入的记录数:" << count << "/" << from;
+        from = count;
+    }
+
+    const uchar empty[sizeof(RecordIndexEntry::frameKey)] = {};
+    int added = 0;
+    for (int i = int(from); i < count; ++i) {
+        RecordIndexEntry entry = m_recordIndex.entry(i);
+        if (entry.frameSegment != 0 || memcmp(entry.frameKey, empty, sizeof(empty)) == 0) {
+            continue;
+        }
+        QByteArray key = QByteArray(reinterpret_cast<const char *>(entry.frameKey), sizeof(entry.frameKey)).toHex();
+        if (frameStore->addPersistentRef(key, entry.timestampMs, m_recordIndex.appName(entry.appId))) {
+            added++;
+        }
+    }
+    // 先加引用再推进计数：与保留策略线程的保存交错时最多多计一个引用（帧晚些回收），不会少计
+    frameStore->setIndexedRecords(count);
+
+    if (count - from > 1) {
+        qDebug() << "帧存储补齐记录索引中的引用，记录" << (count - from) << "条，引用" << added << "个";
+    }
+}
+
 void ScreenMonitor::createSaveDirectory()
 {
     QDir dir(m_config.savePath);
@@ -356,6 +651,42 @@ void ScreenMonitor::createSaveDirectory()
     }
 }
 
+// 获取截图流水线各阶段统计
+QList<PipelineStageStats> ScreenMonitor::getPipelineStats() const
+{
+    return m_pipeline->getStats();
+}
+
+// 获取截图帧缓冲池统计
+FramePoolStats ScreenMonitor::getFramePoolStats() const
+{
+    return m_pipeline->framePoolStats();
+}
+
+// 获取自适应调度当前使用的截图间隔（毫秒）
+int ScreenMonitor::getCurrentCaptureInterval() const
+{
+    return m_scheduler->currentInterval();
+}
+
+void ScreenMonitor::applySchedulerConfig()
+{
+    m_scheduler->setAdaptive(m_config.adaptiveCapture);
+    m_scheduler->setFixedInterval(m_config.captureInterval);
+    m_scheduler->setIntervalRange(m_config.minCaptureInterval, m_config.maxCaptureInterval);
+    m_scheduler->setSwitchDelay(m_config.switchCaptureDelay);
+}
+
+QString ScreenMonitor::getTimelineFile() const
+{
+    return m_timelineEncoder->isOpen() ? m_timelineEncoder->filePath() : QString();
+}
+
+ChangeResult ScreenMonitor::getLastChangeResult() const
+{
+    return m_lastChange;
+}
+
 // 设置悬浮球引用
 void ScreenMonitor::setFloatingBall(QWidget *ball)
 {
@@ -375,62 +706,62 @@ AppInfo ScreenMonitor::getCurrentAppInfo() const
 // 获取窗口标题
 QString ScreenMonitor::getWindowTitle() const
 {
-    HWND hwnd = GetForegroundWindow();
-    if (!hwnd) {
+    if (!m_backend) {
         return "";
     }
     
-    return getWindowTitleFromWindow(hwnd);
+    return getWindowTitleFromWindow(m_backend->activeWindow());
 }
 
 // 获取应用图标
 QIcon ScreenMonitor::getAppIcon() const
 {
-    HWND hwnd = GetForegroundWindow();
-    if (!hwnd) {
+    if (!m_backend) {
         return QIcon();
     }
     
-    DWORD processId;
-    GetWindowThreadProcessId(hwnd, &processId);
+    WindowHandle window = m_backend->activeWindow();
+    if (!window) {
+        return QIcon();
+    }
     
+    qint64 processId = m_backend->windowProcessId(window);
     if (processId == 0) {
         return QIcon();
     }
     
-    return getAppIconFromProcess(processId);
+    // 优先使用图标库中预渲染的图标
+    QString executablePath = getExecutablePathFromProcess(processId);
+    ProcessMetadata metadata;
+    if (m_metadataCache.lookup(executablePath, metadata)) {
+        QIcon icon = m_iconStore.icon(executablePath, metadata.modifiedMs);
+        if (!icon.isNull()) {
+            return icon;
+        }
+    }
+    
+    return getAppIconFromPath(executablePath);
 }
 
 // 获取应用版本
 QString ScreenMonitor::getAppVersion() const
 {
-    QString executablePath = getExecutablePathFromProcess(GetCurrentProcessId());
+    QString executablePath = getExecutablePathFromProcess(QApplication::applicationPid());
     return getAppVersionFromPath(executablePath);
 }
 
 // 从窗口获取窗口标题
-QString ScreenMonitor::getWindowTitleFromWindow(HWND hwnd) const
+QString ScreenMonitor::getWindowTitleFromWindow(WindowHandle window) const
 {
-    if (!hwnd) {
+    if (!m_backend || !window) {
         return "";
     }
     
-    int length = GetWindowTextLengthW(hwnd);
-    if (length == 0) {
-        return "";
-    }
-    
-    wchar_t *buffer = new wchar_t[length + 1];
-    GetWindowTextW(hwnd, buffer, length + 1);
-    
-    QString title = QString::fromWCharArray(buffer);
-    delete[] buffer;
-    
-    return title;
+    return m_backend->windowTitle(window);
 }
 
 // 从进程获取应用图标
-QIcon ScreenMonitor::getAppIconFromProcess(DWORD processId) const
+QIcon ScreenMonitor::getAppIconFromProcess(qint64 processId) const
 {
     QString executablePath = getExecutablePathFromProcess(processId);
     return getAppIconFromPath(executablePath);
@@ -446,6 +777,7 @@ QIcon ScreenMonitor::getAppIconFromPath(const QString &executablePath) const
     
     qDebug() << "尝试获取图标，路径:" << executablePath;
     
+#ifdef _WIN32
     // 方法1：使用Windows API从可执行文件中提取图标
     SHFILEINFOW shfi = {0};
     DWORD_PTR result = SHGetFileInfoW(
@@ -518,6 +850,13 @@ QIcon ScreenMonitor::getAppIconFromPath(const QString &executablePath) const
     } else {
         qDebug() << "Windows API获取图标失败";
     }
+#else
+    // 方法1：按进程名从图标主题中查找
+    QIcon themeIcon = QIcon::fromTheme(QFileInfo(executablePath).baseName());
+    if (!themeIcon.isNull()) {
+        return themeIcon;
+    }
+#endif
     
     // 方法2：使用系统默认图标作为备用
     qDebug() << "使用系统默认图标";
@@ -555,6 +894,10 @@ QString ScreenMonitor::getAppVersionFromPath(const QString &executablePath) cons
         return "";
     }
     
+#ifndef _WIN32
+    // 非 Windows 平台的可执行文件没有统一的版本资源
+    return "";
+#else
     DWORD dwHandle = 0;
     DWORD dwSize = GetFileVersionInfoSizeW(
         reinterpret_cast<const wchar_t*>(executablePath.utf16()),
@@ -590,6 +933,30 @@ QString ScreenMonitor::getAppVersionFromPath(const QString &executablePath) cons
     DWORD revision = (pFileInfo->dwFileVersionLS >> 0) & 0xFFFF;
     
     return QString("%1.%2.%3.%4").arg(major).arg(minor).arg(build).arg(revision);
+#endif
+}
+
+// 解析可执行文件的版本和描述（代价较高，结果写入元数据缓存）
+ProcessMetadata ScreenMonitor::resolveProcessMetadata(const QString &appName, const QString &executablePath,
+                                                      qint64 processId) const
+{
+    ProcessMetadata metadata;
+    metadata.executablePath = executablePath;
+    
+    // Linux 下从 /proc 读取进程名和运行用户
+    bool fromProc = ProcessMetadataCache::resolveFromProc(processId, metadata);
+    
+    metadata.isSystemApp = metadata.isSystemApp || isSystemApplication(appName);
+    metadata.version = getAppVersionFromPath(executablePath);
+    
+    // 设置应用描述
+    if (metadata.isSystemApp) {
+        metadata.description = "系统应用";
+    } else if (!fromProc || metadata.description.isEmpty()) {
+        metadata.description = "用户应用";
+    }
+    
+    return metadata;
 }
 
 // 判断是否为系统应用
@@ -611,28 +978,42 @@ void ScreenMonitor::updateAppInfo(const QString &appName)
         return;
     }
     
-    HWND hwnd = GetForegroundWindow();
-    if (!hwnd) {
+    if (!m_backend) {
         return;
     }
     
-    DWORD processId;
-    GetWindowThreadProcessId(hwnd, &processId);
+    WindowHandle window = m_backend->activeWindow();
+    if (!window) {
+        return;
+    }
+    
+    qint64 processId = m_backend->windowProcessId(window);
     
     AppInfo &appInfo = m_appCache[appName];
     appInfo.processName = appName;
-    appInfo.windowTitle = getWindowTitleFromWindow(hwnd);
+    appInfo.windowTitle = getWindowTitleFromWindow(window);
     appInfo.executablePath = getExecutablePathFromProcess(processId);
     appInfo.processId = processId;
-    appInfo.isSystemApp = isSystemApplication(appName);
-    appInfo.appVersion = getAppVersionFromPath(appInfo.executablePath);
-    appInfo.appIcon = getAppIconFromProcess(processId);
     
-    // 设置应用描述
-    if (appInfo.isSystemApp) {
-        appInfo.appDescription = "系统应用";
-    } else {
-        appInfo.appDescription = "用户应用";
+    // 版本和描述按可执行文件缓存，同一程序只解析一次
+    ProcessMetadata metadata;
+    if (!m_metadataCache.lookup(appInfo.executablePath, metadata)) {
+        metadata = resolveProcessMetadata(appName, appInfo.executablePath, processId);
+        m_metadataCache.insert(metadata);
+    }
+    
+    appInfo.isSystemApp = metadata.isSystemApp;
+    appInfo.appVersion = metadata.version;
+    appInfo.appDescription = metadata.description;
+    
+    // 图标从图标库取预渲染好的位图，库中没有时才提取
+    if (!m_iconStore.contains(appInfo.executablePath, metadata.modifiedMs)) {
+        m_iconStore.insert(appInfo.executablePath, metadata.modifiedMs, getAppIconFromPath(appInfo.executablePath));
+    }
+    appInfo.appIcon = m_iconStore.icon(appInfo.executablePath, metadata.modifiedMs);
+    appInfo.ballIcon = m_iconStore.pixmap(appInfo.executablePath, metadata.modifiedMs, IconStore::BallIconSize);
+    if (appInfo.appIcon.isNull()) {
+        appInfo.appIcon = getAppIconFromPath(appInfo.executablePath);
     }
     
     qDebug() << "应用信息更新:" << appName;
@@ -646,22 +1027,116 @@ void ScreenMonitor::updateAppInfo(const QString &appName)
 } 
 
 // 记录管理方法
-QList<AppRecord> ScreenMonitor::getAppRecords() const
+RecordStore *ScreenMonitor::recordStore()
+{
+    return &m_records;
+}
+
+int ScreenMonitor::getAppRecordCount() const
+{
+    return m_records.count();
+}
+
+qint64 ScreenMonitor::getAppRecordBytes() const
 {
-    return m_appRecords;
+    return m_records.byteSize();
+}
+
+qint64 ScreenMonitor::getAppRecordByteBudget() const
+{
+    return m_records.byteBudget();
 }
 
 void ScreenMonitor::clearAppRecords()
 {
-    m_appRecords.clear();
+    // 清空时通过释放回调归还记录持有的帧引用
+    m_records.clear();
     emit appRecordsCleared();
     qDebug() << "应用记录已清空";
 }
 
-void ScreenMonitor::exportAppRecords(const QString &filePath)
+int ScreenMonitor::getHistoryCount() const
+{
+    return m_recordIndex.count();
+}
+
+AppRecord ScreenMonitor::getHistoryRecord(int index) const
+{
+    return m_recordIndex.record(index);
+}
+
+int ScreenMonitor::findHistoryRecord(const QDateTime &time) const
+{
+    return m_recordIndex.lowerBound(time.toMSecsSinceEpoch());
+}
+
+qint64 ScreenMonitor::getHistoryTimestamp(int index) const
+{
+    return m_recordIndex.timestampAt(index);
+}
+
+QString ScreenMonitor::getHistoryAppName(int index) const
+{
+    return m_recordIndex.appName(m_recordIndex.entry(index).appId);
+}
+
+QImage ScreenMonitor::loadHistoryScreenshot(const AppRecord &record) const
+{
+    if (!record.screenshot.isNull()) {
+        return record.screenshot;
+    }
+    QByteArray data = readHistoryFrame(record);
+    return data.isEmpty() ? QImage() : QImage::fromData(data, "JPEG");
+}
+
+QByteArray ScreenMonitor::readHistoryFrame(const AppRecord &record) const
 {
-    // 这里可以实现导出记录到文件的功能
-    // 暂时只是调试输出
-    qDebug() << "导出应用记录到:" << filePath;
-    qDebug() << "记录数量:" << m_appRecords.size();
-} 
\ No newline at end of file
+    // 段存储中的截图按位置直接读取
+    if (record.frameRef.isValid()) {
+        SegmentEntry entry;
+        entry.dataSegment = record.frameRef.segment;
+        entry.dataOffset = record.frameRef.offset;
+        entry.dataLength = record.frameRef.length;
+        return m_pipeline->segmentStore()->read(entry);
+    }
+    
+    // 去重的单帧文件按内容键定位
+    if (!record.frameKey.isEmpty()) {
+        QFile file(m_pipeline->frameStore()->blobPath(record.frameKey));
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    }
+    
+    return record.encodedScreenshot;
+}
+
+bool ScreenMonitor::exportAppRecords(const QString &filePath, const ExportOptions &options)
+{
+    // 截图读取在导出线程中执行，只用到线程安全的段存储和帧存储
+    RecordExporter::FrameLoader loader = [this](const AppRecord &record) {
+        return readHistoryFrame(record);
+    };
+    
+    // 记录索引只增不减，导出过程中新追加的记录不影响已有下标
+    if (m_recordIndex.count() > 0) {
+        const RecordIndex *index = &m_recordIndex;
+        return m_exporter->start(filePath, index->count(), [index](int i) {
+            return index->record(i);
+        }, loader, options);
+    }
+    
+    // 没有持久化历史时导出内存中记录的快照（只复制句柄，不复制记录）
+    QVector<RecordHandle> records = m_records.snapshot();
+    return m_exporter->start(filePath, records.size(), [records](int i) {
+        return *records.at(i);
+    }, loader, options);
+}
+
+void ScreenMonitor::cancelExport()
+{
+    m_exporter->cancel();
+}
+
+bool ScreenMonitor::isExporting() const
+{
+    return m_exporter->isRunning();
+}
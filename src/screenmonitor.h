@@ -12,33 +12,33 @@
 #include <QDateTime>
 #include <QIcon> // Added for QIcon
 #include "common.h" // Added for AppRecord
-
-// Windows API 前向声明
-#ifdef _WIN32
-#include <windows.h>
-#endif
+#include "capture/capturebackend.h"
+#include "capture/changedetector.h"
+#include "capture/capturepipeline.h"
+#include "capture/focustracker.h"
+#include "capture/adaptivescheduler.h"
+#include "capture/appfilterengine.h"
+#include "storage/recordstore.h"
+#include "storage/processmetadatacache.h"
+#include "storage/iconstore.h"
+#include "storage/timelinecodec.h"
+#include "storage/recordindex.h"
+#include "storage/recordexporter.h"
+#include "storage/retentionengine.h"
 
 // 应用信息结构体
 struct AppInfo {
     QString processName;      // 进程名
     QString windowTitle;      // 窗口标题
     QString executablePath;   // 可执行文件路径
-    QPixmap lastScreenshot;  // 最后截图
+    QImage lastScreenshot;   // 最后截图
     QDateTime lastCaptureTime; // 最后截图时间
     QIcon appIcon;           // 应用图标
+    QPixmap ballIcon;        // 按悬浮球尺寸预渲染的图标
     QString appVersion;      // 应用版本
     QString appDescription;  // 应用描述
-    DWORD processId;         // 进程ID
-    bool isSystemApp;        // 是否系统应用
-};
-
-// 截图配置结构体
-struct ScreenshotConfig {
-    int captureInterval = 5000;    // 截图间隔（毫秒）
-    int imageQuality = 85;         // 图像质量（1-100）
-    QString savePath = "./screenshots/"; // 保存路径
-    bool autoSave = false;         // 是否自动保存
-    int maxCacheSize = 100;        // 最大缓存数量
+    qint64 processId = 0;    // 进程ID
+    bool isSystemApp = false; // 是否系统应用
 };
 
 class ScreenMonitor : public QObject
@@ -58,19 +58,54 @@ public:
     void setConfig(const ScreenshotConfig &config);
     ScreenshotConfig getConfig() const;
 
-    // 应用管理
+    // 应用管理（规则语法见 AppFilterRule）
     void addAppFilter(const QString &appName, bool exclude = true);
     void removeAppFilter(const QString &appName);
+    void setAppFilters(const QStringList &filters);   // 整体替换，只编译一次
     QStringList getAppFilters() const;
 
-    // 记录管理
-    QList<AppRecord> getAppRecords() const;
+    // 记录管理（记录中只有压缩截图，用 AppRecord::image() 解码）
+    // 视图通过 recordStore() 共享同一份记录并订阅其变化，不各自保存副本
+    RecordStore *recordStore();
+    int getAppRecordCount() const;
+    qint64 getAppRecordBytes() const;        // 历史记录当前占用的字节数
+    qint64 getAppRecordByteBudget() const;   // 历史记录的字节上限
     void clearAppRecords();
-    void exportAppRecords(const QString &filePath);
+    
+    // 导出记录：元数据写入 filePath（JSONL 或 CSV），截图打包到同名 .tar。
+    // 有持久化历史时导出全部历史，否则导出内存中的记录；在后台流式执行，完成时发出 exportFinished
+    bool exportAppRecords(const QString &filePath, const ExportOptions &options = ExportOptions());
+    void cancelExport();
+    bool isExporting() const;
+    
+    // 持久化的历史记录（记录索引，跨重启保留，按下标随机访问，不含截图）
+    int getHistoryCount() const;
+    AppRecord getHistoryRecord(int index) const;
+    int findHistoryRecord(const QDateTime &time) const;          // 第一条不早于 time 的记录
+    qint64 getHistoryTimestamp(int index) const;                 // 只读取时间戳（毫秒），不构造整条记录
+    QString getHistoryAppName(int index) const;                  // 只读取应用名
+    QImage loadHistoryScreenshot(const AppRecord &record) const;  // 从段存储或帧存储中读取截图
+    QByteArray readHistoryFrame(const AppRecord &record) const;   // 截图的 JPEG 数据（线程安全，可在工作线程中调用）
 
     // 手动截图
     QPixmap captureCurrentWindow();
-    QPixmap captureFullScreen();
+    QPixmap captureFullScreen();          // 所有显示器拼接成一帧
+    QList<QImage> captureAllScreens();    // 每个显示器一帧，顺序与 QGuiApplication::screens() 一致
+    
+    // 最近一次截图的变化检测结果
+    ChangeResult getLastChangeResult() const;
+    
+    // 当前截图间隔（自适应调度时随活动度变化）
+    int getCurrentCaptureInterval() const;
+    
+    // 截图流水线各阶段的队列深度和延迟统计
+    QList<PipelineStageStats> getPipelineStats() const;
+    
+    // 截图帧缓冲池的分配次数和复用率
+    FramePoolStats getFramePoolStats() const;
+    
+    // 当前录制的时间线文件（保存格式为时间线且正在监控时有效）
+    QString getTimelineFile() const;
     
     // 设置悬浮球引用（用于截图时隐藏）
     void setFloatingBall(QWidget *ball);
@@ -89,12 +124,19 @@ signals:
     void appInfoUpdated(const QString &appName, const AppInfo &appInfo);
     
     // 截图完成信号
-    void screenshotCaptured(const QString &appName, const QPixmap &screenshot);
+    void screenshotCaptured(const QString &appName, const QImage &screenshot);
+    
+    // 截图已写入磁盘（自动保存）
+    void screenshotSaved(const QString &filePath);
     
     // 记录管理信号
     void appRecordAdded(const AppRecord &record);
     void appRecordsCleared();
     
+    // 导出进度和结果
+    void exportProgress(int done, int total);
+    void exportFinished(const QString &filePath, bool ok);
+    
     // 错误信号
     void errorOccurred(const QString &error);
 
@@ -102,29 +144,41 @@ private slots:
     // 定时器槽函数
     void checkActiveApplication();
     void captureScreenshot();
+    
+    // 显示器布局变化
+    void updateScreens();
+    
+    // 流水线完成通知（GUI 线程）
+    void onFrameAccepted(const AppRecord &record, const ChangeResult &change);
 
 private:
     // 私有方法
     void initializeMonitoring();
+    void applySchedulerConfig();
+    bool grabCurrentWindow(QImage &image);
     QString getActiveApplication();
-    QString getProcessNameFromWindow(HWND hwnd);
-    QString getExecutablePathFromProcess(DWORD processId) const;
-    bool shouldCaptureApp(const QString &appName);
-    void saveScreenshot(const QPixmap &screenshot, const QString &appName);
+    QString getProcessNameFromWindow(WindowHandle window);
+    QString getExecutablePathFromProcess(qint64 processId) const;
+    bool shouldCaptureApp(const QString &appName, const QString &windowTitle);
     void cleanupOldScreenshots();
     void createSaveDirectory();
+    void openRecordIndex();
+    void reconcileFrameRefs();
     
     // 新增的私有方法
-    QString getWindowTitleFromWindow(HWND hwnd) const;
-    QIcon getAppIconFromProcess(DWORD processId) const;
+    QString getWindowTitleFromWindow(WindowHandle window) const;
+    QIcon getAppIconFromProcess(qint64 processId) const;
     QIcon getAppIconFromPath(const QString &executablePath) const;
     QString getAppVersionFromPath(const QString &executablePath) const;
     bool isSystemApplication(const QString &appName) const;
+    ProcessMetadata resolveProcessMetadata(const QString &appName, const QString &executablePath,
+                                           qint64 processId) const;
     void updateAppInfo(const QString &appName);
 
     // 成员变量
-    QTimer *m_appCheckTimer;           // 应用检测定时器
-    QTimer *m_screenshotTimer;         // 截图定时器
+    QTimer *m_appCheckTimer;           // 应用检测定时器（焦点监听不可用时的轮询后备）
+    FocusTracker *m_focusTracker;      // 前台窗口变化监听（平台相关）
+    AdaptiveScheduler *m_scheduler;    // 截图调度器（按活动度调整间隔）
     
     QString m_currentActiveApp;        // 当前激活应用
     QString m_lastActiveApp;           // 上次激活应用
@@ -132,14 +186,25 @@ private:
     ScreenshotConfig m_config;         // 配置信息
     QMap<QString, AppInfo> m_appCache; // 应用缓存
     
-    QMap<QString, bool> m_appFilters;  // 应用过滤器（true=排除）
+    AppFilterEngine m_filterEngine;    // 应用过滤规则（编译后原子替换）
     
-    QList<AppRecord> m_appRecords;     // 应用记录列表
+    RecordStore m_records;             // 应用记录（压缩存储，按字节上限淘汰，各视图共享）
+    mutable ProcessMetadataCache m_metadataCache; // 进程元数据缓存（按可执行文件路径）
+    IconStore m_iconStore;             // 预渲染的应用图标（内存映射的图集）
+    RecordIndex m_recordIndex;         // 持久化的记录索引（内存映射，启动时不解析）
     
     bool m_isMonitoring;               // 是否正在监控
     int m_screenshotCounter;           // 截图计数器
     
     QWidget *m_floatingBall;           // 悬浮球引用
+    
+    CaptureBackend *m_backend;         // 截图后端（平台相关）
+    QImage m_captureBuffer;            // 截图缓冲区，尺寸不变时复用
+    CapturePipeline *m_pipeline;       // 截图流水线（采集/变化检测/编码/保存）
+    TimelineEncoder *m_timelineEncoder; // 时间线编码器（保存格式为时间线时使用）
+    RecordExporter *m_exporter;        // 记录导出（流式，内存占用固定）
+    RetentionEngine *m_retention;      // 自动保存截图的后台保留与压缩
+    ChangeResult m_lastChange;         // 最近一次变化检测结果
 };
 
 #endif // SCREENMONITOR_H 
\ No newline at end of file
@@ -1,11 +1,22 @@
 ﻿#include "recordingwidget.h"
+#include "../screenmonitor.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QDebug>
+#include <QFileDialog>
+#include <QItemSelectionModel>
 
 RecordingWidget::RecordingWidget(QWidget* parent)
 	: QWidget(parent)
+	, m_screenMonitor(nullptr)
+	, m_recordStore(nullptr)
+	, m_thumbnails(nullptr)
+	, m_prefetcher(nullptr)
+	, m_timeAxisView(nullptr)
+	, m_axisThumbnails(nullptr)
+	, m_historyOpen(false)
+	, m_syncingList(false)
 {
 	QVBoxLayout* layout = new QVBoxLayout(this);
 	layout->setContentsMargins(30, 30, 30, 30);
@@ -21,6 +32,19 @@ RecordingWidget::RecordingWidget(QWidget* parent)
 	descLabel->setWordWrap(true);
 	layout->addWidget(descLabel);
 
+	// 时间线文件
+	QHBoxLayout* timelineLayout = new QHBoxLayout();
+	m_openTimelineButton = new QPushButton("打开时间线...", this);
+	m_historyButton = new QPushButton("浏览历史记录", this);
+	m_historyButton->setEnabled(false);
+	m_liveButton = new QPushButton("返回实时记录", this);
+	m_liveButton->setVisible(false);
+	timelineLayout->addWidget(m_openTimelineButton);
+	timelineLayout->addWidget(m_historyButton);
+	timelineLayout->addWidget(m_liveButton);
+	timelineLayout->addStretch();
+	layout->addLayout(timelineLayout);
+
 	// 时间滑块区域
 	QHBoxLayout* timeLayout = new QHBoxLayout();
 	QLabel* timeTitle = new QLabel("时间轴:", this);
@@ -39,6 +63,12 @@ RecordingWidget::RecordingWidget(QWidget* parent)
 	timeLayout->addWidget(m_timeLabel);
 	layout->addLayout(timeLayout);
 
+	// 时间轴：横轴为真实时间，滚轮缩放、拖动平移，单击跳到最接近的记录
+	m_timeAxisView = new TimeAxisView(this);
+	m_timeAxisView->setFixedHeight(96);
+	m_timeAxisView->setIndex(&m_timeAxisIndex);
+	layout->addWidget(m_timeAxisView);
+
 	// 主体内容区域
 	QHBoxLayout* contentLayout = new QHBoxLayout();
 	contentLayout->setSpacing(20);
@@ -47,7 +77,13 @@ RecordingWidget::RecordingWidget(QWidget* parent)
 	QVBoxLayout* listLayout = new QVBoxLayout();
 	QLabel* listTitle = new QLabel("应用记录列表", this);
 	listTitle->setStyleSheet("font-size: 16px; font-weight: bold; color: #ffffff;");
-	m_appRecordsList = new QListWidget(this);
+	// 列表按需取行：行高统一时视图只为可见的行查询数据，十万条以上记录也不卡顿
+	m_recordModel = new RecordListModel(this);
+	m_appRecordsList = new QListView(this);
+	m_appRecordsList->setModel(m_recordModel);
+	m_appRecordsList->setUniformItemSizes(true);
+	m_appRecordsList->setSelectionMode(QAbstractItemView::SingleSelection);
+	m_appRecordsList->setEditTriggers(QAbstractItemView::NoEditTriggers);
 	m_appRecordsList->setMinimumWidth(300);
 	m_appRecordsList->setMinimumHeight(300);
 
@@ -79,106 +115,453 @@ RecordingWidget::RecordingWidget(QWidget* parent)
 
 	layout->addLayout(contentLayout);
 
+	// 截图在后台解码成详情区域大小的缩略图，拖动滑块时不阻塞界面
+	m_thumbnails = new ThumbnailCache(m_screenshotLabel->size(), this);
+	connect(m_thumbnails, &ThumbnailCache::thumbnailReady, this, &RecordingWidget::onThumbnailReady);
+	m_prefetcher = new ScrubPrefetcher(m_thumbnails, this);
+	m_axisThumbnails = new ThumbnailCache(QSize(96, 54), this);
+	m_timeAxisView->setThumbnailCache(m_axisThumbnails);
+	m_timeAxisView->setRecordLookup([this](int& index, qint64 ms) {
+		return timeAxisRecord(index, ms);
+	});
+
 	connect(m_timeSlider, &QSlider::valueChanged, this, &RecordingWidget::onTimeSliderChanged);
-	connect(m_appRecordsList, &QListWidget::currentRowChanged, this, &RecordingWidget::onAppRecordSelected);
+	connect(m_appRecordsList->selectionModel(), &QItemSelectionModel::currentRowChanged,
+		this, &RecordingWidget::onAppRecordSelected);
+	connect(m_openTimelineButton, &QPushButton::clicked, this, &RecordingWidget::onOpenTimelineClicked);
+	connect(m_historyButton, &QPushButton::clicked, this, &RecordingWidget::openHistory);
+	connect(m_liveButton, &QPushButton::clicked, this, &RecordingWidget::onLiveClicked);
+	connect(m_timeAxisView, &TimeAxisView::timeSelected, this, &RecordingWidget::onTimeAxisSelected);
 }
 
-void RecordingWidget::addAppRecord(const AppRecord& record)
+void RecordingWidget::setRecordStore(RecordStore* store)
 {
-	m_appRecords.append(record);
-	updateAppRecordsDisplay();
+	if (m_recordStore == store) {
+		return;
+	}
+	if (m_recordStore) {
+		disconnect(m_recordStore, nullptr, this, nullptr);
+	}
+
+	m_recordStore = store;
+	if (m_recordStore) {
+		connect(m_recordStore, &RecordStore::recordAppended, this, &RecordingWidget::onRecordAppended);
+		connect(m_recordStore, &RecordStore::recordsEvicted, this, &RecordingWidget::onRecordsEvicted);
+		connect(m_recordStore, &RecordStore::cleared, this, &RecordingWidget::onRecordsCleared);
+	}
+	if (!m_timeline.isOpen() && !m_historyOpen) {
+		resetRecordModel();
+	}
+	qDebug() << "订阅应用记录，数量:" << (m_recordStore ? m_recordStore->count() : 0);
 }
 
-void RecordingWidget::clearAppRecords()
+void RecordingWidget::setScreenMonitor(ScreenMonitor* monitor)
 {
-	m_appRecords.clear();
-	updateAppRecordsDisplay();
+	closeHistory();
+	m_screenMonitor = monitor;
+	m_historyButton->setEnabled(m_screenMonitor != nullptr);
+	setRecordStore(m_screenMonitor ? m_screenMonitor->recordStore() : nullptr);
 }
 
-void RecordingWidget::syncAppRecords(const QList<AppRecord>& records)
+void RecordingWidget::onRecordAppended(const RecordHandle& record, int evicted)
 {
-	m_appRecords.clear();
-	for (const AppRecord& record : records) {
-		m_appRecords.append(record);
+	Q_UNUSED(record);
+
+	// 浏览历史时新记录已写入记录索引，只追加新增的行；浏览时间线文件时不刷新显示
+	if (m_historyOpen) {
+		int from = m_recordModel->rowCount();
+		m_recordModel->appendRows(m_screenMonitor->getHistoryCount() - from);
+		m_timeAxisIndex.sourceAppended();
+		m_timeAxisView->update();
+		updateAppRecordsDisplay();
+	} else if (!m_timeline.isOpen()) {
+		removeHeadRecords(evicted);
+		m_recordModel->appendRows(1);
+		addTimeAxisRecords(m_recordModel->rowCount() - 1);
+		updateAppRecordsDisplay();
 	}
-	updateAppRecordsDisplay();
-	qDebug() << "同步应用记录，数量:" << records.size();
 }
 
-void RecordingWidget::onTimeSliderChanged(int value)
+void RecordingWidget::onRecordsEvicted(int count)
 {
-	if (value >= 0 && value < m_appRecords.size()) {
-		m_appRecordsList->setCurrentRow(value);
-		const AppRecord& record = m_appRecords[value];
-		m_timeLabel->setText(record.timestamp.toString("hh:mm:ss"));
-		
-		// 更新详情显示
-		if (!record.screenshot.isNull()) {
-			m_screenshotLabel->setPixmap(record.screenshot.scaled(350, 250, Qt::KeepAspectRatio));
-		} else {
-			m_screenshotLabel->setText("暂无截图");
-			m_screenshotLabel->setPixmap(QPixmap());
-		}
+	if (!m_timeline.isOpen() && !m_historyOpen) {
+		removeHeadRecords(count);
+		updateAppRecordsDisplay();
+	}
+}
+
+void RecordingWidget::onRecordsCleared()
+{
+	if (!m_timeline.isOpen() && !m_historyOpen) {
+		resetRecordModel();
+	}
+}
+
+void RecordingWidget::removeHeadRecords(int evicted)
+{
+	// 头部淘汰后下标整体前移，滑块跟着前移，仍停在同一条记录上（列表的当前行由模型自动调整）
+	if (evicted <= 0) {
+		return;
+	}
+	m_timeSlider->blockSignals(true);
+	m_timeSlider->setValue(qMax(0, m_timeSlider->value() - evicted));
+	m_timeSlider->blockSignals(false);
+	m_recordModel->removeHeadRows(evicted);
+
+	// 下标变了，按旧下标估计的拖动状态作废
+	m_prefetcher->reset();
+
+	// 时间轴删除剩余第一条记录之前的桶
+	if (m_recordModel->rowCount() > 0) {
+		m_timeAxisIndex.removeBefore(m_recordModel->record(0).timestamp.toMSecsSinceEpoch());
+	} else {
+		m_timeAxisIndex.clear();
+	}
+	m_timeAxisView->update();
+}
+
+void RecordingWidget::addTimeAxisRecords(int from)
+{
+	for (int i = from; i < m_recordModel->rowCount(); ++i) {
+		m_timeAxisIndex.add(i, m_recordModel->record(i));
+	}
+	m_timeAxisView->update();
+}
+
+bool RecordingWidget::openTimeline(const QString& filePath)
+{
+	// 解码线程可能正在使用当前的时间线文件，先等它们结束
+	m_thumbnails->reset();
+	m_axisThumbnails->reset();
+	if (!m_timeline.open(filePath)) {
+		resetRecordModel();
+		return false;
+	}
+
+	m_historyOpen = false;
+	m_timelineRecords.clear();
+	for (const AppRecord& record : m_timeline.records()) {
+		m_timelineRecords.append(record);
+	}
+	m_liveButton->setVisible(true);
+	resetRecordModel();
+	qDebug() << "浏览时间线:" << filePath << "帧数:" << m_timelineRecords.size();
+	return true;
+}
+
+void RecordingWidget::closeTimeline()
+{
+	m_thumbnails->reset();
+	m_axisThumbnails->reset();
+	m_timeline.close();
+	m_timelineRecords.clear();
+	m_liveButton->setVisible(m_historyOpen);
+	resetRecordModel();
+}
+
+bool RecordingWidget::openHistory()
+{
+	if (!m_screenMonitor) {
+		return false;
+	}
+
+	// 记录索引是映射的定长项，只取条数，不读取任何记录
+	m_thumbnails->reset();
+	m_axisThumbnails->reset();
+	m_timeline.close();
+	m_timelineRecords.clear();
+	m_historyOpen = true;
+	m_liveButton->setVisible(true);
+	resetRecordModel();
+
+	// 从最新的记录开始浏览
+	int count = m_recordModel->rowCount();
+	if (count > 0) {
+		m_timeSlider->setValue(count - 1);
+	}
+	qDebug() << "浏览历史记录，数量:" << count;
+	return true;
+}
+
+void RecordingWidget::closeHistory()
+{
+	if (!m_historyOpen) {
+		return;
+	}
+
+	m_historyOpen = false;
+	m_liveButton->setVisible(m_timeline.isOpen());
+	resetRecordModel();
+}
+
+void RecordingWidget::onLiveClicked()
+{
+	m_historyOpen = false;
+	closeTimeline();
+}
+
+void RecordingWidget::onOpenTimelineClicked()
+{
+	QString filePath = QFileDialog::getOpenFileName(this, "打开时间线", QString(), "时间线文件 (*.tlc)");
+	if (filePath.isEmpty()) {
+		return;
+	}
+
+	if (!openTimeline(filePath)) {
+		m_screenshotLabel->setPixmap(QPixmap());
+		m_screenshotLabel->setText("无法打开时间线文件");
+	}
+}
 
-		QString info = QString("应用: %1\n时间: %2\n路径: %3\n窗口标题: %4")
-			.arg(record.appName)
-			.arg(record.timestamp.toString("yyyy-MM-dd hh:mm:ss"))
-			.arg(record.appPath)
-			.arg(record.windowTitle);
-		m_appInfoLabel->setText(info);
+void RecordingWidget::onTimeSliderChanged(int value)
+{
+	if (value < 0 || value >= m_recordModel->rowCount()) {
+		return;
 	}
+
+	// 列表只滚动到对应的行，不重建任何内容
+	QModelIndex index = m_recordModel->index(value);
+	m_syncingList = true;
+	m_appRecordsList->selectionModel()->setCurrentIndex(index, QItemSelectionModel::ClearAndSelect);
+	m_syncingList = false;
+	m_appRecordsList->scrollTo(index);
+
+	showRecord(value);
 }
 
-void RecordingWidget::onAppRecordSelected(int index)
+void RecordingWidget::onAppRecordSelected(const QModelIndex& current)
 {
-	if (index >= 0 && index < m_appRecords.size()) {
-		const AppRecord& record = m_appRecords[index];
+	int index = current.row();
+	if (m_syncingList || !current.isValid() || index >= m_recordModel->rowCount()) {
+		return;
+	}
+
+	// 滑块位置不变时不会触发 valueChanged，这里直接显示
+	if (m_timeSlider->value() != index) {
 		m_timeSlider->setValue(index);
+	} else {
+		showRecord(index);
+	}
+	emit recordSelected(m_recordModel->record(index));
+}
 
-		if (!record.screenshot.isNull()) {
-			m_screenshotLabel->setPixmap(record.screenshot.scaled(350, 250, Qt::KeepAspectRatio));
-		} else {
-			m_screenshotLabel->setText("暂无截图");
-			m_screenshotLabel->setPixmap(QPixmap());
-		}
+void RecordingWidget::showRecord(int index)
+{
+	AppRecord record = m_recordModel->record(index);
+	m_timeLabel->setText(record.timestamp.toString("hh:mm:ss"));
+
+	// 缓存中有这一帧时直接显示；没有时先显示时间上最接近的缓存帧，解码完成后再换上
+	bool exact = false;
+	QImage thumbnail = m_thumbnails->request(index, record, &exact);
+	m_shownKey = ThumbnailCache::keyOf(record);
+	m_prefetcher->positionChanged(index);
+	m_timeAxisView->setCurrentTime(record.timestamp.toMSecsSinceEpoch());
+	if (!thumbnail.isNull()) {
+		showThumbnail(thumbnail);
+	} else if (!exact) {
+		m_screenshotLabel->setPixmap(QPixmap());
+		m_screenshotLabel->setText("正在加载截图...");
+	} else {
+		// 缓存记得这条记录没有截图，不会再解码
+		m_screenshotLabel->setPixmap(QPixmap());
+		m_screenshotLabel->setText("暂无截图");
+	}
 
-		QString info = QString("应用: %1\n时间: %2\n路径: %3")
-			.arg(record.appName)
-			.arg(record.timestamp.toString("yyyy-MM-dd hh:mm:ss"))
-			.arg(record.appPath);
-		m_appInfoLabel->setText(info);
+	QString info = QString("应用: %1\n时间: %2\n路径: %3\n窗口标题: %4")
+		.arg(record.appName)
+		.arg(record.timestamp.toString("yyyy-MM-dd hh:mm:ss"))
+		.arg(record.appPath)
+		.arg(record.windowTitle);
+	m_appInfoLabel->setText(info);
+}
 
-		emit recordSelected(record);
+void RecordingWidget::resetRecordModel()
+{
+	// 按当前浏览的来源重置模型和缩略图缓存，模型只保存取记录的函数
+	ThumbnailCache::ThumbnailLoader loader;
+	if (m_timeline.isOpen()) {
+		m_recordModel->setSource(m_timelineRecords.size(), [this](int index) {
+			return m_timelineRecords.value(index);
+		});
+		// 时间线中的帧从最近的关键帧开始解码，顺序拖动滑块时只需应用一个增量帧
+		loader = [this](int index, const AppRecord&, const QSize& size) {
+			QImage frame;
+			{
+				QMutexLocker locker(&m_timelineMutex);
+				frame = m_timeline.frame(index);
+			}
+			return ThumbnailCache::scaleToFit(frame, size);
+		};
+	} else if (m_historyOpen) {
+		// 历史记录从映射的索引中按下标读取，不在内存中保留
+		ScreenMonitor* monitor = m_screenMonitor;
+		m_recordModel->setSource(monitor->getHistoryCount(), [monitor](int index) {
+			return monitor->getHistoryRecord(index);
+		});
+		loader = [monitor](int, const AppRecord& record, const QSize& size) {
+			return ThumbnailCache::decodeScaled(monitor->readHistoryFrame(record), size);
+		};
+	} else if (m_recordStore) {
+		// 实时记录只复制共享句柄中的字段（隐式共享，不复制截图数据）
+		RecordStore* store = m_recordStore;
+		m_recordModel->setSource(store->count(), [store](int index) {
+			RecordHandle record = store->at(index);
+			return record ? *record : AppRecord();
+		});
+		loader = [](int, const AppRecord& record, const QSize& size) {
+			if (!record.encodedScreenshot.isEmpty()) {
+				return ThumbnailCache::decodeScaled(record.encodedScreenshot, size);
+			}
+			return ThumbnailCache::scaleToFit(record.screenshot, size);
+		};
+	} else {
+		m_recordModel->setSource(0, RecordListModel::RecordSource());
 	}
+	m_thumbnails->setLoader(loader);
+	m_axisThumbnails->setLoader(loader);
+	m_shownKey = ThumbnailKey();
+	RecordListModel* model = m_recordModel;
+	m_prefetcher->setSource(model->rowCount(), [model](int index) {
+		return model->record(index);
+	});
+
+	m_timeSlider->blockSignals(true);
+	m_timeSlider->setValue(0);
+	m_timeSlider->blockSignals(false);
+
+	// 实时记录和时间线的汇总逐条建立一次，之后随记录增量更新；
+	// 历史记录只在绘制时汇总可见范围内的桶，不逐条读取
+	m_timeAxisIndex.clear();
+	if (m_historyOpen) {
+		ScreenMonitor* monitor = m_screenMonitor;
+		TimeAxisSource source;
+		source.count = [monitor]() {
+			return monitor->getHistoryCount();
+		};
+		source.lowerBound = [monitor](qint64 ms) {
+			return monitor->findHistoryRecord(QDateTime::fromMSecsSinceEpoch(ms));
+		};
+		source.timestampAt = [monitor](int index) {
+			return monitor->getHistoryTimestamp(index);
+		};
+		source.appNameAt = [monitor](int index) {
+			return monitor->getHistoryAppName(index);
+		};
+		m_timeAxisIndex.setSource(source);
+		m_timeAxisView->update();
+	} else {
+		addTimeAxisRecords(0);
+	}
+	m_timeAxisView->setCurrentTime(-1);
+	m_timeAxisView->fitAll();
+	updateAppRecordsDisplay();
 }
 
 void RecordingWidget::updateAppRecordsDisplay()
 {
-	m_appRecordsList->clear();
-
-	if (m_appRecords.isEmpty()) {
+	// 只更新滑块范围和时间范围，列表行由模型增量插入和删除
+	int count = m_recordModel->rowCount();
+	m_prefetcher->setCount(count);
+	if (count == 0) {
 		m_timeSlider->setEnabled(false);
 		m_timeLabel->setText("暂无记录");
 		return;
 	}
 
 	m_timeSlider->setEnabled(true);
-	m_timeSlider->setRange(0, m_appRecords.size() - 1);
+	m_timeSlider->blockSignals(true);
+	m_timeSlider->setRange(0, count - 1);
+	m_timeSlider->blockSignals(false);
 
-	// 显示时间范围信息
-	QDateTime firstTime = m_appRecords.first().timestamp;
-	QDateTime lastTime = m_appRecords.last().timestamp;
+	// 显示时间范围信息（只读取首尾两项）
+	QDateTime firstTime = m_recordModel->record(0).timestamp;
+	QDateTime lastTime = m_recordModel->record(count - 1).timestamp;
 	QString timeRange = QString("%1 - %2")
 		.arg(firstTime.toString("hh:mm:ss"))
 		.arg(lastTime.toString("hh:mm:ss"));
 	m_timeLabel->setText(timeRange);
+}
 
-	for (const AppRecord& record : m_appRecords) {
-		QString itemText = QString("%1 - %2")
-			.arg(record.timestamp.toString("hh:mm:ss"))
-			.arg(record.appName);
-		m_appRecordsList->addItem(itemText);
+void RecordingWidget::onThumbnailReady(const ThumbnailKey& key, const QImage& thumbnail)
+{
+	// 只换上当前显示的那一条，拖动中途完成的旧帧已留在缓存里
+	if (key != m_shownKey) {
+		return;
 	}
-	
-	qDebug() << "更新应用记录显示，记录数量:" << m_appRecords.size();
+	if (thumbnail.isNull()) {
+		m_screenshotLabel->setPixmap(QPixmap());
+		m_screenshotLabel->setText("暂无截图");
+		return;
+	}
+	showThumbnail(thumbnail);
+}
+
+void RecordingWidget::onTimeAxisSelected(qint64 ms)
+{
+	int count = m_recordModel->rowCount();
+	if (count == 0) {
+		return;
+	}
+
+	// 第一条不早于 ms 的记录与前一条比较，取更近的
+	int index = qMin(findRecord(ms), count - 1);
+	if (index > 0) {
+		qint64 after = m_recordModel->record(index).timestamp.toMSecsSinceEpoch() - ms;
+		qint64 before = ms - m_recordModel->record(index - 1).timestamp.toMSecsSinceEpoch();
+		if (before <= after) {
+			index--;
+		}
+	}
+
+	if (m_timeSlider->value() != index) {
+		m_timeSlider->setValue(index);
+	} else {
+		showRecord(index);
+	}
+}
+
+int RecordingWidget::findRecord(qint64 ms) const
+{
+	// 历史记录直接在映射的索引中查找，不构造记录
+	if (m_historyOpen) {
+		return m_screenMonitor->findHistoryRecord(QDateTime::fromMSecsSinceEpoch(ms));
+	}
+
+	// 记录按时间顺序排列，二分查找第一条不早于 ms 的记录（都早于 ms 时返回记录数）
+	int low = 0;
+	int high = m_recordModel->rowCount();
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		if (m_recordModel->record(mid).timestamp.toMSecsSinceEpoch() < ms) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+AppRecord RecordingWidget::timeAxisRecord(int& index, qint64 ms) const
+{
+	// 下标仍指向这条记录时直接取；实时记录从头部淘汰后下标前移，按时间戳重新查找
+	if (index >= 0 && index < m_recordModel->rowCount()) {
+		AppRecord record = m_recordModel->record(index);
+		if (record.timestamp.toMSecsSinceEpoch() == ms) {
+			return record;
+		}
+	}
+	index = findRecord(ms);
+	if (index < m_recordModel->rowCount()) {
+		AppRecord record = m_recordModel->record(index);
+		if (record.timestamp.toMSecsSinceEpoch() == ms) {
+			return record;
+		}
+	}
+	return AppRecord();
+}
+
+void RecordingWidget::showThumbnail(const QImage& thumbnail)
+{
+	// 缩略图已是详情区域的大小，这里不再缩放
+	m_screenshotLabel->setPixmap(QPixmap::fromImage(thumbnail));
 }
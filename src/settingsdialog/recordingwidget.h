@@ -1,39 +1,90 @@
 ﻿#pragma once
 
 #include <QWidget>
-#include <QListWidget>
+#include <QListView>
 #include <QLabel>
 #include <QSlider>
+#include <QPushButton>
 #include <QPixmap>
 #include <QDateTime>
 #include <QVector>
+#include <QMutex>
 #include "../common.h"
+#include "../storage/recordstore.h"
+#include "../storage/timelinecodec.h"
+#include "recordlistmodel.h"
+#include "scrubprefetcher.h"
+#include "thumbnailcache.h"
+#include "timeaxisindex.h"
+#include "timeaxisview.h"
+
+class ScreenMonitor;
 
 class RecordingWidget : public QWidget {
 	Q_OBJECT
 public:
 	explicit RecordingWidget(QWidget* parent = nullptr);
 
-	void addAppRecord(const AppRecord& record);
-	void clearAppRecords();
-	void syncAppRecords(const QList<AppRecord>& records);
+	// 实时记录的来源：订阅共享的记录存储，按下标取句柄显示，不保存副本
+	void setRecordStore(RecordStore* store);
+
+	// 持久化历史记录的来源，设置后可以浏览记录索引中的全部历史（同时订阅其记录存储）
+	void setScreenMonitor(ScreenMonitor* monitor);
+
+	// 打开录制的时间线文件浏览，关闭后回到实时记录
+	bool openTimeline(const QString& filePath);
+	void closeTimeline();
+
+	// 浏览持久化的历史记录，列表只加载当前页，截图按需读取
+	bool openHistory();
+	void closeHistory();
 
 signals:
 	void recordSelected(const AppRecord& record);
 
 private slots:
 	void onTimeSliderChanged(int value);
-	void onAppRecordSelected(int index);
+	void onAppRecordSelected(const QModelIndex& current);
+	void onOpenTimelineClicked();
+	void onLiveClicked();
+	void onRecordAppended(const RecordHandle& record, int evicted);
+	void onRecordsEvicted(int count);
+	void onRecordsCleared();
+	void onThumbnailReady(const ThumbnailKey& key, const QImage& thumbnail);
+	void onTimeAxisSelected(qint64 ms);
 
 private:
+	void resetRecordModel();
 	void updateAppRecordsDisplay();
+	void removeHeadRecords(int evicted);
+	void addTimeAxisRecords(int from);
+	int findRecord(qint64 ms) const;
+	AppRecord timeAxisRecord(int& index, qint64 ms) const;
+	void showRecord(int index);
+	void showThumbnail(const QImage& thumbnail);
 
 private:
-	QListWidget* m_appRecordsList;
+	QListView* m_appRecordsList;
+	RecordListModel* m_recordModel;         // 列表模型（按需取行，不保存副本）
 	QLabel* m_timeLabel;
 	QSlider* m_timeSlider;
 	QLabel* m_screenshotLabel;
 	QLabel* m_appInfoLabel;
+	QPushButton* m_openTimelineButton;
+	QPushButton* m_historyButton;
+	QPushButton* m_liveButton;
+	ScreenMonitor* m_screenMonitor;
+	RecordStore* m_recordStore;             // 实时记录（与 ScreenMonitor 共享）
 
-	QVector<AppRecord> m_appRecords;
+	QVector<AppRecord> m_timelineRecords;   // 时间线文件中的记录（不含截图）
+	TimelineDecoder m_timeline;             // 时间线解码器，只在缩略图解码线程中使用
+	QMutex m_timelineMutex;                 // 保护 m_timeline 的解码状态
+	ThumbnailCache* m_thumbnails;           // 缩略图缓存（后台解码）
+	ScrubPrefetcher* m_prefetcher;          // 按拖动方向预取缩略图
+	TimeAxisIndex m_timeAxisIndex;          // 按时间分级汇总的记录
+	TimeAxisView* m_timeAxisView;           // 按真实时间缩放的时间轴
+	ThumbnailCache* m_axisThumbnails;       // 时间轴上代表帧的小缩略图
+	ThumbnailKey m_shownKey;                // 当前显示的记录的缩略图键
+	bool m_historyOpen;                     // 正在浏览持久化的历史记录
+	bool m_syncingList;                     // 正在按滑块位置设置列表当前行
 };
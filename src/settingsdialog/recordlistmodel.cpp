@@ -0,0 +1,111 @@
+﻿#include "recordlistmodel.h"
+
+RecordListModel::RecordListModel(QObject* parent)
+	: QAbstractListModel(parent)
+	, m_count(0)
+	, m_cachedRow(-1)
+{
+}
+
+void RecordListModel::setSource(int count, const RecordSource& source)
+{
+	beginResetModel();
+	m_source = source;
+	m_count = m_source ? qMax(0, count) : 0;
+	invalidateCache();
+	endResetModel();
+}
+
+void RecordListModel::appendRows(int count)
+{
+	if (count <= 0 || !m_source) {
+		return;
+	}
+
+	beginInsertRows(QModelIndex(), m_count, m_count + count - 1);
+	m_count += count;
+	endInsertRows();
+}
+
+void RecordListModel::removeHeadRows(int count)
+{
+	count = qMin(count, m_count);
+	if (count <= 0) {
+		return;
+	}
+
+	beginRemoveRows(QModelIndex(), 0, count - 1);
+	m_count -= count;
+	invalidateCache();
+	endRemoveRows();
+}
+
+AppRecord RecordListModel::record(int row) const
+{
+	if (row < 0 || row >= m_count) {
+		return AppRecord();
+	}
+	return cachedRecord(row);
+}
+
+int RecordListModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_count;
+}
+
+QVariant RecordListModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_count) {
+		return QVariant();
+	}
+
+	switch (role) {
+	case Qt::DisplayRole: {
+		const AppRecord& record = cachedRecord(index.row());
+		return QString("%1 - %2")
+			.arg(record.timestamp.toString("hh:mm:ss"))
+			.arg(record.appName);
+	}
+	case Qt::ToolTipRole: {
+		const AppRecord& record = cachedRecord(index.row());
+		return QString("%1\n%2")
+			.arg(record.timestamp.toString("yyyy-MM-dd hh:mm:ss"))
+			.arg(record.windowTitle);
+	}
+	case TimestampRole:
+		return cachedRecord(index.row()).timestamp;
+	case AppNameRole:
+		return cachedRecord(index.row()).appName;
+	case AppPathRole:
+		return cachedRecord(index.row()).appPath;
+	case WindowTitleRole:
+		return cachedRecord(index.row()).windowTitle;
+	default:
+		return QVariant();
+	}
+}
+
+QHash<int, QByteArray> RecordListModel::roleNames() const
+{
+	QHash<int, QByteArray> roles = QAbstractListModel::roleNames();
+	roles[TimestampRole] = "timestamp";
+	roles[AppNameRole] = "appName";
+	roles[AppPathRole] = "appPath";
+	roles[WindowTitleRole] = "windowTitle";
+	return roles;
+}
+
+const AppRecord& RecordListModel::cachedRecord(int row) const
+{
+	if (row != m_cachedRow) {
+		m_cachedRecord = m_source(row);
+		m_cachedRow = row;
+	}
+	return m_cachedRecord;
+}
+
+void RecordListModel::invalidateCache()
+{
+	m_cachedRow = -1;
+	m_cachedRecord = AppRecord();
+}
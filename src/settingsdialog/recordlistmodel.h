@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <functional>
+#include "../common.h"
+
+// 录制回想列表的数据模型
+// 只保存记录条数和按下标取记录的函数，不复制记录，也不预先生成显示文字：
+// 视图只为可见的行调用 data()，文字在此时才格式化。新记录只插入末尾一行，
+// 头部淘汰只删除对应的行，不会整体重建列表。
+class RecordListModel : public QAbstractListModel {
+	Q_OBJECT
+public:
+	enum Roles {
+		TimestampRole = Qt::UserRole + 1,   // QDateTime
+		AppNameRole,
+		AppPathRole,
+		WindowTitleRole
+	};
+
+	// 按下标取记录（在 GUI 线程中调用）
+	using RecordSource = std::function<AppRecord(int index)>;
+
+	explicit RecordListModel(QObject* parent = nullptr);
+
+	// 更换数据来源，重置整个模型
+	void setSource(int count, const RecordSource& source);
+
+	// 末尾新增 count 条
+	void appendRows(int count);
+
+	// 头部淘汰 count 条，其余行的下标前移
+	void removeHeadRows(int count);
+
+	AppRecord record(int row) const;
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	QHash<int, QByteArray> roleNames() const override;
+
+private:
+	// 视图绘制一行时会连续查询多个角色，缓存最近一行避免重复读取
+	const AppRecord& cachedRecord(int row) const;
+	void invalidateCache();
+
+	RecordSource m_source;
+	int m_count;
+	mutable int m_cachedRow;
+	mutable AppRecord m_cachedRecord;
+};
@@ -0,0 +1,150 @@
+﻿#include "scrubprefetcher.h"
+#include "thumbnailcache.h"
+#include <QList>
+#include <QPair>
+
+namespace {
+
+// 超过这个时间没有移动视为停顿，重新开始估计
+const qint64 kIdleResetMs = 300;
+
+// 速度和步长的平滑系数（新样本的权重）
+const double kSmoothing = 0.5;
+
+// 按速度延长预取距离：预取覆盖这段时间内会经过的帧
+const double kLeadSeconds = 0.25;
+
+// 沿拖动方向最多预取的帧数
+const int kMaxAhead = 24;
+
+}
+
+ScrubPrefetcher::ScrubPrefetcher(ThumbnailCache* cache, QObject* parent)
+	: QObject(parent)
+	, m_cache(cache)
+	, m_count(0)
+	, m_ahead(6)
+	, m_behind(2)
+	, m_enabled(true)
+	, m_lastIndex(-1)
+	, m_direction(0)
+	, m_velocity(0.0)
+	, m_stride(1.0)
+{
+}
+
+void ScrubPrefetcher::setSource(int count, const RecordSource& source)
+{
+	m_source = source;
+	m_count = m_source ? qMax(0, count) : 0;
+	reset();
+}
+
+void ScrubPrefetcher::setCount(int count)
+{
+	m_count = m_source ? qMax(0, count) : 0;
+}
+
+void ScrubPrefetcher::setLookahead(int ahead, int behind)
+{
+	m_ahead = qMax(0, ahead);
+	m_behind = qMax(0, behind);
+}
+
+void ScrubPrefetcher::setEnabled(bool enabled)
+{
+	m_enabled = enabled;
+	if (!m_enabled) {
+		m_cache->cancelPrefetch();
+	}
+}
+
+bool ScrubPrefetcher::isEnabled() const
+{
+	return m_enabled;
+}
+
+void ScrubPrefetcher::positionChanged(int index)
+{
+	if (index < 0 || index >= m_count) {
+		return;
+	}
+
+	qint64 elapsedMs = m_clock.isValid() ? m_clock.restart() : -1;
+	if (!m_clock.isValid()) {
+		m_clock.start();
+	}
+	int delta = m_lastIndex >= 0 ? index - m_lastIndex : 0;
+	m_lastIndex = index;
+	if (delta == 0) {
+		return;
+	}
+
+	// 停顿后的第一次移动只确定方向，速度和步长从头估计
+	int direction = delta > 0 ? 1 : -1;
+	int step = qAbs(delta);
+	double instant = step * 1000.0 / qMax<qint64>(1, elapsedMs);
+	bool idle = elapsedMs < 0 || elapsedMs > kIdleResetMs;
+	if (idle || m_direction == 0) {
+		m_velocity = idle ? 0.0 : instant;
+		m_stride = idle ? 1.0 : step;
+	} else if (direction != m_direction) {
+		// 方向反转：沿旧方向排队的预取已经没用了
+		m_cache->cancelPrefetch();
+		m_velocity = instant;
+		m_stride = step;
+	} else {
+		m_velocity = m_velocity * (1.0 - kSmoothing) + instant * kSmoothing;
+		m_stride = m_stride * (1.0 - kSmoothing) + step * kSmoothing;
+	}
+	m_direction = direction;
+
+	if (!m_enabled || !m_source) {
+		return;
+	}
+
+	// 沿拖动方向按步长预取，速度越快预取得越远；反方向只留几帧
+	int stride = qMax(1, qRound(m_stride));
+	int ahead = qBound(m_ahead, m_ahead + qRound(m_velocity * kLeadSeconds / stride), kMaxAhead);
+	QList<QPair<int, AppRecord>> records;
+	for (int i = 1; i <= ahead; ++i) {
+		int next = index + m_direction * stride * i;
+		if (next < 0 || next >= m_count) {
+			break;
+		}
+		records.append(qMakePair(next, m_source(next)));
+	}
+	for (int i = 1; i <= m_behind; ++i) {
+		int previous = index - m_direction * i;
+		if (previous < 0 || previous >= m_count) {
+			break;
+		}
+		records.append(qMakePair(previous, m_source(previous)));
+	}
+	m_cache->prefetch(records);
+}
+
+void ScrubPrefetcher::reset()
+{
+	m_cache->cancelPrefetch();
+	m_clock.invalidate();
+	m_lastIndex = -1;
+	m_direction = 0;
+	m_velocity = 0.0;
+	m_stride = 1.0;
+}
+
+int ScrubPrefetcher::direction() const
+{
+	return m_direction;
+}
+
+double ScrubPrefetcher::velocity() const
+{
+	return m_velocity;
+}
+
+double ScrubPrefetcher::stride() const
+{
+	return m_stride;
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <functional>
+#include "../common.h"
+
+class ThumbnailCache;
+
+// 拖动时间滑块时的缩略图预取
+// 根据相邻两次位置变化估计拖动方向、速度和步长，沿拖动方向提前解码后面的若干帧，
+// 反方向只预取少量几帧，以便回拖时也能立即显示。方向反转时取消尚未开始的旧预取。
+// 停顿超过一定时间后重新开始估计，单击跳转不会被当成高速拖动。
+class ScrubPrefetcher : public QObject {
+	Q_OBJECT
+public:
+	// 按下标取记录（在 GUI 线程中调用）
+	using RecordSource = std::function<AppRecord(int index)>;
+
+	explicit ScrubPrefetcher(ThumbnailCache* cache, QObject* parent = nullptr);
+
+	// 更换数据来源，同时清除拖动状态
+	void setSource(int count, const RecordSource& source);
+	void setCount(int count);
+
+	// 沿拖动方向预取的帧数和反方向预取的帧数
+	void setLookahead(int ahead, int behind);
+
+	// 是否启用（关闭时只跟踪位置，不预取）
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+
+	// 滑块移动到 index（在显示请求之后调用）
+	void positionChanged(int index);
+
+	// 清除拖动状态并取消预取（记录下标整体变化时调用）
+	void reset();
+
+	// 当前估计的拖动方向（-1、0、1）、速度（条/秒）和每次移动的步长
+	int direction() const;
+	double velocity() const;
+	double stride() const;
+
+private:
+	ThumbnailCache* m_cache;
+	RecordSource m_source;
+	int m_count;
+	int m_ahead;
+	int m_behind;
+	bool m_enabled;
+
+	QElapsedTimer m_clock;              // 距上一次位置变化的时间
+	int m_lastIndex;                    // 上一次位置（-1 表示无）
+	int m_direction;
+	double m_velocity;
+	double m_stride;
+};
@@ -17,10 +17,10 @@ SettingsDialog::SettingsDialog(QWidget* parent)
 	// 设置统一的暗色主题样式
 	setStyleSheet(
 		"QDialog { background-color: #1a1a1a; color: #ffffff; border: 2px solid #333333; border-radius: 12px; }"
-		"QListWidget { background-color: #2a2a2a; border: 1px solid #333333; border-radius: 8px; color: #ffffff; selection-background-color: #0064ff; outline: none; }"
-		"QListWidget::item { padding: 12px; border-bottom: 1px solid #333333; border-radius: 4px; margin: 2px; }"
-		"QListWidget::item:hover { background-color: #404040; }"
-		"QListWidget::item:selected { background-color: #0064ff; color: #ffffff; }"
+		"QListView { background-color: #2a2a2a; border: 1px solid #333333; border-radius: 8px; color: #ffffff; selection-background-color: #0064ff; outline: none; }"
+		"QListView::item { padding: 12px; border-bottom: 1px solid #333333; border-radius: 4px; margin: 2px; }"
+		"QListView::item:hover { background-color: #404040; }"
+		"QListView::item:selected { background-color: #0064ff; color: #ffffff; }"
 		"QLineEdit { background-color: #2a2a2a; border: 2px solid #333333; border-radius: 8px; color: #ffffff; padding: 12px; font-size: 14px; }"
 		"QLineEdit:focus { border-color: #0064ff; outline: none; }"
 		"QPushButton { background-color: #0064ff; color: #ffffff; border: none; padding: 12px 24px; border-radius: 8px; font-weight: bold; font-size: 14px; }"
@@ -47,27 +47,8 @@ SettingsDialog::~SettingsDialog()
 void SettingsDialog::setScreenMonitor(ScreenMonitor* monitor)
 {
 	m_screenMonitor = monitor;
-	
-	// 同步现有的应用记录
-	if (m_screenMonitor) {
-		QList<AppRecord> records = m_screenMonitor->getAppRecords();
-		m_recordingWidget->syncAppRecords(records);
-		qDebug() << "已同步 ScreenMonitor 的现有记录，数量:" << records.size();
-	}
-}
-
-void SettingsDialog::addAppRecord(const AppRecord& record)
-{
-	// 将新记录添加到 RecordingWidget
-	m_recordingWidget->addAppRecord(record);
-	qDebug() << "新应用记录已添加:" << record.appName << "时间:" << record.timestamp.toString("hh:mm:ss");
-}
-
-void SettingsDialog::clearAppRecords()
-{
-	// 清空 RecordingWidget 的记录
-	m_recordingWidget->clearAppRecords();
-	qDebug() << "应用记录已清空";
+	// RecordingWidget 直接订阅 ScreenMonitor 的记录存储，不再复制记录
+	m_recordingWidget->setScreenMonitor(monitor);
 }
 
 void SettingsDialog::initializeUI()
@@ -198,18 +179,4 @@ void SettingsDialog::onAppFiltersChanged(const QStringList &filteredApps)
 	emit appFiltersChanged(filteredApps);
 }
 
-void SettingsDialog::onAppRecordAdded(const AppRecord &record)
-{
-	// 将新记录添加到 RecordingWidget
-	m_recordingWidget->addAppRecord(record);
-	qDebug() << "新应用记录已添加:" << record.appName << "时间:" << record.timestamp.toString("hh:mm:ss");
-}
-
-void SettingsDialog::onAppRecordsCleared()
-{
-	// 清空 RecordingWidget 的记录
-	m_recordingWidget->clearAppRecords();
-	qDebug() << "应用记录已清空";
-}
-
 
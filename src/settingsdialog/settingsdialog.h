@@ -28,12 +28,8 @@ public:
     explicit SettingsDialog(QWidget *parent = nullptr);
     ~SettingsDialog();
     
-    // 设置 ScreenMonitor 引用
+    // 设置 ScreenMonitor 引用（录制回想页面订阅其记录存储）
     void setScreenMonitor(ScreenMonitor* monitor);
-    
-    // 记录管理公共方法
-    void addAppRecord(const AppRecord& record);
-    void clearAppRecords();
 
 signals:
     // 不监控应用名单变化信号
@@ -54,10 +50,6 @@ private slots:
     
     // 应用过滤列表变化
     void onAppFiltersChanged(const QStringList &filteredApps);
-    
-    // 记录管理
-    void onAppRecordAdded(const AppRecord &record);
-    void onAppRecordsCleared();
 
 private:
     // 初始化UI
@@ -112,7 +104,6 @@ private:
     QListWidget *m_appRecordsList;
     QLabel *m_screenshotLabel;
     QLabel *m_appInfoLabel;
-    QList<AppRecord> m_appRecords;
     
     // 标题栏
     QWidget *m_titleBar;
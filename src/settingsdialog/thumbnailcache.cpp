@@ -0,0 +1,273 @@
+﻿#include "thumbnailcache.h"
+#include <QBuffer>
+#include <QImageReader>
+#include <QRunnable>
+
+namespace {
+
+// 解码线程数
+const int kDecodeThreads = 2;
+
+// 待解码请求的上限，超出时丢弃最早的请求
+const int kMaxPending = 4;
+
+// 默认缓存条数（350x250 的缩略图约 350KB 一张）
+const int kDefaultCapacity = 96;
+
+}
+
+// 在工作线程中解码一张缩略图，完成后排队回到缓存所在线程
+class ThumbnailTask : public QRunnable {
+public:
+	ThumbnailTask(ThumbnailCache* cache, quint64 generation, const ThumbnailCache::Request& request)
+		: m_cache(cache)
+		, m_generation(generation)
+		, m_request(request)
+		, m_loader(cache->m_loader)
+		, m_size(cache->m_thumbnailSize)
+	{
+	}
+
+	void run() override
+	{
+		QImage thumbnail = m_loader ? m_loader(m_request.index, m_request.record, m_size) : QImage();
+		ThumbnailCache* cache = m_cache;
+		quint64 generation = m_generation;
+		ThumbnailKey key = m_request.key;
+		QMetaObject::invokeMethod(cache, [cache, generation, key, thumbnail]() {
+			cache->onThumbnailDecoded(generation, key, thumbnail);
+		}, Qt::QueuedConnection);
+	}
+
+private:
+	ThumbnailCache* m_cache;
+	quint64 m_generation;
+	ThumbnailCache::Request m_request;
+	ThumbnailCache::ThumbnailLoader m_loader;
+	QSize m_size;
+};
+
+ThumbnailCache::ThumbnailCache(const QSize& thumbnailSize, QObject* parent)
+	: QObject(parent)
+	, m_thumbnailSize(thumbnailSize)
+	, m_capacity(kDefaultCapacity)
+	, m_generation(0)
+	, m_useCounter(0)
+{
+	m_pool.setMaxThreadCount(kDecodeThreads);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	m_pending.clear();
+	m_prefetch.clear();
+	m_pool.waitForDone();
+}
+
+void ThumbnailCache::setLoader(const ThumbnailLoader& loader)
+{
+	reset();
+	m_loader = loader;
+}
+
+void ThumbnailCache::reset()
+{
+	// 进行中的解码可能正在使用旧来源（例如时间线解码器），等它们结束后来源才能关闭
+	m_generation++;
+	m_pending.clear();
+	m_prefetch.clear();
+	m_pool.waitForDone();
+	m_inFlight.clear();
+	m_entries.clear();
+}
+
+void ThumbnailCache::setCapacity(int count)
+{
+	m_capacity = qMax(1, count);
+	evictToCapacity();
+}
+
+int ThumbnailCache::capacity() const
+{
+	return m_capacity;
+}
+
+QSize ThumbnailCache::thumbnailSize() const
+{
+	return m_thumbnailSize;
+}
+
+QImage ThumbnailCache::request(int index, const AppRecord& record, bool* exact)
+{
+	ThumbnailKey key = keyOf(record);
+	auto it = m_entries.find(key);
+	if (it != m_entries.end()) {
+		it->lastUse = ++m_useCounter;
+		if (exact) {
+			*exact = true;
+		}
+		return it->image;
+	}
+
+	if (exact) {
+		*exact = false;
+	}
+	if (!m_loader) {
+		return QImage();
+	}
+
+	// 已在解码或等待中时只把它提到最前
+	if (!m_inFlight.contains(key)) {
+		for (int i = 0; i < m_pending.size(); ++i) {
+			if (m_pending[i].key == key) {
+				m_pending.removeAt(i);
+				break;
+			}
+		}
+		Request pending;
+		pending.key = key;
+		pending.index = index;
+		pending.record = record;
+		m_pending.prepend(pending);
+		while (m_pending.size() > kMaxPending) {
+			m_pending.removeLast();
+		}
+		pump();
+	}
+	return nearest(key);
+}
+
+void ThumbnailCache::prefetch(const QList<QPair<int, AppRecord>>& records)
+{
+	m_prefetch.clear();
+	if (!m_loader) {
+		return;
+	}
+
+	for (const QPair<int, AppRecord>& item : records) {
+		ThumbnailKey key = keyOf(item.second);
+		if (m_entries.contains(key) || m_inFlight.contains(key)) {
+			continue;
+		}
+		Request request;
+		request.key = key;
+		request.index = item.first;
+		request.record = item.second;
+		m_prefetch.append(request);
+	}
+	pump();
+}
+
+void ThumbnailCache::cancelPrefetch()
+{
+	// 已开始的解码无法中断，完成后照常进入缓存
+	m_prefetch.clear();
+}
+
+bool ThumbnailCache::contains(const AppRecord& record) const
+{
+	return m_entries.contains(keyOf(record));
+}
+
+ThumbnailKey ThumbnailCache::keyOf(const AppRecord& record)
+{
+	ThumbnailKey key;
+	key.ms = record.timestamp.toMSecsSinceEpoch();
+	quint64 textHash = (quint64(qHash(record.frameKey)) << 32) | (qHash(record.appName) ^ qHash(record.windowTitle));
+	key.content = record.perceptualHash ^ textHash;
+	return key;
+}
+
+QImage ThumbnailCache::decodeScaled(const QByteArray& jpeg, const QSize& size)
+{
+	QBuffer buffer;
+	buffer.setData(jpeg);
+	buffer.open(QIODevice::ReadOnly);
+
+	// JPEG 解码器可以直接按 1/2、1/4、1/8 缩小解码，比解出原图再缩小快得多
+	QImageReader reader(&buffer, "JPEG");
+	QSize original = reader.size();
+	if (original.isValid() && (original.width() > size.width() || original.height() > size.height())) {
+		reader.setScaledSize(original.scaled(size, Qt::KeepAspectRatio));
+	}
+	return reader.read();
+}
+
+QImage ThumbnailCache::scaleToFit(const QImage& image, const QSize& size)
+{
+	if (image.isNull() || (image.width() <= size.width() && image.height() <= size.height())) {
+		return image;
+	}
+	return image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
+
+void ThumbnailCache::pump()
+{
+	// 显示请求优先，线程空闲时再解码预取
+	while (m_inFlight.size() < kDecodeThreads && (!m_pending.isEmpty() || !m_prefetch.isEmpty())) {
+		Request next = !m_pending.isEmpty() ? m_pending.takeFirst() : m_prefetch.takeFirst();
+		if (m_inFlight.contains(next.key) || m_entries.contains(next.key)) {
+			continue;
+		}
+		m_inFlight.insert(next.key);
+		m_pool.start(new ThumbnailTask(this, m_generation, next));
+	}
+}
+
+void ThumbnailCache::onThumbnailDecoded(quint64 generation, const ThumbnailKey& key, const QImage& thumbnail)
+{
+	if (generation != m_generation) {
+		return;
+	}
+
+	// 没有截图的记录也进入缓存（空图像），再次请求时不重新解码
+	m_inFlight.remove(key);
+	insert(key, thumbnail);
+	emit thumbnailReady(key, thumbnail);
+	pump();
+}
+
+void ThumbnailCache::insert(const ThumbnailKey& key, const QImage& thumbnail)
+{
+	Entry entry;
+	entry.image = thumbnail;
+	entry.lastUse = ++m_useCounter;
+	m_entries.insert(key, entry);
+	evictToCapacity();
+}
+
+void ThumbnailCache::evictToCapacity()
+{
+	// 超出上限时淘汰最久未使用的一张（缓存只有几十到几百张，线性查找即可）
+	while (m_entries.size() > m_capacity) {
+		auto oldest = m_entries.begin();
+		for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+			if (it->lastUse < oldest->lastUse) {
+				oldest = it;
+			}
+		}
+		m_entries.erase(oldest);
+	}
+}
+
+QImage ThumbnailCache::nearest(const ThumbnailKey& key) const
+{
+	// 键之后的第一张和之前的最后一张中取时间更近的（跳过解码失败的空图像）
+	auto after = m_entries.lowerBound(key);
+	while (after != m_entries.end() && after->image.isNull()) {
+		++after;
+	}
+	auto before = m_entries.lowerBound(key);
+	bool hasBefore = false;
+	while (!hasBefore && before != m_entries.begin()) {
+		--before;
+		hasBefore = !before->image.isNull();
+	}
+	if (!hasBefore) {
+		return after != m_entries.end() ? after->image : QImage();
+	}
+	if (after == m_entries.end() || key.ms - before.key().ms <= after.key().ms - key.ms) {
+		return before->image;
+	}
+	return after->image;
+}
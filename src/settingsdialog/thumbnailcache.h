@@ -0,0 +1,118 @@
+﻿#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QSet>
+#include <QSize>
+#include <QThreadPool>
+#include <functional>
+#include "../common.h"
+
+// 缩略图的键：记录时间加内容摘要
+// 同一毫秒可能有多条记录（例如同时截取的各块屏幕），只用时间会互相覆盖。内容摘要取感知哈希、
+// 帧存储键、应用和窗口标题，这些都不随实时记录的淘汰（下标变化）或段压缩（截图位置变化）改变；
+// 时间和内容都相同的记录画面相同，共用一张缩略图。
+struct ThumbnailKey {
+	qint64 ms = -1;          // 记录时间（毫秒）
+	quint64 content = 0;     // 内容摘要
+
+	bool operator==(const ThumbnailKey& other) const { return ms == other.ms && content == other.content; }
+	bool operator!=(const ThumbnailKey& other) const { return !(*this == other); }
+	bool operator<(const ThumbnailKey& other) const
+	{
+		return ms != other.ms ? ms < other.ms : content < other.content;
+	}
+};
+
+inline uint qHash(const ThumbnailKey& key, uint seed = 0)
+{
+	return qHash(key.ms, seed) ^ qHash(key.content, seed);
+}
+
+Q_DECLARE_METATYPE(ThumbnailKey)
+
+// 录制回想的缩略图缓存
+// 拖动时间滑块时，截图的解码和缩小在工作线程中完成，GUI 线程只显示已缓存的缩略图：
+//   - request() 精确命中时直接返回；未命中时提交解码，同时返回时间上最接近的已缓存缩略图，
+//     解码完成后发出 thumbnailReady，界面再换上准确的那一帧
+//   - 缓存按条数上限淘汰最久未使用的缩略图；没有截图或解码失败的记录也缓存（空图像），
+//     之后再请求时直接返回空图像，不会反复解码
+//   - 待解码的请求后进先出，数量有上限：快速拖动时只解码最近请求的几帧，过时的请求直接丢弃
+//   - 预取（prefetch）排在显示请求之后，每次调用整体替换预取队列
+// 缩略图以记录的时间戳（毫秒）和内容摘要为键（见 ThumbnailKey），实时记录因淘汰导致下标变化时缓存仍然有效。
+class ThumbnailCache : public QObject {
+	Q_OBJECT
+public:
+	// 解码并缩小一条记录的截图（在工作线程中调用，必须线程安全）
+	using ThumbnailLoader = std::function<QImage(int index, const AppRecord& record, const QSize& size)>;
+
+	explicit ThumbnailCache(const QSize& thumbnailSize, QObject* parent = nullptr);
+	~ThumbnailCache();
+
+	// 更换数据来源：丢弃缓存和待解码的请求，并等待进行中的解码结束
+	void setLoader(const ThumbnailLoader& loader);
+	void reset();
+
+	// 缓存的缩略图条数上限
+	void setCapacity(int count);
+	int capacity() const;
+	QSize thumbnailSize() const;
+
+	// 取 index 对应记录的缩略图，exact 返回结果是否就是该记录的缩略图
+	// （exact 为 true 而图像为空表示该记录没有可显示的截图）
+	QImage request(int index, const AppRecord& record, bool* exact = nullptr);
+
+	// 预取：按顺序（最重要的在前）提前解码这些记录，已缓存或正在解码的跳过
+	void prefetch(const QList<QPair<int, AppRecord>>& records);
+	void cancelPrefetch();
+
+	bool contains(const AppRecord& record) const;
+
+	// 缩略图的键
+	static ThumbnailKey keyOf(const AppRecord& record);
+
+	// 从 JPEG 数据按目标尺寸直接缩小解码（不先解出原图）
+	static QImage decodeScaled(const QByteArray& jpeg, const QSize& size);
+
+	// 把整图等比缩小到目标尺寸以内
+	static QImage scaleToFit(const QImage& image, const QSize& size);
+
+signals:
+	// 解码完成（记录没有截图或解码失败时 thumbnail 为空）
+	void thumbnailReady(const ThumbnailKey& key, const QImage& thumbnail);
+
+private:
+	friend class ThumbnailTask;
+
+	struct Entry {
+		QImage image;
+		quint64 lastUse = 0;
+	};
+
+	struct Request {
+		ThumbnailKey key;
+		int index = 0;
+		AppRecord record;
+	};
+
+	void pump();
+	void onThumbnailDecoded(quint64 generation, const ThumbnailKey& key, const QImage& thumbnail);
+	void insert(const ThumbnailKey& key, const QImage& thumbnail);
+	void evictToCapacity();
+	QImage nearest(const ThumbnailKey& key) const;
+
+	QThreadPool m_pool;                 // 解码线程
+	ThumbnailLoader m_loader;
+	QSize m_thumbnailSize;
+	int m_capacity;
+	quint64 m_generation;               // 每次更换来源递增，丢弃旧来源的迟到结果
+	quint64 m_useCounter;               // 最近使用顺序
+	QMap<ThumbnailKey, Entry> m_entries; // 键 -> 缩略图（按时间有序，便于找最接近的一帧；空图像表示解码失败）
+	QList<Request> m_pending;           // 待解码的请求（最新的在前）
+	QList<Request> m_prefetch;          // 待解码的预取（最重要的在前）
+	QSet<ThumbnailKey> m_inFlight;      // 正在解码的键
+};
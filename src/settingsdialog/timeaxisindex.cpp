@@ -0,0 +1,293 @@
+﻿#include "timeaxisindex.h"
+#include <limits>
+
+namespace {
+
+// 各级桶宽（毫秒）
+const qint64 kLevelWidths[] = {
+	5 * 1000,                    // 5 秒
+	30 * 1000,                   // 30 秒
+	60 * 1000,                   // 1 分钟
+	5 * 60 * 1000,               // 5 分钟
+	15 * 60 * 1000,              // 15 分钟
+	60 * 60 * 1000,              // 1 小时
+	3 * 60 * 60 * 1000,          // 3 小时
+	12 * 60 * 60 * 1000,         // 12 小时
+	24 * 60 * 60 * 1000          // 1 天
+};
+
+const int kLevelCount = int(sizeof(kLevelWidths) / sizeof(kLevelWidths[0]));
+
+// 按需汇总时每个桶最多抽样的记录数（粗级别的一个桶可能有上万条记录）
+const int kMaxSamples = 32;
+
+// 本地时间偏移按此粒度缓存，各时区的夏令时切换时刻都落在 15 分钟的整数倍上
+const qint64 kOffsetSlotMs = 15 * 60 * 1000;
+
+}
+
+TimeAxisIndex::TimeAxisIndex()
+	: m_levels(kLevelCount)
+	, m_prepared(kLevelCount)
+	, m_recordCount(0)
+	, m_firstMs(std::numeric_limits<qint64>::max())
+	, m_lastMs(std::numeric_limits<qint64>::min())
+{
+}
+
+int TimeAxisIndex::levelCount()
+{
+	return kLevelCount;
+}
+
+qint64 TimeAxisIndex::levelWidth(int level)
+{
+	return kLevelWidths[qBound(0, level, kLevelCount - 1)];
+}
+
+void TimeAxisIndex::clear()
+{
+	for (QMap<qint64, TimeAxisBucket>& buckets : m_levels) {
+		buckets.clear();
+	}
+	for (QSet<qint64>& prepared : m_prepared) {
+		prepared.clear();
+	}
+	m_utcOffsets.clear();
+	m_source = TimeAxisSource();
+	m_recordCount = 0;
+	m_firstMs = std::numeric_limits<qint64>::max();
+	m_lastMs = std::numeric_limits<qint64>::min();
+}
+
+void TimeAxisIndex::add(int index, const AppRecord& record)
+{
+	qint64 ms = record.timestamp.toMSecsSinceEpoch();
+	m_recordCount++;
+	m_firstMs = qMin(m_firstMs, ms);
+	m_lastMs = qMax(m_lastMs, ms);
+
+	// 每一级只更新记录所在的一个桶，追加的开销与级数成正比
+	for (int level = 0; level < kLevelCount; ++level) {
+		qint64 start = bucketStart(level, ms);
+		TimeAxisBucket& bucket = m_levels[level][start];
+		if (bucket.count == 0) {
+			bucket.startMs = start;
+		}
+		bucket.count++;
+
+		int appCount = ++bucket.appCounts[record.appName];
+		if (bucket.dominantApp == record.appName) {
+			bucket.dominantCount = appCount;
+		} else if (appCount > bucket.dominantCount) {
+			// 主导应用变化时代表帧换成新主导应用的这一条
+			bucket.dominantApp = record.appName;
+			bucket.dominantCount = appCount;
+			bucket.representativeIndex = index;
+			bucket.representativeMs = ms;
+		}
+	}
+}
+
+void TimeAxisIndex::setSource(const TimeAxisSource& source)
+{
+	clear();
+	m_source = source;
+	updateSourceRange();
+}
+
+void TimeAxisIndex::sourceAppended()
+{
+	if (!m_source.count) {
+		return;
+	}
+
+	// 新记录追加在末尾，只有最后一条旧记录之后的桶受影响
+	int oldCount = m_recordCount;
+	updateSourceRange();
+	if (m_recordCount <= oldCount) {
+		return;
+	}
+	qint64 ms = m_source.timestampAt(oldCount);
+	if (oldCount > 0) {
+		ms = qMin(ms, m_source.timestampAt(oldCount - 1));
+	}
+	for (int level = 0; level < kLevelCount; ++level) {
+		qint64 start = bucketStart(level, ms);
+		QMap<qint64, TimeAxisBucket>& buckets = m_levels[level];
+		buckets.erase(buckets.lowerBound(start), buckets.end());
+		QSet<qint64>& prepared = m_prepared[level];
+		for (auto it = prepared.begin(); it != prepared.end();) {
+			if (*it >= start) {
+				it = prepared.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+}
+
+void TimeAxisIndex::updateSourceRange()
+{
+	m_recordCount = m_source.count ? m_source.count() : 0;
+	if (m_recordCount > 0) {
+		m_firstMs = m_source.timestampAt(0);
+		m_lastMs = m_source.timestampAt(m_recordCount - 1);
+	} else {
+		m_firstMs = std::numeric_limits<qint64>::max();
+		m_lastMs = std::numeric_limits<qint64>::min();
+	}
+}
+
+void TimeAxisIndex::prepare(int level, qint64 fromMs, qint64 toMs) const
+{
+	if (!m_source.count || m_recordCount == 0) {
+		return;
+	}
+
+	// 只汇总与记录时间范围相交的桶，数量由可见范围和级别决定
+	level = qBound(0, level, kLevelCount - 1);
+	fromMs = qMax(fromMs, m_firstMs);
+	toMs = qMin(toMs, m_lastMs + 1);
+	QMap<qint64, TimeAxisBucket>& buckets = m_levels[level];
+	QSet<qint64>& prepared = m_prepared[level];
+	for (qint64 start = bucketStart(level, fromMs); start < toMs; start = nextBucketStart(level, start)) {
+		if (prepared.contains(start)) {
+			continue;
+		}
+		prepared.insert(start);
+
+		int first = m_source.lowerBound(start);
+		int last = m_source.lowerBound(nextBucketStart(level, start));
+		if (last <= first) {
+			continue;
+		}
+
+		TimeAxisBucket bucket;
+		bucket.startMs = start;
+		bucket.count = last - first;
+		int samples = qMin(bucket.count, kMaxSamples);
+		for (int i = 0; i < samples; ++i) {
+			int index = first + int(qint64(i) * bucket.count / samples);
+			QString appName = m_source.appNameAt(index);
+			int appCount = ++bucket.appCounts[appName];
+			if (appCount > bucket.dominantCount) {
+				if (bucket.representativeIndex < 0 || bucket.dominantApp != appName) {
+					bucket.representativeIndex = index;
+					bucket.representativeMs = m_source.timestampAt(index);
+				}
+				bucket.dominantApp = appName;
+				bucket.dominantCount = appCount;
+			}
+		}
+		buckets.insert(start, bucket);
+	}
+}
+
+void TimeAxisIndex::removeBefore(qint64 ms)
+{
+	for (int level = 0; level < kLevelCount; ++level) {
+		QMap<qint64, TimeAxisBucket>& buckets = m_levels[level];
+		qint64 start = bucketStart(level, ms);
+		while (!buckets.isEmpty() && buckets.firstKey() < start) {
+			if (level == 0) {
+				m_recordCount -= buckets.first().count;
+			}
+			buckets.erase(buckets.begin());
+		}
+	}
+
+	if (m_levels[0].isEmpty()) {
+		clear();
+	} else {
+		m_firstMs = qMax(m_firstMs, ms);
+	}
+}
+
+bool TimeAxisIndex::isEmpty() const
+{
+	return m_recordCount == 0;
+}
+
+int TimeAxisIndex::recordCount() const
+{
+	return m_recordCount;
+}
+
+qint64 TimeAxisIndex::firstMs() const
+{
+	return m_firstMs;
+}
+
+qint64 TimeAxisIndex::lastMs() const
+{
+	return m_lastMs;
+}
+
+int TimeAxisIndex::levelFor(qint64 spanMs, int maxBuckets) const
+{
+	maxBuckets = qMax(1, maxBuckets);
+	for (int level = 0; level < kLevelCount; ++level) {
+		if (spanMs / kLevelWidths[level] < maxBuckets) {
+			return level;
+		}
+	}
+	return kLevelCount - 1;
+}
+
+QMap<qint64, TimeAxisBucket>::const_iterator TimeAxisIndex::begin(int level, qint64 fromMs) const
+{
+	const QMap<qint64, TimeAxisBucket>& buckets = m_levels[qBound(0, level, kLevelCount - 1)];
+	return buckets.lowerBound(bucketStart(level, fromMs));
+}
+
+QMap<qint64, TimeAxisBucket>::const_iterator TimeAxisIndex::end(int level) const
+{
+	return m_levels[qBound(0, level, kLevelCount - 1)].constEnd();
+}
+
+qint64 TimeAxisIndex::bucketStart(int level, qint64 ms) const
+{
+	// 按本地时间对齐，向下取整（负数也正确）
+	qint64 width = levelWidth(level);
+	qint64 offset = utcOffsetAt(ms);
+	qint64 local = ms + offset;
+	qint64 floored = local >= 0 ? local / width * width : -((-local + width - 1) / width) * width;
+	qint64 start = floored - offset;
+
+	// 桶起点与 ms 之间切换了夏令时：按起点一侧的偏移换算本地对齐点。
+	// 对齐点落在跳过的一小时内时两种换算都不自洽，取较晚的一个（即切换时刻）
+	qint64 startOffset = utcOffsetAt(start);
+	if (startOffset != offset) {
+		qint64 adjusted = floored - startOffset;
+		if (adjusted <= ms && (utcOffsetAt(adjusted) == startOffset || adjusted > start)) {
+			start = adjusted;
+		}
+	}
+	return start;
+}
+
+qint64 TimeAxisIndex::nextBucketStart(int level, qint64 start) const
+{
+	// 夏令时结束的那一天（或 12 小时、3 小时）比桶宽长，桶宽之后仍在同一个桶中时继续向后找
+	qint64 step = qMin(levelWidth(level), kOffsetSlotMs);
+	for (qint64 probe = start + levelWidth(level);; probe += step) {
+		qint64 next = bucketStart(level, probe);
+		if (next > start) {
+			return next;
+		}
+	}
+}
+
+qint64 TimeAxisIndex::utcOffsetAt(qint64 ms) const
+{
+	// 按时刻取偏移（跨夏令时的历史记录各自按当时的本地时间对齐），同一段时间内的偏移相同
+	qint64 slot = ms >= 0 ? ms / kOffsetSlotMs : -((-ms + kOffsetSlotMs - 1) / kOffsetSlotMs);
+	auto it = m_utcOffsets.constFind(slot);
+	if (it != m_utcOffsets.constEnd()) {
+		return it.value();
+	}
+	qint64 offset = qint64(QDateTime::fromMSecsSinceEpoch(slot * kOffsetSlotMs).offsetFromUtc()) * 1000;
+	m_utcOffsets.insert(slot, offset);
+	return offset;
+}
@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <functional>
+#include "../common.h"
+
+// 时间轴上一个时间桶的汇总
+struct TimeAxisBucket {
+	qint64 startMs = 0;              // 桶起点（本地时间对齐）
+	int count = 0;                   // 记录数
+	QString dominantApp;             // 记录最多的应用
+	int dominantCount = 0;
+	// 代表帧：主导应用在桶中的一条记录。只保存下标和时间戳，绘制时再按需取记录，
+	// 不持有截图数据（实时记录被淘汰后下标会变，按时间戳确认或重新查找）
+	int representativeIndex = -1;
+	qint64 representativeMs = 0;
+	QHash<QString, int> appCounts;   // 各应用的记录数
+};
+
+// 按需汇总的记录来源：记录按时间有序，可按下标读取、按时间二分查找（持久化历史记录）
+struct TimeAxisSource {
+	std::function<int()> count;
+	std::function<int(qint64 ms)> lowerBound;        // 第一条时间不早于 ms 的记录
+	std::function<qint64(int index)> timestampAt;
+	std::function<QString(int index)> appNameAt;
+};
+
+// 按时间分级汇总的记录索引
+// 每一级把时间切成按本地时间对齐的桶（5 秒到 1 天，夏令时切换处的桶相应变短或变长），记录追加时逐级更新所在桶的汇总，
+// 绘制时按可见时间范围选一级、只遍历可见的桶，开销与记录总数无关。
+// 历史记录可能有数百万条，不逐条追加：设置来源后由 prepare() 只汇总可见范围内的桶，
+// 每个桶的记录数由两次二分查找得出，主导应用在桶内等间隔抽样统计，汇总结果缓存起来。
+class TimeAxisIndex {
+public:
+	TimeAxisIndex();
+
+	static int levelCount();
+	static qint64 levelWidth(int level);
+
+	void clear();
+
+	// 追加一条记录（记录大体按时间顺序追加，乱序也能正确汇总）
+	void add(int index, const AppRecord& record);
+
+	// 设置按需汇总的来源（clear() 时一并清除），之后不再调用 add()
+	void setSource(const TimeAxisSource& source);
+
+	// 来源末尾追加了记录：更新记录数和时间范围，丢弃受影响的桶
+	void sourceAppended();
+
+	// 保证某一级中 [fromMs, toMs) 内的桶已汇总（没有来源时不做任何事）
+	void prepare(int level, qint64 fromMs, qint64 toMs) const;
+
+	// 删除起点早于 ms 所在桶的所有桶（实时记录从头部淘汰后调用），跨过 ms 的桶保留原汇总
+	void removeBefore(qint64 ms);
+
+	bool isEmpty() const;
+	int recordCount() const;
+	qint64 firstMs() const;
+	qint64 lastMs() const;
+
+	// 在 spanMs 的时间范围内最多显示 maxBuckets 个桶时，应使用的最细一级
+	int levelFor(qint64 spanMs, int maxBuckets) const;
+
+	// 某一级中起点位于 [fromMs, toMs) 的桶（按时间顺序，包括跨过 fromMs 的那一个）
+	QMap<qint64, TimeAxisBucket>::const_iterator begin(int level, qint64 fromMs) const;
+	QMap<qint64, TimeAxisBucket>::const_iterator end(int level) const;
+
+	// ms 所在的桶起点，以及下一个桶的起点（跨夏令时切换的桶比桶宽短或长）
+	qint64 bucketStart(int level, qint64 ms) const;
+	qint64 nextBucketStart(int level, qint64 start) const;
+
+private:
+	void updateSourceRange();
+	qint64 utcOffsetAt(qint64 ms) const;
+
+	mutable QVector<QMap<qint64, TimeAxisBucket>> m_levels;  // 有来源时是按需汇总的缓存
+	mutable QVector<QSet<qint64>> m_prepared;                 // 有来源时各级已汇总过的桶起点（包括空桶）
+	TimeAxisSource m_source;
+	mutable QHash<qint64, qint64> m_utcOffsets;               // 各时间段本地时间相对 UTC 的偏移（按本地的整点和零点对齐）
+	int m_recordCount;
+	qint64 m_firstMs;
+	qint64 m_lastMs;
+};
@@ -0,0 +1,315 @@
+﻿#include "timeaxisview.h"
+#include "thumbnailcache.h"
+#include <QDateTime>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QToolTip>
+#include <QWheelEvent>
+#include <cmath>
+
+namespace {
+
+// 可见范围的上下限
+const qint64 kMinSpanMs = 60 * 1000;
+const qint64 kMaxSpanMs = qint64(8) * 7 * 24 * 60 * 60 * 1000;
+
+// 每个桶至少占的像素，决定选用哪一级汇总
+const int kMinBucketPixels = 4;
+
+// 桶宽达到这个像素数时显示代表帧缩略图
+const int kThumbnailMinPixels = 56;
+
+// 刻度文字之间至少间隔的像素
+const int kTickMinPixels = 90;
+
+// 底部刻度区域高度
+const int kAxisHeight = 18;
+
+// 拖动超过这个距离才算平移，否则松开时当作单击
+const int kClickSlop = 3;
+
+}
+
+TimeAxisView::TimeAxisView(QWidget* parent)
+	: QWidget(parent)
+	, m_index(nullptr)
+	, m_thumbnails(nullptr)
+	, m_currentMs(-1)
+	, m_dragging(false)
+	, m_moved(false)
+	, m_pressFromMs(0)
+{
+	qint64 now = QDateTime::currentMSecsSinceEpoch();
+	m_fromMs = now - 60 * 60 * 1000;
+	m_toMs = now;
+	setMouseTracking(true);
+	setMinimumHeight(80);
+}
+
+void TimeAxisView::setIndex(const TimeAxisIndex* index)
+{
+	m_index = index;
+	update();
+}
+
+void TimeAxisView::setThumbnailCache(ThumbnailCache* cache)
+{
+	if (m_thumbnails) {
+		disconnect(m_thumbnails, nullptr, this, nullptr);
+	}
+	m_thumbnails = cache;
+	m_thumbnailKeys.clear();
+	if (m_thumbnails) {
+		// 空结果不会再显示出什么，不在可见桶中的代表帧也无需重绘，避免解码完成与重新请求互相触发
+		connect(m_thumbnails, &ThumbnailCache::thumbnailReady, this, [this](const ThumbnailKey& key, const QImage& thumbnail) {
+			if (!thumbnail.isNull() && m_thumbnailKeys.contains(key)) {
+				update();
+			}
+		});
+	}
+	update();
+}
+
+void TimeAxisView::setRecordLookup(const RecordLookup& lookup)
+{
+	m_recordLookup = lookup;
+	update();
+}
+
+void TimeAxisView::setCurrentTime(qint64 ms)
+{
+	m_currentMs = ms;
+	if (ms >= 0 && (ms < m_fromMs || ms > m_toMs)) {
+		qint64 span = m_toMs - m_fromMs;
+		setVisibleRange(ms - span / 2, ms + span - span / 2);
+		return;
+	}
+	update();
+}
+
+void TimeAxisView::setVisibleRange(qint64 fromMs, qint64 toMs)
+{
+	qint64 span = qBound(kMinSpanMs, toMs - fromMs, kMaxSpanMs);
+	qint64 center = fromMs + (toMs - fromMs) / 2;
+	m_fromMs = center - span / 2;
+	m_toMs = m_fromMs + span;
+	update();
+}
+
+qint64 TimeAxisView::visibleFrom() const
+{
+	return m_fromMs;
+}
+
+qint64 TimeAxisView::visibleTo() const
+{
+	return m_toMs;
+}
+
+void TimeAxisView::fitAll()
+{
+	if (!m_index || m_index->isEmpty()) {
+		qint64 now = QDateTime::currentMSecsSinceEpoch();
+		setVisibleRange(now - 60 * 60 * 1000, now);
+		return;
+	}
+
+	// 两端各留一点空白
+	qint64 span = qMax(kMinSpanMs, m_index->lastMs() - m_index->firstMs());
+	setVisibleRange(m_index->firstMs() - span / 20, m_index->lastMs() + span / 20);
+}
+
+QSize TimeAxisView::sizeHint() const
+{
+	return QSize(600, 96);
+}
+
+int TimeAxisView::currentLevel() const
+{
+	return m_index ? m_index->levelFor(m_toMs - m_fromMs, qMax(1, width() / kMinBucketPixels)) : 0;
+}
+
+qint64 TimeAxisView::timeAt(int x) const
+{
+	return m_fromMs + qint64(double(x) / qMax(1, width()) * (m_toMs - m_fromMs));
+}
+
+double TimeAxisView::xAt(qint64 ms) const
+{
+	return double(ms - m_fromMs) / qMax<qint64>(1, m_toMs - m_fromMs) * width();
+}
+
+QColor TimeAxisView::appColor(const QString& appName)
+{
+	return QColor::fromHsv(int(qHash(appName) % 360), 150, 210);
+}
+
+void TimeAxisView::paintEvent(QPaintEvent* event)
+{
+	Q_UNUSED(event);
+
+	QPainter painter(this);
+	painter.fillRect(rect(), QColor("#2a2a2a"));
+	m_thumbnailKeys.clear();
+	QRect barArea(0, 4, width(), height() - kAxisHeight - 4);
+
+	if (!m_index || m_index->isEmpty()) {
+		painter.setPen(QColor("#808080"));
+		painter.drawText(barArea, Qt::AlignCenter, "暂无记录");
+		return;
+	}
+
+	// 只遍历可见的桶，数量由控件宽度决定，与记录总数无关
+	int level = currentLevel();
+	qint64 bucketWidth = TimeAxisIndex::levelWidth(level);
+	m_index->prepare(level, m_fromMs, m_toMs);
+	auto first = m_index->begin(level, m_fromMs);
+	auto last = m_index->end(level);
+	int maxCount = 1;
+	for (auto it = first; it != last && it.key() < m_toMs; ++it) {
+		maxCount = qMax(maxCount, it->count);
+	}
+
+	double bucketPixels = bucketWidth * double(width()) / qMax<qint64>(1, m_toMs - m_fromMs);
+	bool drawThumbnails = m_thumbnails && m_recordLookup && bucketPixels >= kThumbnailMinPixels;
+	double logMax = std::log(1.0 + maxCount);
+	for (auto it = first; it != last && it.key() < m_toMs; ++it) {
+		const TimeAxisBucket& bucket = it.value();
+		double x0 = xAt(bucket.startMs);
+		double x1 = qMax(x0 + 1.0, xAt(bucket.startMs + bucketWidth) - (bucketPixels > 3 ? 1.0 : 0.0));
+
+		// 高度按记录数的对数，单条记录的桶也清晰可见
+		double ratio = std::log(1.0 + bucket.count) / logMax;
+		double barHeight = qMax(3.0, barArea.height() * ratio);
+		QRectF barRect(x0, barArea.bottom() - barHeight, x1 - x0, barHeight);
+		painter.fillRect(barRect, appColor(bucket.dominantApp));
+
+		if (drawThumbnails && bucket.representativeIndex >= 0) {
+			// 只画已缓存的准确缩略图，未缓存时取出代表帧的记录请求解码，完成后重绘
+			bool exact = false;
+			QImage thumbnail;
+			int index = bucket.representativeIndex;
+			AppRecord representative = m_recordLookup(index, bucket.representativeMs);
+			if (representative.timestamp.isValid()) {
+				thumbnail = m_thumbnails->request(index, representative, &exact);
+				m_thumbnailKeys.insert(ThumbnailCache::keyOf(representative));
+			}
+			if (exact && !thumbnail.isNull()) {
+				QRectF target(x0 + 1, barArea.top(), x1 - x0 - 2, barArea.height() * 0.6);
+				QSizeF fitted = QSizeF(thumbnail.size()).scaled(target.size(), Qt::KeepAspectRatio);
+				target = QRectF(target.center().x() - fitted.width() / 2, target.top(), fitted.width(), fitted.height());
+				painter.drawImage(target, thumbnail);
+			}
+		}
+	}
+
+	// 刻度：取不小于最小间隔的一级桶宽作为刻度间隔，按本地时间对齐
+	int tickLevel = level;
+	while (tickLevel < TimeAxisIndex::levelCount() - 1
+		&& TimeAxisIndex::levelWidth(tickLevel) * double(width()) / (m_toMs - m_fromMs) < kTickMinPixels) {
+		tickLevel++;
+	}
+	qint64 tickWidth = TimeAxisIndex::levelWidth(tickLevel);
+	QString format = tickWidth >= 24 * 60 * 60 * 1000 ? "MM-dd"
+		: (tickWidth >= 60 * 1000 ? "MM-dd hh:mm" : "hh:mm:ss");
+	if (m_toMs - m_fromMs < 24 * 60 * 60 * 1000 && tickWidth >= 60 * 1000) {
+		format = "hh:mm";
+	}
+	painter.setPen(QColor("#808080"));
+	QRect axisRect(0, height() - kAxisHeight, width(), kAxisHeight);
+	for (qint64 tick = m_index->bucketStart(tickLevel, m_fromMs); tick < m_toMs;
+		tick = m_index->nextBucketStart(tickLevel, tick)) {
+		int x = qRound(xAt(tick));
+		if (x < 0) {
+			continue;
+		}
+		painter.drawLine(x, axisRect.top(), x, axisRect.top() + 4);
+		painter.drawText(x + 3, axisRect.bottom() - 2, QDateTime::fromMSecsSinceEpoch(tick).toString(format));
+	}
+
+	// 当前时间
+	if (m_currentMs >= m_fromMs && m_currentMs <= m_toMs) {
+		int x = qRound(xAt(m_currentMs));
+		painter.setPen(QPen(QColor("#0064ff"), 2));
+		painter.drawLine(x, 0, x, height());
+	}
+}
+
+void TimeAxisView::wheelEvent(QWheelEvent* event)
+{
+	int delta = event->angleDelta().y();
+	if (delta == 0) {
+		return;
+	}
+
+	// 以鼠标所在的时间为中心缩放
+	double factor = delta > 0 ? 0.8 : 1.25;
+	int x = event->pos().x();
+	qint64 anchor = timeAt(x);
+	qint64 span = qBound(kMinSpanMs, qint64((m_toMs - m_fromMs) * factor), kMaxSpanMs);
+	qint64 from = anchor - qint64(double(x) / qMax(1, width()) * span);
+	m_fromMs = from;
+	m_toMs = from + span;
+	update();
+	event->accept();
+}
+
+void TimeAxisView::mousePressEvent(QMouseEvent* event)
+{
+	if (event->button() != Qt::LeftButton) {
+		return;
+	}
+	m_dragging = true;
+	m_moved = false;
+	m_pressPos = event->pos();
+	m_pressFromMs = m_fromMs;
+}
+
+void TimeAxisView::mouseMoveEvent(QMouseEvent* event)
+{
+	if (m_dragging) {
+		int dx = event->pos().x() - m_pressPos.x();
+		if (qAbs(dx) > kClickSlop) {
+			m_moved = true;
+		}
+		if (m_moved) {
+			qint64 span = m_toMs - m_fromMs;
+			m_fromMs = m_pressFromMs - qint64(double(dx) / qMax(1, width()) * span);
+			m_toMs = m_fromMs + span;
+			update();
+		}
+		return;
+	}
+
+	// 悬停时提示所在桶的汇总
+	if (!m_index || m_index->isEmpty()) {
+		return;
+	}
+	int level = currentLevel();
+	qint64 ms = timeAt(event->pos().x());
+	m_index->prepare(level, ms, ms + 1);
+	auto it = m_index->begin(level, ms);
+	if (it == m_index->end(level) || it.key() != m_index->bucketStart(level, ms)) {
+		QToolTip::hideText();
+		return;
+	}
+	const TimeAxisBucket& bucket = it.value();
+	qint64 bucketEnd = bucket.startMs + TimeAxisIndex::levelWidth(level);
+	QString text = QString("%1 - %2\n记录: %3 条\n主要应用: %4")
+		.arg(QDateTime::fromMSecsSinceEpoch(bucket.startMs).toString("MM-dd hh:mm:ss"))
+		.arg(QDateTime::fromMSecsSinceEpoch(bucketEnd).toString("MM-dd hh:mm:ss"))
+		.arg(bucket.count)
+		.arg(bucket.dominantApp);
+	QToolTip::showText(event->globalPos(), text, this);
+}
+
+void TimeAxisView::mouseReleaseEvent(QMouseEvent* event)
+{
+	if (event->button() != Qt::LeftButton || !m_dragging) {
+		return;
+	}
+	m_dragging = false;
+	if (!m_moved) {
+		emit timeSelected(timeAt(event->pos().x()));
+	}
+}
@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <QWidget>
+#include <QColor>
+#include <QPoint>
+#include <QSet>
+#include <functional>
+#include "thumbnailcache.h"
+#include "timeaxisindex.h"
+
+// 按真实时间绘制的时间轴
+// 横轴是时间而不是记录序号：密集截图的一段不会占满整条轴，空闲的时段也能看出来。
+// 滚轮以鼠标位置为中心缩放（1 分钟到 8 周），拖动平移，单击选中时间。
+// 绘制时按可见范围从 TimeAxisIndex 中选一级汇总，只画可见的桶：
+// 每个桶按主导应用着色、高度表示记录数，桶足够宽时显示代表帧的缩略图。
+class TimeAxisView : public QWidget {
+	Q_OBJECT
+public:
+	// 按代表帧记下的下标和时间戳取记录，index 返回记录当前的下标；记录已不存在时返回空记录
+	using RecordLookup = std::function<AppRecord(int& index, qint64 ms)>;
+
+	explicit TimeAxisView(QWidget* parent = nullptr);
+
+	// 汇总数据（由调用方持有，变化后调用 update()）
+	void setIndex(const TimeAxisIndex* index);
+
+	// 代表帧缩略图的来源，正在显示的代表帧解码完成后自动重绘
+	void setThumbnailCache(ThumbnailCache* cache);
+	void setRecordLookup(const RecordLookup& lookup);
+
+	// 当前时间（显示为竖线），不在可见范围内时平移过去
+	void setCurrentTime(qint64 ms);
+
+	// 可见范围
+	void setVisibleRange(qint64 fromMs, qint64 toMs);
+	qint64 visibleFrom() const;
+	qint64 visibleTo() const;
+
+	// 显示全部记录
+	void fitAll();
+
+	QSize sizeHint() const override;
+
+signals:
+	void timeSelected(qint64 ms);
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+	void wheelEvent(QWheelEvent* event) override;
+	void mousePressEvent(QMouseEvent* event) override;
+	void mouseMoveEvent(QMouseEvent* event) override;
+	void mouseReleaseEvent(QMouseEvent* event) override;
+
+private:
+	int currentLevel() const;
+	qint64 timeAt(int x) const;
+	double xAt(qint64 ms) const;
+	static QColor appColor(const QString& appName);
+
+	const TimeAxisIndex* m_index;
+	ThumbnailCache* m_thumbnails;
+	RecordLookup m_recordLookup;
+	QSet<ThumbnailKey> m_thumbnailKeys; // 上次绘制时可见桶的代表帧键（只有这些解码完成时才重绘）
+	qint64 m_fromMs;
+	qint64 m_toMs;
+	qint64 m_currentMs;                 // 当前时间（-1 表示无）
+
+	bool m_dragging;
+	bool m_moved;                       // 按下后移动过，松开时不当作单击
+	QPoint m_pressPos;
+	qint64 m_pressFromMs;
+};
@@ -0,0 +1,484 @@
+#include "framestore.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <algorithm>
+
+namespace {
+
+// 文件头和格式版本，结构变化时递增版本号
+const quint32 kIndexMagic = 0x46524d53; // "FRMS"
+const quint32 kIndexVersion = 2;
+
+// SHA-256 十六进制键长度
+const int kKeyLength = 64;
+
+} // namespace
+
+FrameStore::FrameStore()
+    : m_storedBytes(0)
+    , m_deduplicated(0)
+    , m_savedBytes(0)
+    , m_indexedRecords(0)
+    , m_reconciled(false)
+    , m_dirty(false)
+{
+}
+
+bool FrameStore::open(const QString &rootPath)
+{
+    QMutexLocker locker(&m_mutex);
+    if (rootPath.isEmpty() || !QDir().mkpath(QDir(rootPath).filePath("objects"))) {
+        qDebug() << "无法创建帧存储目录:" << rootPath;
+        return false;
+    }
+
+    m_rootPath = QDir(rootPath).absolutePath();
+    m_entries.clear();
+    m_storedBytes = 0;
+    m_indexedRecords = 0;
+    m_reconciled = false;
+    m_dirty = false;
+    loadIndex();
+    scanObjects();
+    return true;
+}
+
+QString FrameStore::rootPath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rootPath;
+}
+
+bool FrameStore::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_rootPath.isEmpty();
+}
+
+QByteArray FrameStore::hashImage(const QImage &image)
+{
+    if (image.isNull()) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+
+    // 尺寸和格式参与哈希，像素相同但形状不同的图像不会冲突
+    qint32 header[3] = { image.width(), image.height(), qint32(image.format()) };
+    hash.addData(reinterpret_cast<const char *>(header), sizeof(header));
+
+    // 逐行哈希，跳过行尾的对齐填充字节
+    int rowBytes = (image.width() * image.depth() + 7) / 8;
+    for (int y = 0; y < image.height(); ++y) {
+        hash.addData(reinterpret_cast<const char *>(image.constScanLine(y)), rowBytes);
+    }
+    return hash.result().toHex();
+}
+
+FrameStore::AcquireResult FrameStore::acquire(const QByteArray &key, qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_dirty = true;
+
+    FrameEntry &entry = m_entries[key];
+    entry.refCount++;
+    if (entry.missing) {
+        // 之前的写入失败，文件不存在，由这一帧重新写入
+        entry.missing = false;
+        m_storedBytes += bytes - entry.bytes;
+        entry.bytes = bytes;
+        return NeedsWrite;
+    }
+    if (entry.refCount > 1 || entry.bytes > 0) {
+        // 计数为 0 但尚未回收的帧同样可以直接复用
+        m_deduplicated++;
+        m_savedBytes += entry.bytes;
+        return AlreadyStored;
+    }
+
+    entry.bytes = bytes;
+    m_storedBytes += bytes;
+    return NeedsWrite;
+}
+
+void FrameStore::abortWrite(const QByteArray &key)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    // 只撤销调用方的引用；写入之前已有其他记录复用了这个键时保留它们的引用，
+    // 标记为缺失，下一帧相同内容重新写入
+    m_dirty = true;
+    if (it->refCount > 1) {
+        it->refCount--;
+        it->missing = true;
+        return;
+    }
+    m_storedBytes -= it->bytes;
+    m_entries.erase(it);
+}
+
+void FrameStore::markMissing(const QByteArray &key)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        it->missing = true;
+    }
+}
+
+bool FrameStore::addRef(const QByteArray &key)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+
+    it->refCount++;
+    m_dirty = true;
+    return true;
+}
+
+void FrameStore::release(const QByteArray &key)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    // 持久化引用只能由 expire() 释放；内存中的引用已全部释放时忽略（重复释放或帧已过期）
+    if (it == m_entries.end() || it->refCount <= it->persistentRefs) {
+        return;
+    }
+
+    it->refCount--;
+    m_dirty = true;
+}
+
+bool FrameStore::addPersistentRef(const QByteArray &key, qint64 timestampMs, const QString &appName)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+
+    it->refCount++;
+    it->persistentRefs++;
+    if (timestampMs >= it->lastUsedMs) {
+        it->lastUsedMs = timestampMs;
+        it->appName = appName;
+    }
+    m_dirty = true;
+    return true;
+}
+
+void FrameStore::expire(const QByteArray &key)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || it->persistentRefs <= 0) {
+        return;
+    }
+
+    it->refCount -= it->persistentRefs;
+    it->persistentRefs = 0;
+    m_dirty = true;
+}
+
+QVector<FrameUsage> FrameStore::persistentFrames() const
+{
+    QVector<FrameUsage> frames;
+    {
+        QMutexLocker locker(&m_mutex);
+        frames.reserve(m_entries.size());
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (it->persistentRefs <= 0) {
+                continue;
+            }
+            FrameUsage usage;
+            usage.key = it.key();
+            usage.bytes = it->bytes;
+            usage.lastUsedMs = it->lastUsedMs;
+            usage.appName = it->appName;
+            frames.append(usage);
+        }
+    }
+
+    std::sort(frames.begin(), frames.end(), [](const FrameUsage &a, const FrameUsage &b) {
+        return a.lastUsedMs < b.lastUsedMs;
+    });
+    return frames;
+}
+
+bool FrameStore::contains(const QByteArray &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.contains(key);
+}
+
+int FrameStore::refCount(const QByteArray &key) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.value(key).refCount;
+}
+
+QString FrameStore::blobPath(const QByteArray &key) const
+{
+    if (!isValidKey(key)) {
+        return QString();
+    }
+
+    // 按键的前两位分目录，避免单个目录下文件过多
+    QMutexLocker locker(&m_mutex);
+    QString name = QString::fromLatin1(key);
+    return QString("%1/objects/%2/%3.jpg").arg(m_rootPath, name.left(2), name.mid(2));
+}
+
+QByteArray FrameStore::keyForPath(const QString &filePath) const
+{
+    QFileInfo fileInfo(filePath);
+    QByteArray key = (fileInfo.dir().dirName() + fileInfo.completeBaseName()).toLatin1();
+    if (!isValidKey(key) || blobPath(key) != fileInfo.absoluteFilePath()) {
+        return QByteArray();
+    }
+    return key;
+}
+
+qint64 FrameStore::collectGarbage()
+{
+    QList<QByteArray> garbage;
+    {
+        QMutexLocker locker(&m_mutex);
+        // 异常退出后索引中的持久化引用可能不全，与记录索引对齐之前不删除任何帧
+        if (!m_reconciled) {
+            return 0;
+        }
+        for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+            if (it->refCount <= 0) {
+                garbage.append(it.key());
+            }
+        }
+    }
+
+    qint64 freedBytes = 0;
+    int removed = 0;
+    for (const QByteArray &key : garbage) {
+        QString path = blobPath(key);
+
+        QMutexLocker locker(&m_mutex);
+        // 收集之后可能又被引用，删除前再确认一次
+        auto it = m_entries.find(key);
+        if (it == m_entries.end() || it->refCount > 0) {
+            continue;
+        }
+        if (QFile::exists(path) && !QFile::remove(path)) {
+            qDebug() << "无法删除帧文件:" << path;
+            continue;
+        }
+
+        freedBytes += it->bytes;
+        m_storedBytes -= it->bytes;
+        m_entries.erase(it);
+        m_dirty = true;
+        removed++;
+    }
+
+    if (removed > 0) {
+        qDebug() << "帧存储回收完成，删除" << removed << "帧，释放" << freedBytes << "字节";
+    }
+    return freedBytes;
+}
+
+bool FrameStore::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_rootPath.isEmpty()) {
+        return false;
+    }
+
+    QString filePath = indexFile();
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入帧存储索引:" << filePath << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << kIndexMagic << kIndexVersion << m_indexedRecords << qint32(m_entries.size());
+    // 只保存持久化引用：内存中的记录不跨越重启，只被它们引用的帧在重启后回收
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        stream << it.key() << it->persistentRefs << it->bytes << it->lastUsedMs << it->appName;
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qDebug() << "保存帧存储索引失败:" << filePath;
+        return false;
+    }
+
+    m_dirty = false;
+    return true;
+}
+
+bool FrameStore::isDirty() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dirty;
+}
+
+void FrameStore::setIndexedRecords(qint64 count)
+{
+    QMutexLocker locker(&m_mutex);
+    if (count != m_indexedRecords) {
+        m_indexedRecords = count;
+        m_dirty = true;
+    }
+    m_reconciled = true;
+}
+
+qint64 FrameStore::indexedRecords() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_indexedRecords;
+}
+
+int FrameStore::uniqueFrameCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+qint64 FrameStore::storedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_storedBytes;
+}
+
+quint64 FrameStore::deduplicatedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_deduplicated;
+}
+
+qint64 FrameStore::savedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_savedBytes;
+}
+
+bool FrameStore::isValidKey(const QByteArray &key)
+{
+    if (key.size() != kKeyLength) {
+        return false;
+    }
+    for (char ch : key) {
+        if (!((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString FrameStore::indexFile() const
+{
+    return QDir(m_rootPath).filePath("refs.dat");
+}
+
+bool FrameStore::loadIndex()
+{
+    QString filePath = indexFile();
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 indexedRecords = 0;
+    qint32 entryCount = 0;
+    stream >> magic >> version >> indexedRecords >> entryCount;
+    if (magic != kIndexMagic || version != kIndexVersion || indexedRecords < 0 || entryCount < 0) {
+        qDebug() << "忽略不兼容的帧存储索引:" << filePath;
+        return false;
+    }
+
+    QHash<QByteArray, FrameEntry> entries;
+    qint64 storedBytes = 0;
+    entries.reserve(entryCount);
+    for (qint32 i = 0; i < entryCount && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray key;
+        FrameEntry entry;
+        stream >> key >> entry.persistentRefs >> entry.bytes >> entry.lastUsedMs >> entry.appName;
+        if (!isValidKey(key)) {
+            continue;
+        }
+        entry.refCount = entry.persistentRefs;
+        entries.insert(key, entry);
+        storedBytes += entry.bytes;
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qDebug() << "帧存储索引已损坏:" << filePath;
+        return false;
+    }
+
+    m_entries = entries;
+    m_storedBytes = storedBytes;
+    m_indexedRecords = indexedRecords;
+    qDebug() << "已加载帧存储索引，帧数:" << m_entries.size() << "字节数:" << m_storedBytes;
+    return true;
+}
+
+void FrameStore::scanObjects()
+{
+    // 索引只在保存时落盘，异常退出后目录中可能有索引之外的帧（保存之后写入），
+    // 索引中也可能有已不存在的帧（保存之后被回收）。以目录内容为准补齐：
+    // 索引之外的帧先登记为没有引用，与记录索引对齐后仍没有引用的由下次回收删除
+    QSet<QByteArray> found;
+    int orphans = 0;
+    QDirIterator it(QDir(m_rootPath).filePath("objects"), QStringList() << "*.jpg", QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo fileInfo = it.fileInfo();
+        QByteArray key = (fileInfo.dir().dirName() + fileInfo.completeBaseName()).toLatin1();
+        if (!isValidKey(key)) {
+            continue;
+        }
+        found.insert(key);
+        if (!m_entries.contains(key)) {
+            FrameEntry entry;
+            entry.bytes = fileInfo.size();
+            m_entries.insert(key, entry);
+            m_storedBytes += entry.bytes;
+            orphans++;
+        }
+    }
+
+    int missing = 0;
+    for (auto entry = m_entries.begin(); entry != m_entries.end(); ++entry) {
+        if (!found.contains(entry.key())) {
+            // 下一帧相同内容重新写入
+            entry->missing = true;
+            missing++;
+        }
+    }
+
+    if (orphans > 0 || missing > 0) {
+        m_dirty = true;
+        qDebug() << "帧存储目录与索引不一致，索引之外的帧:" << orphans << "缺失的帧:" << missing;
+    }
+}
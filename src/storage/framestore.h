@@ -0,0 +1,126 @@
+#ifndef FRAMESTORE_H
+#define FRAMESTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// 帧存储中单个内容块的条目
+struct FrameEntry {
+    qint32 refCount = 0;      // 引用该帧的记录数（内存中的记录和持久化历史中的记录）
+    qint32 persistentRefs = 0; // 其中持久化历史记录的引用（保存到索引文件，重启后只剩这部分）
+    qint64 bytes = 0;         // JPEG 文件大小
+    qint64 lastUsedMs = 0;    // 最近一条引用该帧的历史记录的时间
+    QString appName;          // 最近一条引用该帧的历史记录的应用
+    bool missing = false;     // 文件写入失败，下次获取相同内容时重新写入
+};
+
+// 持久化引用的帧（保留策略按此执行）
+struct FrameUsage {
+    QByteArray key;
+    qint64 bytes = 0;
+    qint64 lastUsedMs = 0;
+    QString appName;
+};
+
+// 内容寻址的帧存储
+// 以像素数据的 SHA-256 作为键，相同画面（静止的文档、锁屏等）只在磁盘上保存一份，
+// 任意多条 AppRecord 通过 frameKey 引用同一帧。每个键维护引用计数，
+// 计数归零的帧由 collectGarbage() 统一删除。
+// 引用有两类持有者：
+//   - 内存中的记录：流水线为每条记录 acquire()/addRef()，记录从内存历史中淘汰或清空时 release()
+//   - 持久化的历史记录：写入记录索引时 addPersistentRef()，保留策略使其过期时 expire() 一并释放
+//
+// 索引只在停止、切换目录和保留策略执行后保存，异常退出后可能落后于磁盘上的帧和记录索引。
+// 索引中同时保存已计入持久化引用的记录数（records.idx 中的前若干条），打开时扫描 objects 目录
+// 补齐索引之外的帧，之后由记录索引的所有者把其余记录的引用补上（setIndexedRecords()），
+// 在此之前 collectGarbage() 不删除任何帧。
+//
+// 目录结构：<root>/objects/<键前两位>/<键其余部分>.jpg，引用计数保存在 <root>/refs.dat。
+// 所有方法线程安全：提交阶段获取引用，编码线程池写入文件，GUI 线程和保留策略线程保存索引。
+class FrameStore
+{
+public:
+    // acquire() 的结果
+    enum AcquireResult {
+        AlreadyStored,    // 已有相同内容，只增加引用计数
+        NeedsWrite        // 新内容，调用方需要把数据写入 blobPath()
+    };
+
+    FrameStore();
+
+    // 打开存储目录并加载引用计数，目录不存在时创建
+    bool open(const QString &rootPath);
+    QString rootPath() const;
+    bool isOpen() const;
+
+    // 计算图像像素内容的键（64 位十六进制 SHA-256，包含尺寸和像素格式）
+    static QByteArray hashImage(const QImage &image);
+
+    // 为一条记录获取帧引用
+    AcquireResult acquire(const QByteArray &key, qint64 bytes);
+
+    // 未能提交写入时撤销 acquire() 获取的引用；仍有其他记录引用时保留条目，
+    // 标记为缺失，下一帧相同内容会重新写入
+    void abortWrite(const QByteArray &key);
+
+    // 已提交的写入失败：引用保持不变（由持有者照常释放），下一帧相同内容重新写入
+    void markMissing(const QByteArray &key);
+
+    // 增加/释放内存中记录的引用，释放到 0 的帧在下次回收时删除
+    bool addRef(const QByteArray &key);
+    void release(const QByteArray &key);
+
+    // 持久化的历史记录引用该帧（记录时间和应用用于保留策略）
+    bool addPersistentRef(const QByteArray &key, qint64 timestampMs, const QString &appName);
+
+    // 保留策略：释放历史记录对该帧的全部引用，没有其他引用时在下次回收时删除
+    void expire(const QByteArray &key);
+
+    // 有持久化引用的帧，最近使用时间早的在前
+    QVector<FrameUsage> persistentFrames() const;
+
+    // 查询
+    bool contains(const QByteArray &key) const;
+    int refCount(const QByteArray &key) const;
+    QString blobPath(const QByteArray &key) const;
+    QByteArray keyForPath(const QString &filePath) const;  // 不是本存储的帧文件时返回空
+
+    // 删除引用计数为 0 的帧，返回释放的字节数
+    qint64 collectGarbage();
+
+    // 持久化引用计数（原子写入）
+    bool save();
+    bool isDirty() const;
+
+    // 记录索引中前 count 条记录的持久化引用已计入，同时允许回收
+    void setIndexedRecords(qint64 count);
+    qint64 indexedRecords() const;
+
+    // 统计
+    int uniqueFrameCount() const;       // 磁盘上的不同帧数
+    qint64 storedBytes() const;         // 磁盘上帧文件的总字节数
+    quint64 deduplicatedCount() const;  // 因内容相同而省去写入的次数
+    qint64 savedBytes() const;          // 去重省下的字节数
+
+private:
+    static bool isValidKey(const QByteArray &key);
+    QString indexFile() const;
+    bool loadIndex();
+    void scanObjects();
+
+    mutable QMutex m_mutex;                   // 保护以下成员
+    QString m_rootPath;                       // 存储根目录
+    QHash<QByteArray, FrameEntry> m_entries;  // 键 -> 条目
+    qint64 m_storedBytes;                     // 帧文件总字节数
+    quint64 m_deduplicated;                   // 去重次数
+    qint64 m_savedBytes;                      // 去重省下的字节数
+    qint64 m_indexedRecords;                  // 已计入持久化引用的记录数
+    bool m_reconciled;                        // 打开后已与记录索引对齐
+    bool m_dirty;                             // 有未保存的修改
+};
+
+#endif // FRAMESTORE_H
@@ -0,0 +1,324 @@
+#include "iconstore.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QPainter>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+// 文件头和格式版本，结构变化时递增版本号
+const quint32 kAtlasMagic = 0x49434154; // "ICAT"
+const quint32 kAtlasVersion = 1;
+
+// 像素块按 16 字节对齐，QImage 直接包装映射内存时要求至少 4 字节对齐
+const qint64 kPixelAlignment = 16;
+
+qint64 alignUp(qint64 value)
+{
+    return (value + kPixelAlignment - 1) / kPixelAlignment * kPixelAlignment;
+}
+
+QString pixmapKey(const QString &key, int size)
+{
+    return key + QLatin1Char('@') + QString::number(size);
+}
+
+} // namespace
+
+IconStore::IconStore()
+    : m_pixelRatio(1.0)
+    , m_mapped(nullptr)
+    , m_dirty(false)
+{
+}
+
+IconStore::~IconStore()
+{
+    m_entries.clear();
+    if (m_mapped) {
+        m_file.unmap(m_mapped);
+    }
+}
+
+const QVector<int> &IconStore::sizes()
+{
+    static const QVector<int> list = { TimelineIconSize, BallIconSize };
+    return list;
+}
+
+bool IconStore::open(const QString &filePath, qreal devicePixelRatio)
+{
+    releaseMapping();
+    m_entries.clear();
+    m_pixmaps.clear();
+    m_filePath = filePath;
+    m_pixelRatio = devicePixelRatio > 0 ? devicePixelRatio : 1.0;
+    m_dirty = false;
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_mapped = m_file.map(0, m_file.size());
+    if (!m_mapped || !parseAtlas(m_mapped, m_file.size())) {
+        qDebug() << "忽略无效的图标图集:" << filePath;
+        m_entries.clear();
+        releaseMapping();
+        return false;
+    }
+
+    qDebug() << "已映射图标图集，图标数:" << m_entries.size();
+    return true;
+}
+
+bool IconStore::parseAtlas(const uchar *data, qint64 length)
+{
+    QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(length));
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 ratioPercent = 0;
+    quint32 sizeCount = 0;
+    stream >> magic >> version >> ratioPercent >> sizeCount;
+    if (magic != kAtlasMagic || version != kAtlasVersion
+        || ratioPercent != quint32(qRound(m_pixelRatio * 100)) || int(sizeCount) != sizes().size()) {
+        return false;
+    }
+    for (int size : sizes()) {
+        quint32 storedSize = 0;
+        stream >> storedSize;
+        if (int(storedSize) != size) {
+            return false;
+        }
+    }
+
+    quint32 entryCount = 0;
+    quint64 indexOffset = 0;
+    stream >> entryCount >> indexOffset;
+    if (stream.status() != QDataStream::Ok || qint64(indexOffset) >= length) {
+        return false;
+    }
+
+    stream.device()->seek(qint64(indexOffset));
+    for (quint32 i = 0; i < entryCount; ++i) {
+        QString key;
+        qint64 modifiedMs = -1;
+        stream >> key >> modifiedMs;
+
+        Entry entry;
+        entry.modifiedMs = modifiedMs;
+        for (int size : sizes()) {
+            quint64 offset = 0;
+            stream >> offset;
+            int pixels = pixelSize(size);
+            qint64 blockBytes = qint64(pixels) * pixels * 4;
+            if (qint64(offset) + blockBytes > length) {
+                return false;
+            }
+            // 直接包装映射内存，不拷贝。映射是只读的，必须使用 const uchar* 的构造函数：
+            // 这样 QImage 不会就地写入，任何修改都会先复制出自己的数据
+            const uchar *pixelData = data + offset;
+            entry.images.append(QImage(pixelData, pixels, pixels, pixels * 4,
+                                       QImage::Format_ARGB32_Premultiplied));
+        }
+        if (stream.status() != QDataStream::Ok) {
+            return false;
+        }
+        m_entries.insert(key, entry);
+    }
+    return true;
+}
+
+void IconStore::releaseMapping()
+{
+    if (!m_mapped) {
+        return;
+    }
+
+    // 解除映射前把仍在使用的图像复制出来
+    for (Entry &entry : m_entries) {
+        for (QImage &image : entry.images) {
+            image = image.copy();
+        }
+    }
+
+    m_file.unmap(m_mapped);
+    m_mapped = nullptr;
+    m_file.close();
+}
+
+bool IconStore::save()
+{
+    if (m_filePath.isEmpty()) {
+        return false;
+    }
+
+    // Windows 下无法替换仍被映射的文件
+    releaseMapping();
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入图标图集:" << m_filePath << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << kAtlasMagic << kAtlasVersion << quint32(qRound(m_pixelRatio * 100)) << quint32(sizes().size());
+    for (int size : sizes()) {
+        stream << quint32(size);
+    }
+    stream << quint32(m_entries.size());
+    qint64 indexOffsetPos = file.pos();
+    stream << quint64(0);
+
+    // 像素块
+    QHash<QString, QVector<quint64>> offsets;
+    static const char padding[kPixelAlignment] = {};
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QVector<quint64> entryOffsets;
+        for (const QImage &image : it->images) {
+            qint64 pos = file.pos();
+            qint64 aligned = alignUp(pos);
+            stream.writeRawData(padding, int(aligned - pos));
+            entryOffsets.append(quint64(aligned));
+            stream.writeRawData(reinterpret_cast<const char *>(image.constBits()), int(image.sizeInBytes()));
+        }
+        offsets.insert(it.key(), entryOffsets);
+    }
+
+    // 索引
+    quint64 indexOffset = quint64(file.pos());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        stream << it.key() << it->modifiedMs;
+        for (quint64 offset : offsets.value(it.key())) {
+            stream << offset;
+        }
+    }
+
+    file.seek(indexOffsetPos);
+    stream << indexOffset;
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qDebug() << "保存图标图集失败:" << m_filePath;
+        return false;
+    }
+
+    m_dirty = false;
+    return true;
+}
+
+bool IconStore::isDirty() const
+{
+    return m_dirty;
+}
+
+bool IconStore::contains(const QString &executablePath, qint64 modifiedMs) const
+{
+    return findEntry(executablePath, modifiedMs) != nullptr;
+}
+
+void IconStore::insert(const QString &executablePath, qint64 modifiedMs, const QIcon &icon)
+{
+    if (executablePath.isEmpty() || icon.isNull()) {
+        return;
+    }
+
+    Entry entry;
+    entry.modifiedMs = modifiedMs;
+    for (int size : sizes()) {
+        // 图标不一定有正好的尺寸，居中绘制到透明画布上
+        int pixels = pixelSize(size);
+        QImage image(pixels, pixels, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        icon.paint(&painter, image.rect());
+        painter.end();
+        entry.images.append(image);
+    }
+
+    QString key = cacheKey(executablePath);
+    m_entries.insert(key, entry);
+    for (int size : sizes()) {
+        m_pixmaps.remove(pixmapKey(key, size));
+    }
+    m_dirty = true;
+}
+
+QPixmap IconStore::pixmap(const QString &executablePath, qint64 modifiedMs, IconSize size) const
+{
+    const Entry *entry = findEntry(executablePath, modifiedMs);
+    int index = sizes().indexOf(size);
+    if (!entry || index < 0) {
+        return QPixmap();
+    }
+
+    QString key = pixmapKey(cacheKey(executablePath), size);
+    auto it = m_pixmaps.constFind(key);
+    if (it != m_pixmaps.constEnd()) {
+        return *it;
+    }
+
+    QPixmap result = QPixmap::fromImage(entry->images.at(index));
+    result.setDevicePixelRatio(m_pixelRatio);
+    m_pixmaps.insert(key, result);
+    return result;
+}
+
+QIcon IconStore::icon(const QString &executablePath, qint64 modifiedMs) const
+{
+    QIcon result;
+    for (int size : sizes()) {
+        QPixmap sizedPixmap = pixmap(executablePath, modifiedMs, IconSize(size));
+        if (!sizedPixmap.isNull()) {
+            result.addPixmap(sizedPixmap);
+        }
+    }
+    return result;
+}
+
+int IconStore::count() const
+{
+    return m_entries.size();
+}
+
+QString IconStore::defaultAtlasFile()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("icons.atlas");
+}
+
+QString IconStore::cacheKey(const QString &executablePath)
+{
+    // Windows 路径不区分大小写
+#ifdef _WIN32
+    return QDir::cleanPath(executablePath).toLower();
+#else
+    return QDir::cleanPath(executablePath);
+#endif
+}
+
+int IconStore::pixelSize(int logicalSize) const
+{
+    return qRound(logicalSize * m_pixelRatio);
+}
+
+const IconStore::Entry *IconStore::findEntry(const QString &executablePath, qint64 modifiedMs) const
+{
+    if (executablePath.isEmpty()) {
+        return nullptr;
+    }
+
+    auto it = m_entries.constFind(cacheKey(executablePath));
+    if (it == m_entries.constEnd() || it->modifiedMs != modifiedMs) {
+        return nullptr;
+    }
+    return &(*it);
+}
@@ -0,0 +1,74 @@
+#ifndef ICONSTORE_H
+#define ICONSTORE_H
+
+#include <QFile>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QPixmap>
+#include <QString>
+#include <QVector>
+
+// 应用图标库
+// 把图标按界面实际绘制的尺寸预先渲染好，保存在一个紧凑的图集文件中。
+// 启动时用 QFile::map 映射图集，像素直接包装成 QImage，不解码也不拷贝；
+// 切换应用时按可执行文件路径和修改时间取出图标，绘制时不再缩放。
+class IconStore
+{
+public:
+    // 预渲染的逻辑尺寸（像素），实际存储尺寸乘以设备像素比
+    enum IconSize {
+        TimelineIconSize = 16,   // 时间轴和记录列表
+        BallIconSize = 24        // 悬浮球左上角
+    };
+
+    IconStore();
+    ~IconStore();
+
+    // 打开图集文件并映射到内存，文件不存在或像素比不一致时从空库开始
+    bool open(const QString &filePath, qreal devicePixelRatio = 1.0);
+
+    // 写回图集文件（原子替换）
+    bool save();
+    bool isDirty() const;
+
+    // 是否有与给定修改时间匹配的图标
+    bool contains(const QString &executablePath, qint64 modifiedMs) const;
+
+    // 按所有预设尺寸渲染并保存图标
+    void insert(const QString &executablePath, qint64 modifiedMs, const QIcon &icon);
+
+    // 预渲染的位图（已设置设备像素比），没有时返回空位图
+    QPixmap pixmap(const QString &executablePath, qint64 modifiedMs, IconSize size) const;
+
+    // 由所有预渲染尺寸组成的图标
+    QIcon icon(const QString &executablePath, qint64 modifiedMs) const;
+
+    int count() const;
+
+    // 默认图集文件位置
+    static QString defaultAtlasFile();
+
+private:
+    struct Entry {
+        qint64 modifiedMs = -1;
+        QVector<QImage> images;   // 与 sizes() 一一对应，可能直接指向映射内存
+    };
+
+    static const QVector<int> &sizes();
+    static QString cacheKey(const QString &executablePath);
+    int pixelSize(int logicalSize) const;
+    const Entry *findEntry(const QString &executablePath, qint64 modifiedMs) const;
+    bool parseAtlas(const uchar *data, qint64 length);
+    void releaseMapping();
+
+    QString m_filePath;                          // 图集文件路径
+    qreal m_pixelRatio;                          // 设备像素比
+    QFile m_file;                                // 已映射的图集文件
+    uchar *m_mapped;                             // 映射地址
+    QHash<QString, Entry> m_entries;             // 路径 -> 各尺寸图像
+    mutable QHash<QString, QPixmap> m_pixmaps;   // 已转换的位图（路径@尺寸）
+    bool m_dirty;                                // 有未保存的修改
+};
+
+#endif // ICONSTORE_H
@@ -0,0 +1,333 @@
+#include "jpegencoderpool.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QImageWriter>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QBuffer>
+
+// 单个编码任务
+class JpegEncodeTask : public QRunnable
+{
+public:
+    JpegEncodeTask(JpegEncoderPool *pool, const QImage &image, const QByteArray &jpegData,
+                   const QString &filePath, int quality)
+        : m_pool(pool)
+        , m_image(image)
+        , m_jpegData(jpegData)
+        , m_filePath(filePath)
+        , m_quality(quality)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_pool->encode(m_image, m_jpegData, m_filePath, m_quality);
+    }
+
+private:
+    JpegEncoderPool *m_pool;
+    QImage m_image;
+    QByteArray m_jpegData;
+    QString m_filePath;
+    int m_quality;
+};
+
+// 单个内存编码任务
+class JpegMemoryEncodeTask : public QRunnable
+{
+public:
+    JpegMemoryEncodeTask(JpegEncoderPool *pool, const QImage &image, int quality)
+        : m_pool(pool)
+        , m_image(image)
+        , m_quality(quality)
+    {
+        setAutoDelete(true);
+    }
+
+    std::shared_future<QByteArray> future()
+    {
+        return m_result.get_future().share();
+    }
+
+    void run() override
+    {
+        m_result.set_value(m_pool->encodeToMemory(m_image, m_quality));
+    }
+
+private:
+    JpegEncoderPool *m_pool;
+    QImage m_image;
+    int m_quality;
+    std::promise<QByteArray> m_result;
+};
+
+JpegEncoderPool::JpegEncoderPool(QObject *parent)
+    : QObject(parent)
+    , m_maxBacklog(8)
+    , m_policy(BacklogPolicy::DropNewest)
+    , m_pending(0)
+    , m_shuttingDown(false)
+    , m_completed(0)
+    , m_dropped(0)
+    , m_failed(0)
+    , m_totalEncodeMs(0)
+    , m_maxEncodeMs(0)
+    , m_pendingEncodes(0)
+    , m_encoded(0)
+    , m_totalJpegEncodeNs(0)
+    , m_maxJpegEncodeNs(0)
+{
+    m_pool.setMaxThreadCount(2);
+}
+
+JpegEncoderPool::~JpegEncoderPool()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_shuttingDown = true;
+        m_slotFreed.wakeAll();
+    }
+
+    // 已提交的截图仍然写完，避免退出时丢失
+    m_pool.waitForDone();
+}
+
+void JpegEncoderPool::setThreadCount(int threadCount)
+{
+    m_pool.setMaxThreadCount(qMax(1, threadCount));
+}
+
+int JpegEncoderPool::threadCount() const
+{
+    return m_pool.maxThreadCount();
+}
+
+void JpegEncoderPool::setMaxBacklog(int maxBacklog)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxBacklog = qMax(1, maxBacklog);
+    m_slotFreed.wakeAll();
+}
+
+int JpegEncoderPool::maxBacklog() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxBacklog;
+}
+
+void JpegEncoderPool::setPolicy(BacklogPolicy policy)
+{
+    QMutexLocker locker(&m_mutex);
+    m_policy = policy;
+    m_slotFreed.wakeAll();
+}
+
+BacklogPolicy JpegEncoderPool::policy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_policy;
+}
+
+bool JpegEncoderPool::submit(const QImage &image, const QString &filePath, int quality)
+{
+    if (image.isNull() || filePath.isEmpty() || !acquireSlot()) {
+        return false;
+    }
+
+    m_pool.start(new JpegEncodeTask(this, image, QByteArray(), filePath, quality));
+    return true;
+}
+
+bool JpegEncoderPool::submitEncoded(const QByteArray &jpegData, const QString &filePath)
+{
+    if (jpegData.isEmpty() || filePath.isEmpty() || !acquireSlot()) {
+        return false;
+    }
+
+    m_pool.start(new JpegEncodeTask(this, QImage(), jpegData, filePath, 0));
+    return true;
+}
+
+std::shared_future<QByteArray> JpegEncoderPool::encodeAsync(const QImage &image, int quality)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pendingEncodes++;
+    }
+
+    JpegMemoryEncodeTask *task = new JpegMemoryEncodeTask(this, image, quality);
+    std::shared_future<QByteArray> result = task->future();
+    m_pool.start(task);
+    return result;
+}
+
+bool JpegEncoderPool::acquireSlot()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_pending >= m_maxBacklog && !m_shuttingDown) {
+        if (m_policy == BacklogPolicy::DropNewest) {
+            m_dropped++;
+            return false;
+        }
+        m_slotFreed.wait(&m_mutex);
+    }
+    if (m_shuttingDown) {
+        return false;
+    }
+    m_pending++;
+    return true;
+}
+
+void JpegEncoderPool::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+int JpegEncoderPool::backlog() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pending;
+}
+
+quint64 JpegEncoderPool::completedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_completed;
+}
+
+quint64 JpegEncoderPool::droppedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dropped;
+}
+
+quint64 JpegEncoderPool::failedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_failed;
+}
+
+double JpegEncoderPool::averageEncodeMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    quint64 finished = m_completed + m_failed;
+    return finished > 0 ? double(m_totalEncodeMs) / finished : 0.0;
+}
+
+double JpegEncoderPool::maxEncodeMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return double(m_maxEncodeMs);
+}
+
+int JpegEncoderPool::pendingEncodes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pendingEncodes;
+}
+
+quint64 JpegEncoderPool::encodedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_encoded;
+}
+
+double JpegEncoderPool::averageJpegEncodeMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_encoded > 0 ? m_totalJpegEncodeNs / 1e6 / m_encoded : 0.0;
+}
+
+double JpegEncoderPool::maxJpegEncodeMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxJpegEncodeNs / 1e6;
+}
+
+QByteArray JpegEncoderPool::encodeToMemory(const QImage &image, int quality)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QByteArray data;
+    if (!image.isNull()) {
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QImageWriter writer(&buffer, "JPEG");
+        writer.setQuality(quality);
+        if (!writer.write(image)) {
+            qDebug() << "截图压缩失败:" << writer.errorString();
+            data.clear();
+        }
+    }
+
+    qint64 elapsedNs = timer.nsecsElapsed();
+    QMutexLocker locker(&m_mutex);
+    m_pendingEncodes--;
+    m_encoded++;
+    m_totalJpegEncodeNs += elapsedNs;
+    m_maxJpegEncodeNs = qMax(m_maxJpegEncodeNs, elapsedNs);
+    return data;
+}
+
+void JpegEncoderPool::encode(const QImage &image, const QByteArray &jpegData, const QString &filePath, int quality)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // QSaveFile 先写临时文件，commit() 时原子重命名
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        finishTask(false, timer.elapsed());
+        emit encodeFailed(filePath, "Failed to save screenshot: " + filePath + " (" + file.errorString() + ")");
+        return;
+    }
+
+    if (!jpegData.isEmpty()) {
+        if (file.write(jpegData) != jpegData.size()) {
+            file.cancelWriting();
+            file.commit();
+            finishTask(false, timer.elapsed());
+            emit encodeFailed(filePath, "Failed to save screenshot: " + filePath + " (" + file.errorString() + ")");
+            return;
+        }
+    } else {
+        QImageWriter writer(&file, "JPEG");
+        writer.setQuality(quality);
+        if (!writer.write(image)) {
+            file.cancelWriting();
+            file.commit();
+            finishTask(false, timer.elapsed());
+            emit encodeFailed(filePath, "Failed to encode screenshot: " + filePath + " (" + writer.errorString() + ")");
+            return;
+        }
+    }
+
+    qint64 bytes = file.size();
+    if (!file.commit()) {
+        finishTask(false, timer.elapsed());
+        emit encodeFailed(filePath, "Failed to save screenshot: " + filePath + " (" + file.errorString() + ")");
+        return;
+    }
+
+    qint64 elapsedMs = timer.elapsed();
+    finishTask(true, elapsedMs);
+    emit encodeFinished(filePath, bytes, elapsedMs);
+}
+
+void JpegEncoderPool::finishTask(bool ok, qint64 elapsedMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pending--;
+    if (ok) {
+        m_completed++;
+    } else {
+        m_failed++;
+    }
+    m_totalEncodeMs += elapsedMs;
+    m_maxEncodeMs = qMax(m_maxEncodeMs, elapsedMs);
+    m_slotFreed.wakeOne();
+}
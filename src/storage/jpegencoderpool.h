@@ -0,0 +1,99 @@
+#ifndef JPEGENCODERPOOL_H
+#define JPEGENCODERPOOL_H
+
+#include <QObject>
+#include <QImage>
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <future>
+#include "../common.h"
+
+// JPEG 编码线程池
+// 在后台线程中编码图像并写入临时文件，完成后原子重命名为目标文件，
+// 读取方永远不会看到写了一半的截图。积压任务数有上限，超出时按策略阻塞或丢弃。
+// 也可以只编码到内存（encodeAsync），由调用方按需等待结果。
+class JpegEncoderPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JpegEncoderPool(QObject *parent = nullptr);
+    ~JpegEncoderPool();
+
+    // 配置
+    void setThreadCount(int threadCount);
+    int threadCount() const;
+    void setMaxBacklog(int maxBacklog);
+    int maxBacklog() const;
+    void setPolicy(BacklogPolicy policy);
+    BacklogPolicy policy() const;
+
+    // 提交编码任务，被丢弃时返回 false（线程安全）
+    bool submit(const QImage &image, const QString &filePath, int quality);
+
+    // 提交已编码好的 JPEG 数据，只执行原子写入
+    bool submitEncoded(const QByteArray &jpegData, const QString &filePath);
+
+    // 在线程池中编码到内存，不写文件；结果通过返回的 future 获取，编码失败时为空
+    // 不占用积压名额，同时在途的数量由调用方限制（流水线由有界队列限制）
+    std::shared_future<QByteArray> encodeAsync(const QImage &image, int quality);
+
+    // 等待所有任务完成
+    void waitForDone();
+
+    // 统计
+    int backlog() const;               // 排队和正在执行的任务数
+    quint64 completedCount() const;    // 成功写入的数量
+    quint64 droppedCount() const;      // 因积压被丢弃的数量
+    quint64 failedCount() const;       // 编码或写入失败的数量
+    double averageEncodeMs() const;    // 平均编码+写入耗时
+    double maxEncodeMs() const;        // 最大编码+写入耗时
+    int pendingEncodes() const;        // 排队和正在执行的内存编码数
+    quint64 encodedCount() const;      // 完成的内存编码数量
+    double averageJpegEncodeMs() const; // 内存编码平均耗时
+    double maxJpegEncodeMs() const;    // 内存编码最大耗时
+
+signals:
+    // 文件已写入
+    void encodeFinished(const QString &filePath, qint64 bytes, qint64 elapsedMs);
+
+    // 编码或写入失败
+    void encodeFailed(const QString &filePath, const QString &error);
+
+private:
+    friend class JpegEncodeTask;
+    friend class JpegMemoryEncodeTask;
+
+    // 占用一个积压名额，被丢弃或正在关闭时返回 false
+    bool acquireSlot();
+
+    // 在工作线程中执行；jpegData 非空时跳过编码
+    void encode(const QImage &image, const QByteArray &jpegData, const QString &filePath, int quality);
+    void finishTask(bool ok, qint64 elapsedMs);
+
+    // 在工作线程中编码到内存
+    QByteArray encodeToMemory(const QImage &image, int quality);
+
+    QThreadPool m_pool;              // 工作线程池
+
+    mutable QMutex m_mutex;          // 保护以下成员
+    QWaitCondition m_slotFreed;      // 有任务完成时唤醒阻塞的提交方
+    int m_maxBacklog;                // 最大积压数
+    BacklogPolicy m_policy;          // 积压策略
+    int m_pending;                   // 排队和正在执行的任务数
+    bool m_shuttingDown;             // 正在析构
+    quint64 m_completed;             // 成功数量
+    quint64 m_dropped;               // 丢弃数量
+    quint64 m_failed;                // 失败数量
+    qint64 m_totalEncodeMs;          // 累计耗时
+    qint64 m_maxEncodeMs;            // 最大耗时
+    int m_pendingEncodes;            // 在途的内存编码数
+    quint64 m_encoded;               // 完成的内存编码数
+    qint64 m_totalJpegEncodeNs;      // 内存编码累计耗时
+    qint64 m_maxJpegEncodeNs;        // 内存编码最大耗时
+};
+
+#endif // JPEGENCODERPOOL_H
@@ -0,0 +1,212 @@
+#include "processmetadatacache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+
+// 文件头和格式版本，结构变化时递增版本号
+const quint32 kCacheMagic = 0x504d4443; // "PMDC"
+const quint32 kCacheVersion = 2;
+
+// 低于这个 UID 的用户视为系统账户（root 和发行版的服务账户）
+const uint kFirstNormalUid = 1000;
+
+bool statFile(const QString &executablePath, qint64 &fileSize, qint64 &modifiedMs)
+{
+    QFileInfo fileInfo(executablePath);
+    if (!fileInfo.exists()) {
+        return false;
+    }
+    fileSize = fileInfo.size();
+    modifiedMs = fileInfo.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+} // namespace
+
+ProcessMetadataCache::ProcessMetadataCache()
+    : m_dirty(false)
+{
+}
+
+bool ProcessMetadataCache::lookup(const QString &executablePath, ProcessMetadata &metadata)
+{
+    if (executablePath.isEmpty()) {
+        return false;
+    }
+
+    QString key = cacheKey(executablePath);
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd()) {
+        return false;
+    }
+
+    qint64 fileSize = -1;
+    qint64 modifiedMs = -1;
+    if (!statFile(executablePath, fileSize, modifiedMs)
+        || fileSize != it->fileSize || modifiedMs != it->modifiedMs) {
+        qDebug() << "进程元数据已过期:" << executablePath;
+        m_entries.remove(key);
+        m_dirty = true;
+        return false;
+    }
+
+    metadata = *it;
+    return true;
+}
+
+void ProcessMetadataCache::insert(ProcessMetadata &metadata)
+{
+    if (metadata.executablePath.isEmpty()
+        || !statFile(metadata.executablePath, metadata.fileSize, metadata.modifiedMs)) {
+        return;
+    }
+
+    m_entries.insert(cacheKey(metadata.executablePath), metadata);
+    m_dirty = true;
+}
+
+void ProcessMetadataCache::clear()
+{
+    m_entries.clear();
+    m_dirty = true;
+}
+
+int ProcessMetadataCache::count() const
+{
+    return m_entries.size();
+}
+
+bool ProcessMetadataCache::load(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 entryCount = 0;
+    stream >> magic >> version >> entryCount;
+    if (magic != kCacheMagic || version != kCacheVersion || entryCount < 0) {
+        qDebug() << "忽略不兼容的进程元数据缓存:" << filePath;
+        return false;
+    }
+
+    QHash<QString, ProcessMetadata> entries;
+    entries.reserve(entryCount);
+    for (qint32 i = 0; i < entryCount && stream.status() == QDataStream::Ok; ++i) {
+        ProcessMetadata metadata;
+        stream >> metadata.executablePath >> metadata.fileSize >> metadata.modifiedMs
+               >> metadata.version >> metadata.description >> metadata.isSystemApp;
+        entries.insert(cacheKey(metadata.executablePath), metadata);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qDebug() << "进程元数据缓存已损坏:" << filePath;
+        return false;
+    }
+
+    m_entries = entries;
+    m_dirty = false;
+    qDebug() << "已加载进程元数据缓存，条目数:" << m_entries.size();
+    return true;
+}
+
+bool ProcessMetadataCache::save(const QString &filePath)
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入进程元数据缓存:" << filePath << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << kCacheMagic << kCacheVersion << qint32(m_entries.size());
+    for (const ProcessMetadata &metadata : m_entries) {
+        stream << metadata.executablePath << metadata.fileSize << metadata.modifiedMs
+               << metadata.version << metadata.description << metadata.isSystemApp;
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qDebug() << "保存进程元数据缓存失败:" << filePath;
+        return false;
+    }
+
+    m_dirty = false;
+    return true;
+}
+
+bool ProcessMetadataCache::isDirty() const
+{
+    return m_dirty;
+}
+
+QString ProcessMetadataCache::defaultCacheFile()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("process-metadata.cache");
+}
+
+bool ProcessMetadataCache::resolveFromProc(qint64 processId, ProcessMetadata &metadata)
+{
+#ifdef Q_OS_LINUX
+    if (processId <= 0) {
+        return false;
+    }
+
+    QString procDir = QString("/proc/%1").arg(processId);
+    QString executablePath = QFileInfo(procDir + "/exe").symLinkTarget();
+    if (executablePath.isEmpty()) {
+        return false;
+    }
+    metadata.executablePath = executablePath;
+
+    // comm 是内核记录的进程名（最多 15 个字符），作为描述
+    QFile comm(procDir + "/comm");
+    if (comm.open(QIODevice::ReadOnly)) {
+        metadata.description = QString::fromLocal8Bit(comm.readAll()).trimmed();
+    }
+
+    // status 中 "Uid:" 行依次为实际、有效、保存和文件系统 UID
+    QFile status(procDir + "/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        while (!status.atEnd()) {
+            QByteArray line = status.readLine();
+            if (line.startsWith("Uid:")) {
+                QList<QByteArray> fields = line.mid(4).simplified().split(' ');
+                bool ok = false;
+                uint uid = fields.isEmpty() ? 0 : fields.first().toUInt(&ok);
+                metadata.isSystemApp = ok && uid < kFirstNormalUid;
+                break;
+            }
+        }
+    }
+    return true;
+#else
+    Q_UNUSED(processId);
+    Q_UNUSED(metadata);
+    return false;
+#endif
+}
+
+QString ProcessMetadataCache::cacheKey(const QString &executablePath)
+{
+    // Windows 路径不区分大小写
+#ifdef _WIN32
+    return QDir::cleanPath(executablePath).toLower();
+#else
+    return QDir::cleanPath(executablePath);
+#endif
+}
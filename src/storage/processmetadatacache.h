@@ -0,0 +1,55 @@
+#ifndef PROCESSMETADATACACHE_H
+#define PROCESSMETADATACACHE_H
+
+#include <QHash>
+#include <QString>
+
+// 可执行文件的元数据（版本、描述等），解析代价较高，按文件缓存
+// 图标单独保存在 IconStore 中，以 fileSize/modifiedMs 相同的校验方式查找
+struct ProcessMetadata {
+    QString executablePath;   // 可执行文件路径
+    qint64 fileSize = -1;     // 文件大小（用于判断文件是否被替换）
+    qint64 modifiedMs = -1;   // 修改时间（毫秒时间戳）
+    QString version;          // 版本号
+    QString description;      // 描述
+    bool isSystemApp = false; // 是否系统应用
+};
+
+// 进程元数据缓存
+// 以可执行文件路径为键，文件大小和修改时间作为校验：程序升级后自动失效重新解析。
+// 内存中为哈希表，应用切换时只需一次 stat；可持久化到磁盘，重启后不必重新解析版本资源。
+class ProcessMetadataCache
+{
+public:
+    ProcessMetadataCache();
+
+    // 查找，文件不存在或大小/修改时间不匹配时返回 false 并移除过期条目
+    bool lookup(const QString &executablePath, ProcessMetadata &metadata);
+
+    // 写入，根据当前文件状态填充 metadata 的 fileSize 和 modifiedMs
+    void insert(ProcessMetadata &metadata);
+
+    // 清空
+    void clear();
+    int count() const;
+
+    // 持久化（原子写入），格式版本不匹配时忽略旧文件
+    bool load(const QString &filePath);
+    bool save(const QString &filePath);
+    bool isDirty() const;
+
+    // 默认缓存文件位置
+    static QString defaultCacheFile();
+
+    // 从 /proc 解析进程信息（仅 Linux，其他平台返回 false）
+    // 填充可执行文件路径、描述（进程名）和系统应用标记（root 或系统服务用户运行的进程）
+    static bool resolveFromProc(qint64 processId, ProcessMetadata &metadata);
+
+private:
+    static QString cacheKey(const QString &executablePath);
+
+    QHash<QString, ProcessMetadata> m_entries;   // 路径 -> 元数据
+    bool m_dirty;                                // 有未保存的修改
+};
+
+#endif // PROCESSMETADATACACHE_H
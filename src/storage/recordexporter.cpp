@@ -0,0 +1,387 @@
+#include "recordexporter.h"
+#include <QBuffer>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRunnable>
+#include <QThread>
+#include <QTimer>
+#include <cstring>
+
+namespace {
+
+// tar 块大小
+const int kTarBlockSize = 512;
+
+// 不导出截图时每轮事件循环写入的记录数，避免长时间占用 GUI 线程
+const int kMetadataBatch = 512;
+
+// 每个压缩线程最多同时处理的记录数
+const int kRecordsPerThread = 2;
+
+// 写入定长的八进制字段（以 NUL 结尾）
+void writeOctal(char *field, int width, qint64 value)
+{
+    QByteArray digits = QByteArray::number(value, 8).rightJustified(width - 1, '0');
+    std::memcpy(field, digits.constData(), size_t(width - 1));
+    field[width - 1] = '\0';
+}
+
+// ustar 格式的成员头
+QByteArray tarHeader(const QString &name, qint64 size, qint64 mtime)
+{
+    QByteArray header(kTarBlockSize, '\0');
+    char *data = header.data();
+
+    QByteArray nameBytes = name.toUtf8().left(99);
+    std::memcpy(data, nameBytes.constData(), size_t(nameBytes.size()));
+    writeOctal(data + 100, 8, 0644);          // mode
+    writeOctal(data + 108, 8, 0);             // uid
+    writeOctal(data + 116, 8, 0);             // gid
+    writeOctal(data + 124, 12, size);         // size
+    writeOctal(data + 136, 12, qMax<qint64>(0, mtime));
+    data[156] = '0';                          // 普通文件
+    std::memcpy(data + 257, "ustar", 6);      // magic（含 NUL）
+    std::memcpy(data + 263, "00", 2);         // version
+
+    // 校验和按校验和字段全为空格时计算
+    std::memset(data + 148, ' ', 8);
+    unsigned int checksum = 0;
+    for (int i = 0; i < kTarBlockSize; ++i) {
+        checksum += static_cast<unsigned char>(data[i]);
+    }
+    writeOctal(data + 148, 7, checksum);
+    data[155] = ' ';
+    return header;
+}
+
+// CSV 字段：含分隔符、引号或换行时加引号，内部引号加倍
+QByteArray csvField(const QString &value)
+{
+    QByteArray bytes = value.toUtf8();
+    if (!bytes.contains(',') && !bytes.contains('"') && !bytes.contains('\n') && !bytes.contains('\r')) {
+        return bytes;
+    }
+    bytes.replace("\"", "\"\"");
+    return '"' + bytes + '"';
+}
+
+// 读取并按需重新压缩一条记录的截图
+QByteArray prepareFrame(const RecordExporter::FrameLoader &loader, const ExportOptions &options,
+                        const AppRecord &record)
+{
+    QByteArray data = loader(record);
+    if (data.isEmpty() || (options.frameQuality < 0 && options.maxFrameWidth <= 0)) {
+        return data;
+    }
+
+    QImage image = QImage::fromData(data, "JPEG");
+    if (image.isNull()) {
+        return data;
+    }
+    bool resize = options.maxFrameWidth > 0 && image.width() > options.maxFrameWidth;
+    if (!resize && options.frameQuality < 0) {
+        return data;
+    }
+    if (resize) {
+        image = image.scaledToWidth(options.maxFrameWidth, Qt::SmoothTransformation);
+    }
+
+    QByteArray encoded;
+    QBuffer buffer(&encoded);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "JPEG", options.frameQuality)) {
+        qDebug() << "导出时重新压缩截图失败:" << record.appName;
+        return data;
+    }
+    return encoded;
+}
+
+} // namespace
+
+// 读取并压缩一条记录的截图，完成后排队回到导出器所在线程
+class ExportFrameTask : public QRunnable
+{
+public:
+    ExportFrameTask(RecordExporter *exporter, quint64 generation, int index, const AppRecord &record)
+        : m_exporter(exporter)
+        , m_generation(generation)
+        , m_index(index)
+        , m_record(record)
+        , m_loader(exporter->m_loader)
+        , m_options(exporter->m_options)
+    {
+    }
+
+    void run() override
+    {
+        QByteArray data = prepareFrame(m_loader, m_options, m_record);
+        RecordExporter *exporter = m_exporter;
+        quint64 generation = m_generation;
+        int index = m_index;
+        AppRecord record = m_record;
+        QMetaObject::invokeMethod(exporter, [exporter, generation, index, record, data]() {
+            exporter->onFrameReady(generation, index, record, data);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    RecordExporter *m_exporter;
+    quint64 m_generation;
+    int m_index;
+    AppRecord m_record;
+    RecordExporter::FrameLoader m_loader;
+    ExportOptions m_options;
+};
+
+RecordExporter::RecordExporter(QObject *parent)
+    : QObject(parent)
+    , m_running(false)
+    , m_generation(0)
+    , m_total(0)
+    , m_next(0)
+    , m_written(0)
+    , m_window(1)
+    , m_progressStep(1)
+{
+}
+
+RecordExporter::~RecordExporter()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+bool RecordExporter::start(const QString &filePath, int recordCount, const RecordSource &source,
+                           const FrameLoader &loader, const ExportOptions &options)
+{
+    if (m_running) {
+        emit errorOccurred("An export is already running: " + m_filePath);
+        return false;
+    }
+
+    // 上一次取消的导出可能还有任务在执行，等它们结束后再替换读取函数
+    m_pool.waitForDone();
+
+    m_filePath = filePath;
+    m_metadataFile.setFileName(filePath);
+    if (!m_metadataFile.open(QIODevice::WriteOnly)) {
+        emit errorOccurred("Failed to open export file: " + filePath + " " + m_metadataFile.errorString());
+        return false;
+    }
+
+    m_archivePath.clear();
+    if (options.includeFrames) {
+        QFileInfo fileInfo(filePath);
+        m_archivePath = fileInfo.dir().filePath(fileInfo.completeBaseName() + ".tar");
+        m_archiveFile.setFileName(m_archivePath);
+        if (!m_archiveFile.open(QIODevice::WriteOnly)) {
+            emit errorOccurred("Failed to open export archive: " + m_archivePath + " " + m_archiveFile.errorString());
+            m_metadataFile.cancelWriting();
+            m_metadataFile.commit();
+            return false;
+        }
+    }
+
+    if (options.format == ExportFormat::Csv) {
+        m_metadataFile.write("timestamp,app,path,title,frame,perceptual_hash,frame_key\n");
+    }
+
+    int threadCount = options.threadCount > 0 ? options.threadCount : QThread::idealThreadCount();
+    m_pool.setMaxThreadCount(qMax(1, threadCount));
+
+    m_source = source;
+    m_loader = loader;
+    m_options = options;
+    m_running = true;
+    m_generation++;
+    m_total = qMax(0, recordCount);
+    m_next = 0;
+    m_written = 0;
+    m_window = m_pool.maxThreadCount() * kRecordsPerThread;
+    m_progressStep = qMax(1, m_total / 200);
+    m_ready.clear();
+
+    // 第一批在下一轮事件循环中提交，调用方先连接好信号
+    quint64 generation = m_generation;
+    QTimer::singleShot(0, this, [this, generation]() {
+        if (generation == m_generation) {
+            pump();
+        }
+    });
+
+    qDebug() << "开始导出记录:" << filePath << "数量:" << m_total;
+    return true;
+}
+
+void RecordExporter::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+    qDebug() << "取消导出:" << m_filePath << "已写入" << m_written << "/" << m_total;
+    finish(false);
+}
+
+bool RecordExporter::isRunning() const
+{
+    return m_running;
+}
+
+QString RecordExporter::filePath() const
+{
+    return m_filePath;
+}
+
+QString RecordExporter::archivePath() const
+{
+    return m_archivePath;
+}
+
+void RecordExporter::pump()
+{
+    if (!m_running) {
+        return;
+    }
+    if (m_written == m_total) {
+        finish(true);
+        return;
+    }
+
+    // 不导出截图时直接写元数据，每轮只写一批
+    if (!m_options.includeFrames) {
+        int end = qMin(m_total, m_written + kMetadataBatch);
+        while (m_written < end) {
+            if (!writeRecord(m_written, m_source(m_written), QByteArray())) {
+                return;
+            }
+            m_written++;
+        }
+        emit progress(m_written, m_total);
+
+        quint64 generation = m_generation;
+        QTimer::singleShot(0, this, [this, generation]() {
+            if (generation == m_generation) {
+                pump();
+            }
+        });
+        return;
+    }
+
+    // 提交到处理中的记录数达到上限为止，写完一条才会再提交一条
+    while (m_next < m_total && m_next - m_written < m_window) {
+        AppRecord record = m_source(m_next);
+        record.screenshot = QImage();
+        m_pool.start(new ExportFrameTask(this, m_generation, m_next, record));
+        m_next++;
+    }
+}
+
+void RecordExporter::onFrameReady(quint64 generation, int index, const AppRecord &record, const QByteArray &jpegData)
+{
+    if (!m_running || generation != m_generation) {
+        return;
+    }
+
+    // 工作线程完成的顺序不确定，按下标顺序写入
+    m_ready.insert(index, qMakePair(record, jpegData));
+    while (!m_ready.isEmpty() && m_ready.firstKey() == m_written) {
+        QPair<AppRecord, QByteArray> item = m_ready.take(m_written);
+        if (!writeRecord(m_written, item.first, item.second)) {
+            return;
+        }
+        m_written++;
+        if (m_written % m_progressStep == 0 || m_written == m_total) {
+            emit progress(m_written, m_total);
+        }
+    }
+
+    pump();
+}
+
+bool RecordExporter::writeRecord(int index, const AppRecord &record, const QByteArray &jpegData)
+{
+    QString frameName;
+    if (m_options.includeFrames && !jpegData.isEmpty()) {
+        frameName = QString("frames/%1.jpg").arg(index + 1, 8, 10, QChar('0'));
+        if (!writeArchiveEntry(frameName, jpegData, record.timestamp.toSecsSinceEpoch())) {
+            finish(false, "Failed to write export archive: " + m_archivePath + " " + m_archiveFile.errorString());
+            return false;
+        }
+    }
+
+    QString timestamp = record.timestamp.toString(Qt::ISODateWithMs);
+    QString perceptualHash = QString("%1").arg(record.perceptualHash, 16, 16, QChar('0'));
+    QByteArray line;
+    if (m_options.format == ExportFormat::Csv) {
+        line = csvField(timestamp) + ',' + csvField(record.appName) + ',' + csvField(record.appPath) + ','
+            + csvField(record.windowTitle) + ',' + csvField(frameName) + ',' + perceptualHash.toLatin1() + ','
+            + record.frameKey + '\n';
+    } else {
+        QJsonObject object;
+        object["timestamp"] = timestamp;
+        object["app"] = record.appName;
+        object["path"] = record.appPath;
+        object["title"] = record.windowTitle;
+        object["frame"] = frameName;
+        object["perceptualHash"] = perceptualHash;
+        object["frameKey"] = QString::fromLatin1(record.frameKey);
+        line = QJsonDocument(object).toJson(QJsonDocument::Compact) + '\n';
+    }
+
+    if (m_metadataFile.write(line) != line.size()) {
+        finish(false, "Failed to write export file: " + m_filePath + " " + m_metadataFile.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool RecordExporter::writeArchiveEntry(const QString &name, const QByteArray &data, qint64 mtime)
+{
+    QByteArray header = tarHeader(name, data.size(), mtime);
+    int padding = (kTarBlockSize - data.size() % kTarBlockSize) % kTarBlockSize;
+    return m_archiveFile.write(header) == header.size()
+        && m_archiveFile.write(data) == data.size()
+        && m_archiveFile.write(QByteArray(padding, '\0')) == padding;
+}
+
+void RecordExporter::finish(bool ok, const QString &error)
+{
+    if (ok) {
+        // tar 以两个全零块结束
+        if (m_options.includeFrames) {
+            QByteArray trailer(kTarBlockSize * 2, '\0');
+            ok = m_archiveFile.write(trailer) == trailer.size() && m_archiveFile.commit();
+        }
+        ok = ok && m_metadataFile.commit();
+        if (!ok) {
+            emit errorOccurred("Failed to commit export: " + m_filePath);
+        }
+    } else if (!error.isEmpty()) {
+        emit errorOccurred(error);
+    }
+
+    // 失败或取消时丢弃临时文件，目标文件保持原样
+    if (!ok) {
+        if (m_metadataFile.isOpen()) {
+            m_metadataFile.cancelWriting();
+            m_metadataFile.commit();
+        }
+        if (m_archiveFile.isOpen()) {
+            m_archiveFile.cancelWriting();
+            m_archiveFile.commit();
+        }
+    }
+
+    m_running = false;
+    m_generation++;
+    m_ready.clear();
+    m_source = nullptr;
+    m_loader = nullptr;
+
+    qDebug() << "导出结束:" << m_filePath << (ok ? "成功" : "未完成") << "记录数:" << m_written;
+    emit finished(m_filePath, ok);
+}
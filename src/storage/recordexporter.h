@@ -0,0 +1,98 @@
+#ifndef RECORDEXPORTER_H
+#define RECORDEXPORTER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QMap>
+#include <QPair>
+#include <QSaveFile>
+#include <QString>
+#include <QThreadPool>
+#include <functional>
+#include "../common.h"
+
+// 导出的元数据格式
+enum class ExportFormat {
+    Jsonl,      // 每行一个 JSON 对象
+    Csv         // 带表头的 CSV
+};
+
+// 导出选项
+struct ExportOptions {
+    ExportFormat format = ExportFormat::Jsonl;
+    bool includeFrames = true;     // 是否把截图打包到 <元数据文件名>.tar
+    int frameQuality = -1;         // 重新压缩的 JPEG 质量，-1 表示原样复制存储中的数据
+    int maxFrameWidth = 0;         // 截图宽度上限，超过时等比缩小后重新压缩，0 表示不限制
+    int threadCount = 0;           // 压缩线程数，0 表示按 CPU 核数
+};
+
+// 流式导出记录
+// 在 GUI 线程中按下标逐条取出记录，截图的读取和重新压缩交给工作线程并行执行，
+// 完成的结果按原顺序写入元数据文件和 tar 包。同时处理中的记录数有固定上限，
+// 内存占用与导出的记录总数无关。
+//
+// 元数据中每条记录的 frame 字段是截图在 tar 包中的成员名（frames/00000001.jpg），
+// 没有截图时为空。两个文件都先写入临时文件，全部完成后才替换目标文件。
+class RecordExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 按下标取记录（在 GUI 线程中调用）
+    using RecordSource = std::function<AppRecord(int index)>;
+    // 读取记录的 JPEG 数据（在工作线程中调用，必须线程安全）
+    using FrameLoader = std::function<QByteArray(const AppRecord &record)>;
+
+    explicit RecordExporter(QObject *parent = nullptr);
+    ~RecordExporter();
+
+    // 开始导出 [0, recordCount) 的记录，已有导出进行中时返回 false
+    bool start(const QString &filePath, int recordCount, const RecordSource &source,
+               const FrameLoader &loader, const ExportOptions &options = ExportOptions());
+
+    // 取消导出，目标文件保持不变
+    void cancel();
+
+    bool isRunning() const;
+    QString filePath() const;
+    QString archivePath() const;
+
+signals:
+    // 已写入 done 条，共 total 条
+    void progress(int done, int total);
+
+    // 导出结束（成功、失败或取消）
+    void finished(const QString &filePath, bool ok);
+
+    void errorOccurred(const QString &error);
+
+private:
+    friend class ExportFrameTask;
+
+    void pump();
+    void onFrameReady(quint64 generation, int index, const AppRecord &record, const QByteArray &jpegData);
+    bool writeRecord(int index, const AppRecord &record, const QByteArray &jpegData);
+    bool writeArchiveEntry(const QString &name, const QByteArray &data, qint64 mtime);
+    void finish(bool ok, const QString &error = QString());
+
+    QThreadPool m_pool;                     // 压缩线程
+    RecordSource m_source;
+    FrameLoader m_loader;
+    ExportOptions m_options;
+
+    QSaveFile m_metadataFile;               // 元数据文件
+    QSaveFile m_archiveFile;                // 截图 tar 包
+    QString m_filePath;
+    QString m_archivePath;
+
+    bool m_running;
+    quint64 m_generation;                   // 每次导出递增，丢弃已取消导出的迟到结果
+    int m_total;                            // 导出的记录总数
+    int m_next;                             // 下一条要提交的记录
+    int m_written;                          // 已写入的记录数（也是下一条要写入的下标）
+    int m_window;                           // 同时处理中的记录数上限
+    int m_progressStep;                     // 每写入多少条报告一次进度
+    QMap<int, QPair<AppRecord, QByteArray>> m_ready;   // 已完成、等待按顺序写入的记录
+};
+
+#endif // RECORDEXPORTER_H
@@ -0,0 +1,498 @@
+#include "recordindex.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QSaveFile>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+// 文件头和格式版本，结构变化时递增版本号
+const quint32 kEntryMagic = 0x52494458;  // "RIDX"
+const quint32 kStringMagic = 0x52535452; // "RSTR"
+const quint32 kAppsMagic = 0x52415050;   // "RAPP"
+const quint32 kFormatVersion = 1;
+
+// records.idx 文件头长度，保证映射后索引项按 8 字节对齐
+const qint64 kEntryHeaderSize = 16;
+// strings.dat 文件头长度
+const qint64 kStringHeaderSize = 8;
+
+// 映射之后追加的项累积到这么多时重新映射
+const int kRemapEntries = 4096;
+
+// 帧存储内容键（SHA-256）字节数
+const int kKeyBytes = 32;
+
+QString appKey(const QString &appName, const QString &appPath)
+{
+    return appName + QLatin1Char('\n') + appPath;
+}
+
+} // namespace
+
+RecordIndex::RecordIndex()
+    : m_entryMap(nullptr)
+    , m_mappedCount(0)
+    , m_stringMap(nullptr)
+    , m_mappedStringBytes(kStringHeaderSize)
+    , m_lastTitleOffset(0)
+    , m_lastTitleLength(0)
+{
+}
+
+RecordIndex::~RecordIndex()
+{
+    close();
+}
+
+bool RecordIndex::open(const QString &rootPath)
+{
+    close();
+    if (rootPath.isEmpty() || !QDir().mkpath(rootPath)) {
+        qDebug() << "无法创建记录索引目录:" << rootPath;
+        return false;
+    }
+    QDir dir(rootPath);
+
+    m_entryFile.setFileName(dir.filePath("records.idx"));
+    m_stringFile.setFileName(dir.filePath("strings.dat"));
+    if (!m_entryFile.open(QIODevice::ReadWrite) || !m_stringFile.open(QIODevice::ReadWrite)) {
+        qDebug() << "无法打开记录索引:" << m_entryFile.fileName() << m_entryFile.errorString();
+        close();
+        return false;
+    }
+
+    // 新建或格式不符时清空重建（索引只是元数据，截图仍在存储中）
+    QDataStream entryStream(&m_entryFile);
+    QDataStream stringStream(&m_stringFile);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 entrySize = 0;
+    entryStream >> magic >> version >> entrySize;
+    bool entryValid = magic == kEntryMagic && version == kFormatVersion && entrySize == sizeof(RecordIndexEntry);
+    stringStream >> magic >> version;
+    bool stringValid = magic == kStringMagic && version == kFormatVersion;
+    if (!entryValid || !stringValid) {
+        if (m_entryFile.size() > 0) {
+            qDebug() << "忽略不兼容的记录索引:" << m_entryFile.fileName();
+        }
+        m_entryFile.resize(0);
+        m_stringFile.resize(0);
+        m_entryFile.seek(0);
+        m_stringFile.seek(0);
+        entryStream.resetStatus();
+        stringStream.resetStatus();
+        entryStream << kEntryMagic << kFormatVersion << quint32(sizeof(RecordIndexEntry)) << quint32(0);
+        stringStream << kStringMagic << kFormatVersion;
+        if (entryStream.status() != QDataStream::Ok || stringStream.status() != QDataStream::Ok) {
+            qDebug() << "无法写入记录索引文件头:" << m_entryFile.fileName();
+            close();
+            return false;
+        }
+    }
+
+    // 截掉写了一半的索引项
+    qint64 entryBytes = m_entryFile.size() - kEntryHeaderSize;
+    qint64 tornBytes = entryBytes % qint64(sizeof(RecordIndexEntry));
+    if (tornBytes != 0) {
+        qDebug() << "截断记录索引末尾不完整的项:" << tornBytes << "字节";
+        m_entryFile.resize(m_entryFile.size() - tornBytes);
+    }
+    m_entryFile.seek(m_entryFile.size());
+    m_stringFile.seek(m_stringFile.size());
+
+    m_rootPath = dir.absolutePath();
+    loadApps();
+    if (!mapFiles()) {
+        qDebug() << "无法映射记录索引:" << m_entryFile.fileName() << m_entryFile.errorString();
+        close();
+        return false;
+    }
+
+    qDebug() << "记录索引已打开:" << m_rootPath << "记录数:" << count();
+    return true;
+}
+
+void RecordIndex::close()
+{
+    unmapFiles();
+    m_entryFile.close();
+    m_stringFile.close();
+    m_rootPath.clear();
+    m_tail.clear();
+    m_stringTail.clear();
+    m_mappedCount = 0;
+    m_mappedStringBytes = kStringHeaderSize;
+    m_lastTitle.clear();
+    m_lastTitleOffset = 0;
+    m_lastTitleLength = 0;
+    m_apps.clear();
+    m_appIds.clear();
+}
+
+bool RecordIndex::isOpen() const
+{
+    return !m_rootPath.isEmpty();
+}
+
+QString RecordIndex::rootPath() const
+{
+    return m_rootPath;
+}
+
+bool RecordIndex::append(const AppRecord &record)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    RecordIndexEntry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    entry.timestampMs = record.timestamp.toMSecsSinceEpoch();
+    entry.appId = appIdFor(record.appName, record.appPath);
+    entry.titleOffset = appendTitle(record.windowTitle, entry.titleLength);
+    entry.perceptualHash = record.perceptualHash;
+    if (record.frameRef.isValid()) {
+        entry.frameSegment = record.frameRef.segment;
+        entry.frameOffset = record.frameRef.offset;
+        entry.frameLength = record.frameRef.length;
+    }
+    QByteArray key = QByteArray::fromHex(record.frameKey);
+    if (key.size() == kKeyBytes) {
+        std::memcpy(entry.frameKey, key.constData(), kKeyBytes);
+    }
+
+    const char *bytes = reinterpret_cast<const char *>(&entry);
+    if (m_entryFile.write(bytes, sizeof(entry)) != qint64(sizeof(entry))) {
+        qDebug() << "写入记录索引失败:" << m_entryFile.fileName() << m_entryFile.errorString();
+        return false;
+    }
+    m_tail.append(entry);
+
+    // 未映射的项过多时重新映射，之后的查询都直接读映射内存
+    if (m_tail.size() >= kRemapEntries && !mapFiles()) {
+        qDebug() << "重新映射记录索引失败:" << m_entryFile.fileName();
+    }
+    return true;
+}
+
+void RecordIndex::flush()
+{
+    // 字符串先于索引项交给操作系统，索引项引用的标题不会比索引项更晚落盘
+    if (m_stringFile.isOpen()) {
+        m_stringFile.flush();
+    }
+    if (m_entryFile.isOpen()) {
+        m_entryFile.flush();
+    }
+}
+
+int RecordIndex::count() const
+{
+    return m_mappedCount + m_tail.size();
+}
+
+RecordIndexEntry RecordIndex::entry(int index) const
+{
+    const RecordIndexEntry *pointer = entryPointer(index);
+    if (pointer) {
+        return *pointer;
+    }
+
+    RecordIndexEntry empty;
+    std::memset(&empty, 0, sizeof(empty));
+    return empty;
+}
+
+qint64 RecordIndex::timestampAt(int index) const
+{
+    const RecordIndexEntry *pointer = entryPointer(index);
+    return pointer ? pointer->timestampMs : 0;
+}
+
+int RecordIndex::lowerBound(qint64 timestampMs) const
+{
+    // 记录按截图顺序追加，时间戳单调不减，二分查找只触及 log(n) 个页
+    int first = 0;
+    int length = count();
+    while (length > 0) {
+        int half = length / 2;
+        if (timestampAt(first + half) < timestampMs) {
+            first += half + 1;
+            length -= half + 1;
+        } else {
+            length = half;
+        }
+    }
+    return first;
+}
+
+QString RecordIndex::windowTitle(const RecordIndexEntry &entry) const
+{
+    if (entry.titleLength == 0) {
+        return QString();
+    }
+
+    qint64 offset = qint64(entry.titleOffset);
+    qint64 end = offset + qint64(entry.titleLength);
+    if (offset >= kStringHeaderSize && end <= m_mappedStringBytes) {
+        return QString::fromUtf8(reinterpret_cast<const char *>(m_stringMap + offset), int(entry.titleLength));
+    }
+    if (offset >= m_mappedStringBytes && end - m_mappedStringBytes <= m_stringTail.size()) {
+        return QString::fromUtf8(m_stringTail.constData() + (offset - m_mappedStringBytes), int(entry.titleLength));
+    }
+
+    // 崩溃时标题没有写完
+    return QString();
+}
+
+QString RecordIndex::appName(quint32 appId) const
+{
+    return appId < quint32(m_apps.size()) ? m_apps.at(int(appId)).first : QString();
+}
+
+QString RecordIndex::appPath(quint32 appId) const
+{
+    return appId < quint32(m_apps.size()) ? m_apps.at(int(appId)).second : QString();
+}
+
+AppRecord RecordIndex::record(int index) const
+{
+    AppRecord record;
+    const RecordIndexEntry *pointer = entryPointer(index);
+    if (!pointer) {
+        return record;
+    }
+
+    record.appName = appName(pointer->appId);
+    record.appPath = appPath(pointer->appId);
+    record.timestamp = QDateTime::fromMSecsSinceEpoch(pointer->timestampMs);
+    record.windowTitle = windowTitle(*pointer);
+    record.perceptualHash = pointer->perceptualHash;
+    record.frameRef.segment = pointer->frameSegment;
+    record.frameRef.offset = pointer->frameOffset;
+    record.frameRef.length = pointer->frameLength;
+
+    static const QByteArray emptyKey(kKeyBytes, '\0');
+    QByteArray key(reinterpret_cast<const char *>(pointer->frameKey), kKeyBytes);
+    if (key != emptyKey) {
+        record.frameKey = key.toHex();
+    }
+    return record;
+}
+
+int RecordIndex::relocateFrames(const FrameRelocation &relocation)
+{
+    if (!isOpen()) {
+        return 0;
+    }
+
+    // 截图位置三个字段在索引项中连续存放，一次写入
+    struct FrameLocation {
+        quint64 offset;
+        quint32 segment;
+        quint32 length;
+    };
+    Q_STATIC_ASSERT(offsetof(RecordIndexEntry, frameSegment) == offsetof(RecordIndexEntry, frameOffset) + 8);
+    Q_STATIC_ASSERT(offsetof(RecordIndexEntry, frameLength) == offsetof(RecordIndexEntry, frameOffset) + 12);
+
+    // 段中的记录在索引里按时间连续，只需扫描段的时间范围
+    int relocated = 0;
+    for (int i = lowerBound(relocation.fromMs); i < count(); ++i) {
+        const RecordIndexEntry *pointer = entryPointer(i);
+        if (pointer->timestampMs > relocation.toMs) {
+            break;
+        }
+        if (pointer->frameSegment != relocation.segment) {
+            continue;
+        }
+
+        FrameRef target;
+        if (!relocation.removed) {
+            auto it = relocation.moves.constFind(pointer->frameOffset);
+            if (it == relocation.moves.constEnd()) {
+                continue;
+            }
+            target = it.value();
+        }
+
+        FrameLocation location = { 0, 0, 0 };
+        if (target.isValid()) {
+            location.offset = target.offset;
+            location.segment = target.segment;
+            location.length = target.length;
+        }
+        qint64 filePos = kEntryHeaderSize + qint64(i) * qint64(sizeof(RecordIndexEntry))
+            + qint64(offsetof(RecordIndexEntry, frameOffset));
+        if (!m_entryFile.seek(filePos)
+            || m_entryFile.write(reinterpret_cast<const char *>(&location), sizeof(location)) != qint64(sizeof(location))) {
+            qDebug() << "改写记录索引失败:" << m_entryFile.fileName() << m_entryFile.errorString();
+            break;
+        }
+        if (i >= m_mappedCount) {
+            RecordIndexEntry &entry = m_tail[i - m_mappedCount];
+            entry.frameOffset = location.offset;
+            entry.frameSegment = location.segment;
+            entry.frameLength = location.length;
+        }
+        relocated++;
+    }
+
+    // 回到文件末尾继续追加；写缓冲交给操作系统后共享映射中即可看到新值
+    m_entryFile.seek(m_entryFile.size());
+    m_entryFile.flush();
+    return relocated;
+}
+
+const RecordIndexEntry *RecordIndex::entryPointer(int index) const
+{
+    if (index < 0 || index >= count()) {
+        return nullptr;
+    }
+    if (index < m_mappedCount) {
+        return reinterpret_cast<const RecordIndexEntry *>(m_entryMap + kEntryHeaderSize) + index;
+    }
+    return &m_tail.at(index - m_mappedCount);
+}
+
+quint32 RecordIndex::appIdFor(const QString &appName, const QString &appPath)
+{
+    QString key = appKey(appName, appPath);
+    auto it = m_appIds.constFind(key);
+    if (it != m_appIds.constEnd()) {
+        return it.value();
+    }
+
+    quint32 appId = quint32(m_apps.size());
+    m_apps.append(qMakePair(appName, appPath));
+    m_appIds.insert(key, appId);
+    saveApps();
+    return appId;
+}
+
+quint64 RecordIndex::appendTitle(const QString &title, quint32 &length)
+{
+    // 同一窗口连续截图的标题通常相同，复用上一次写入的位置
+    if (title == m_lastTitle && m_lastTitleOffset != 0) {
+        length = m_lastTitleLength;
+        return m_lastTitleOffset;
+    }
+
+    QByteArray bytes = title.toUtf8();
+    if (bytes.isEmpty()) {
+        length = 0;
+        return 0;
+    }
+
+    quint64 offset = quint64(m_mappedStringBytes + m_stringTail.size());
+    if (m_stringFile.write(bytes) != bytes.size()) {
+        qDebug() << "写入记录索引字符串表失败:" << m_stringFile.fileName() << m_stringFile.errorString();
+        length = 0;
+        return 0;
+    }
+    m_stringTail.append(bytes);
+
+    length = quint32(bytes.size());
+    m_lastTitle = title;
+    m_lastTitleOffset = offset;
+    m_lastTitleLength = length;
+    return offset;
+}
+
+bool RecordIndex::loadApps()
+{
+    m_apps.clear();
+    m_appIds.clear();
+
+    QFile file(QDir(m_rootPath).filePath("apps.dat"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QVector<QPair<QString, QString>> apps;
+    stream >> magic >> version >> apps;
+    if (stream.status() != QDataStream::Ok || magic != kAppsMagic || version != kFormatVersion) {
+        qDebug() << "忽略无效的应用表:" << file.fileName();
+        return false;
+    }
+
+    m_apps = apps;
+    for (int i = 0; i < m_apps.size(); ++i) {
+        m_appIds.insert(appKey(m_apps[i].first, m_apps[i].second), quint32(i));
+    }
+    return true;
+}
+
+bool RecordIndex::saveApps()
+{
+    QSaveFile file(QDir(m_rootPath).filePath("apps.dat"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入应用表:" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << kAppsMagic << kFormatVersion << m_apps;
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qDebug() << "保存应用表失败:" << file.fileName();
+        return false;
+    }
+    return true;
+}
+
+bool RecordIndex::mapFiles()
+{
+    flush();
+
+    // 映射整个文件，只建立映射关系，页在第一次访问时才读入。
+    // 新映射建立成功后才释放旧映射，失败时仍可继续使用旧映射和内存中的项
+    qint64 entryBytes = m_entryFile.size() - kEntryHeaderSize;
+    int entryCount = int(entryBytes / qint64(sizeof(RecordIndexEntry)));
+    uchar *entryMap = nullptr;
+    if (entryCount > 0) {
+        entryMap = m_entryFile.map(0, kEntryHeaderSize + qint64(entryCount) * qint64(sizeof(RecordIndexEntry)));
+        if (!entryMap) {
+            return false;
+        }
+    }
+
+    qint64 stringBytes = m_stringFile.size();
+    uchar *stringMap = nullptr;
+    if (stringBytes > kStringHeaderSize) {
+        stringMap = m_stringFile.map(0, stringBytes);
+        if (!stringMap) {
+            if (entryMap) {
+                m_entryFile.unmap(entryMap);
+            }
+            return false;
+        }
+    }
+
+    unmapFiles();
+    m_entryMap = entryMap;
+    m_stringMap = stringMap;
+    m_mappedCount = entryCount;
+    m_mappedStringBytes = qMax(kStringHeaderSize, stringBytes);
+    m_tail.clear();
+    m_stringTail.clear();
+    return true;
+}
+
+void RecordIndex::unmapFiles()
+{
+    if (m_entryMap) {
+        m_entryFile.unmap(m_entryMap);
+        m_entryMap = nullptr;
+    }
+    if (m_stringMap) {
+        m_stringFile.unmap(m_stringMap);
+        m_stringMap = nullptr;
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef RECORDINDEX_H
+#define RECORDINDEX_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include "../common.h"
+
+// 记录索引中的一项，定长，按本机字节序直接写入文件并从映射内存中读取
+struct RecordIndexEntry {
+    qint64 timestampMs;       // 截图时间（毫秒）
+    quint32 appId;            // 应用编号（见 RecordIndex::appName）
+    quint32 titleLength;      // 窗口标题长度（UTF-8 字节）
+    quint64 titleOffset;      // 窗口标题在字符串表中的偏移
+    quint64 perceptualHash;   // 感知哈希
+    quint64 frameOffset;      // 截图数据在段文件中的偏移
+    quint32 frameSegment;     // 截图数据所在的段（0 表示不在段存储中）
+    quint32 frameLength;      // 截图数据长度
+    uchar frameKey[32];       // 帧存储内容键（SHA-256 原始字节，全 0 表示没有）
+};
+
+Q_STATIC_ASSERT(sizeof(RecordIndexEntry) == 80);
+
+// 持久化的记录索引
+// 每条记录的元数据（时间、应用、窗口标题、截图位置）以定长项追加到 records.idx，
+// 打开时用 QFile::map 映射整个文件，不解析、不拷贝，记录数只由文件长度决定，
+// 多年的历史也能在毫秒级打开；浏览时只有被访问的页才会读入内存。
+// 变长的窗口标题追加到 strings.dat，索引项只保存偏移和长度；应用名和路径保存在 apps.dat。
+//
+// 映射之后追加的项先留在内存中，累积到一定数量再重新映射。
+// 截图位置在旧段压缩后原地改写，映射是共享的，改写后立即可见。
+// 写入顺序是先字符串后索引项，崩溃时最多丢失末尾几条记录或它们的标题。
+//
+// 目录结构：<root>/records.idx、strings.dat、apps.dat。
+// 非线程安全，只在 GUI 线程中使用。
+class RecordIndex
+{
+public:
+    RecordIndex();
+    ~RecordIndex();
+
+    // 打开索引目录并映射已有记录
+    bool open(const QString &rootPath);
+    void close();
+    bool isOpen() const;
+    QString rootPath() const;
+
+    // 追加一条记录的元数据（不保存截图）
+    bool append(const AppRecord &record);
+
+    // 把写缓冲交给操作系统
+    void flush();
+
+    // 查询
+    int count() const;
+    RecordIndexEntry entry(int index) const;
+    qint64 timestampAt(int index) const;
+    int lowerBound(qint64 timestampMs) const;   // 第一条时间不早于 timestampMs 的记录
+    QString windowTitle(const RecordIndexEntry &entry) const;
+    QString appName(quint32 appId) const;
+    QString appPath(quint32 appId) const;
+
+    // 还原为不含截图的记录，截图按 frameRef / frameKey 到存储中读取
+    AppRecord record(int index) const;
+
+    // 段被压缩或删除后更新受影响记录的截图位置（原地改写索引项），返回更新的条数
+    int relocateFrames(const FrameRelocation &relocation);
+
+private:
+    const RecordIndexEntry *entryPointer(int index) const;
+    quint32 appIdFor(const QString &appName, const QString &appPath);
+    quint64 appendTitle(const QString &title, quint32 &length);
+    bool loadApps();
+    bool saveApps();
+    bool mapFiles();
+    void unmapFiles();
+
+    QString m_rootPath;                          // 索引目录
+
+    QFile m_entryFile;                           // records.idx
+    uchar *m_entryMap;                           // records.idx 的映射地址
+    int m_mappedCount;                           // 映射覆盖的项数
+    QVector<RecordIndexEntry> m_tail;            // 映射之后追加的项
+
+    QFile m_stringFile;                          // strings.dat
+    uchar *m_stringMap;                          // strings.dat 的映射地址
+    qint64 m_mappedStringBytes;                  // 映射覆盖的字节数（含文件头）
+    QByteArray m_stringTail;                     // 映射之后追加的字符串
+    QString m_lastTitle;                         // 上一条记录的标题，连续相同时复用偏移
+    quint64 m_lastTitleOffset;
+    quint32 m_lastTitleLength;
+
+    QVector<QPair<QString, QString>> m_apps;     // 应用编号 -> (应用名, 路径)
+    QHash<QString, quint32> m_appIds;            // 应用名 + 路径 -> 应用编号
+};
+
+#endif // RECORDINDEX_H
@@ -0,0 +1,196 @@
+#include "recordstore.h"
+#include <QReadLocker>
+#include <QWriteLocker>
+
+RecordStore::RecordStore(qint64 byteBudget, QObject *parent)
+    : QObject(parent)
+    , m_head(0)
+    , m_byteBudget(qMax<qint64>(0, byteBudget))
+    , m_byteSize(0)
+    , m_evicted(0)
+{
+    qRegisterMetaType<RecordHandle>("RecordHandle");
+}
+
+void RecordStore::setReleaseHandler(const ReleaseHandler &handler)
+{
+    QWriteLocker locker(&m_lock);
+    m_releaseHandler = handler;
+}
+
+void RecordStore::setByteBudget(qint64 byteBudget)
+{
+    int evicted = 0;
+    QVector<RecordHandle> released;
+    {
+        QWriteLocker locker(&m_lock);
+        m_byteBudget = qMax<qint64>(0, byteBudget);
+        evicted = evictToBudgetLocked(released);
+    }
+    notifyReleased(released);
+    if (evicted > 0) {
+        emit recordsEvicted(evicted);
+    }
+}
+
+qint64 RecordStore::byteBudget() const
+{
+    QReadLocker locker(&m_lock);
+    return m_byteBudget;
+}
+
+int RecordStore::append(const AppRecord &record)
+{
+    // 原图不进入历史，只保留压缩数据
+    AppRecord *stored = new AppRecord(record);
+    stored->screenshot = QImage();
+    RecordHandle handle(stored);
+
+    int evicted = 0;
+    QVector<RecordHandle> released;
+    {
+        QWriteLocker locker(&m_lock);
+        m_byteSize += addBytesLocked(*handle);
+        m_records.append(handle);
+        evicted = evictToBudgetLocked(released);
+    }
+    notifyReleased(released);
+    emit recordAppended(handle, evicted);
+    return evicted;
+}
+
+void RecordStore::clear()
+{
+    QVector<RecordHandle> released;
+    {
+        QWriteLocker locker(&m_lock);
+        released = m_records.mid(m_head);
+        m_records.clear();
+        m_head = 0;
+        m_byteSize = 0;
+        m_payloads.clear();
+    }
+    notifyReleased(released);
+    emit cleared();
+}
+
+int RecordStore::count() const
+{
+    QReadLocker locker(&m_lock);
+    return m_records.size() - m_head;
+}
+
+bool RecordStore::isEmpty() const
+{
+    return count() == 0;
+}
+
+RecordHandle RecordStore::at(int index) const
+{
+    QReadLocker locker(&m_lock);
+    if (index < 0 || index >= m_records.size() - m_head) {
+        return RecordHandle();
+    }
+    return m_records.at(m_head + index);
+}
+
+RecordHandle RecordStore::last() const
+{
+    QReadLocker locker(&m_lock);
+    if (m_records.size() == m_head) {
+        return RecordHandle();
+    }
+    return m_records.last();
+}
+
+QVector<RecordHandle> RecordStore::snapshot() const
+{
+    QReadLocker locker(&m_lock);
+    return m_records.mid(m_head);
+}
+
+qint64 RecordStore::byteSize() const
+{
+    QReadLocker locker(&m_lock);
+    return m_byteSize;
+}
+
+quint64 RecordStore::evictedCount() const
+{
+    QReadLocker locker(&m_lock);
+    return m_evicted;
+}
+
+qint64 RecordStore::recordBytes(const AppRecord &record)
+{
+    // 文本字段按 UTF-16 计算，另加结构体本身的开销
+    qint64 textBytes = (record.appName.size() + record.appPath.size() + record.windowTitle.size()) * 2;
+    return record.encodedScreenshot.size() + textBytes + qint64(sizeof(AppRecord));
+}
+
+qint64 RecordStore::addBytesLocked(const AppRecord &record)
+{
+    // 同一份压缩数据只在第一条引用它的记录进入时计入。
+    // 存储中的记录不可修改，数据不会分离，地址在最后一条记录离开之前保持有效
+    qint64 bytes = recordBytes(record);
+    if (!record.encodedScreenshot.isEmpty() && m_payloads[record.encodedScreenshot.constData()]++ > 0) {
+        bytes -= record.encodedScreenshot.size();
+    }
+    return bytes;
+}
+
+qint64 RecordStore::removeBytesLocked(const AppRecord &record)
+{
+    // 最后一条引用它的记录离开时才扣除压缩数据
+    qint64 bytes = recordBytes(record);
+    auto it = m_payloads.find(record.encodedScreenshot.constData());
+    if (record.encodedScreenshot.isEmpty() || it == m_payloads.end()) {
+        return bytes;
+    }
+    if (--it.value() > 0) {
+        bytes -= record.encodedScreenshot.size();
+    } else {
+        m_payloads.erase(it);
+    }
+    return bytes;
+}
+
+int RecordStore::evictToBudgetLocked(QVector<RecordHandle> &released)
+{
+    // 至少保留最新的一条，即使它本身超过上限
+    int evicted = 0;
+    while (m_byteSize > m_byteBudget && m_records.size() - m_head > 1) {
+        m_byteSize -= removeBytesLocked(*m_records.at(m_head));
+        released.append(m_records.at(m_head));
+        m_records[m_head].reset();
+        m_head++;
+        evicted++;
+    }
+
+    // 头部空出的位置超过一半时再整体前移，淘汰的均摊开销为常数
+    if (m_head > 0 && m_head * 2 >= m_records.size()) {
+        m_records.remove(0, m_head);
+        m_head = 0;
+    }
+    m_evicted += evicted;
+    return evicted;
+}
+
+void RecordStore::notifyReleased(const QVector<RecordHandle> &released)
+{
+    if (released.isEmpty()) {
+        return;
+    }
+
+    ReleaseHandler handler;
+    {
+        QReadLocker locker(&m_lock);
+        handler = m_releaseHandler;
+    }
+    if (!handler) {
+        return;
+    }
+    for (const RecordHandle &record : released) {
+        handler(*record);
+    }
+}
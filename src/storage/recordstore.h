@@ -0,0 +1,90 @@
+#ifndef RECORDSTORE_H
+#define RECORDSTORE_H
+
+#include <QHash>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QSharedPointer>
+#include <QVector>
+#include <functional>
+#include "../common.h"
+
+// 记录句柄：不可变、引用计数，可以在线程之间自由传递
+// 所有视图共享同一份记录，被淘汰的记录在最后一个句柄释放时才销毁
+typedef QSharedPointer<const AppRecord> RecordHandle;
+
+Q_DECLARE_METATYPE(RecordHandle)
+
+// 内存中的历史记录（唯一的一份）
+// 只保存 JPEG 压缩后的截图（AppRecord::encodedScreenshot），原图在写入时丢弃，
+// 需要时通过 AppRecord::image() 按需解码。总字节数超过上限时从最旧的记录开始淘汰。
+// 合并的近似重复帧与参考帧共享同一份压缩数据（隐式共享的 QByteArray），只计一次。
+// 视图不复制记录，而是连接本对象的信号，按下标取句柄显示：
+//   - recordAppended：末尾新增一条，同时可能从头部淘汰了若干条（下标整体前移）
+//   - recordsEvicted：调小上限后从头部淘汰
+//   - cleared：全部清空
+// 记录离开存储（淘汰或清空）时调用释放回调，持有者借此释放记录占用的外部资源（如帧存储中的引用）。
+// 线程安全：读写由读写锁保护，信号和回调在修改记录的线程中发出（此时锁已释放）。
+class RecordStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 记录被淘汰或清空时的回调
+    typedef std::function<void(const AppRecord &record)> ReleaseHandler;
+
+    explicit RecordStore(qint64 byteBudget = 256 * 1024 * 1024, QObject *parent = nullptr);
+
+    // 设置释放回调（已在存储中的记录离开时同样调用）
+    void setReleaseHandler(const ReleaseHandler &handler);
+
+    // 字节上限，调小时立即淘汰多余的旧记录
+    void setByteBudget(qint64 byteBudget);
+    qint64 byteBudget() const;
+
+    // 追加记录，返回因此被淘汰的旧记录数量
+    int append(const AppRecord &record);
+
+    // 清空
+    void clear();
+
+    // 访问（下标 0 为最旧的记录），下标越界时返回空句柄
+    int count() const;
+    bool isEmpty() const;
+    RecordHandle at(int index) const;
+    RecordHandle last() const;
+
+    // 当前全部记录的句柄（只复制指针）
+    QVector<RecordHandle> snapshot() const;
+
+    // 当前占用的字节数（压缩数据加文本字段的估算，共享的压缩数据只计一次）
+    qint64 byteSize() const;
+
+    // 累计淘汰的记录数量
+    quint64 evictedCount() const;
+
+    // 单条记录的字节估算（单独计算，不考虑与其他记录共享的压缩数据）
+    static qint64 recordBytes(const AppRecord &record);
+
+signals:
+    void recordAppended(const RecordHandle &record, int evicted);
+    void recordsEvicted(int count);
+    void cleared();
+
+private:
+    int evictToBudgetLocked(QVector<RecordHandle> &released);
+    qint64 addBytesLocked(const AppRecord &record);
+    qint64 removeBytesLocked(const AppRecord &record);
+    void notifyReleased(const QVector<RecordHandle> &released);
+
+    mutable QReadWriteLock m_lock;     // 保护以下成员
+    QVector<RecordHandle> m_records;   // 记录句柄
+    int m_head;                        // 第一条有效记录在 m_records 中的位置（头部淘汰时不移动数组）
+    qint64 m_byteBudget;               // 字节上限
+    qint64 m_byteSize;                 // 当前字节数
+    QHash<const char *, int> m_payloads; // 压缩数据地址 -> 共享它的记录数
+    quint64 m_evicted;                 // 累计淘汰数量
+    ReleaseHandler m_releaseHandler;   // 记录离开存储时的回调
+};
+
+#endif // RECORDSTORE_H
@@ -0,0 +1,560 @@
+#include "retentionengine.h"
+#include "framestore.h"
+#include "segmentstore.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+#include <limits>
+
+namespace {
+
+// 文件头和格式版本，结构变化时递增版本号
+const quint32 kStateMagic = 0x52544e53; // "RTNS"
+const quint32 kStateVersion = 1;
+
+// 启动后第一次执行的延迟，避开程序启动时的磁盘和 CPU 高峰
+const int kFirstPassDelayMs = 60 * 1000;
+
+const qint64 kDayMs = qint64(24) * 60 * 60 * 1000;
+
+// 单帧文件名中的应用名：<应用>_<yyyyMMdd>_<hhmmss>.jpg
+QString appNameFromFile(const QFileInfo &fileInfo)
+{
+    return fileInfo.completeBaseName().section(QLatin1Char('_'), 0, -3);
+}
+
+// 一个旧段的处理计划
+struct SegmentPlan {
+    quint32 segmentId = 0;
+    QVector<SegmentEntry> entries;
+    QVector<bool> keep;
+    qint64 fromMs = std::numeric_limits<qint64>::max();
+    qint64 toMs = std::numeric_limits<qint64>::min();
+    bool downscale = false;
+};
+
+} // namespace
+
+// 在最低优先级的线程中执行一次保留策略
+class RetentionTask : public QRunnable
+{
+public:
+    explicit RetentionTask(RetentionEngine *engine)
+        : m_engine(engine)
+    {
+    }
+
+    void run() override
+    {
+        QThread::currentThread()->setPriority(QThread::IdlePriority);
+        m_engine->runPass();
+    }
+
+private:
+    RetentionEngine *m_engine;
+};
+
+RetentionEngine::RetentionEngine(QObject *parent)
+    : QObject(parent)
+    , m_busy(0)
+    , m_stopping(0)
+    , m_segmentStore(nullptr)
+    , m_frameStore(nullptr)
+{
+    qRegisterMetaType<FrameRelocation>("FrameRelocation");
+    qRegisterMetaType<RetentionReport>("RetentionReport");
+
+    m_pool.setMaxThreadCount(1);
+    m_timer.setInterval(30 * 60 * 1000);
+    connect(&m_timer, &QTimer::timeout, this, &RetentionEngine::runNow);
+}
+
+RetentionEngine::~RetentionEngine()
+{
+    stop();
+}
+
+void RetentionEngine::setStores(SegmentStore *segmentStore, FrameStore *frameStore, const QString &frameDirectory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_segmentStore = segmentStore;
+    m_frameStore = frameStore;
+    m_frameDirectory = frameDirectory;
+}
+
+void RetentionEngine::setActiveTimeline(const QString &filePath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_activeTimeline = filePath.isEmpty() ? QString() : QFileInfo(filePath).absoluteFilePath();
+}
+
+void RetentionEngine::setConfig(const ScreenshotConfig &config)
+{
+    RetentionPolicy policy;
+    policy.enabled = config.retentionEnabled;
+    policy.maxAgeMs = qMax(0, config.retentionMaxAgeDays) * kDayMs;
+    policy.maxBytes = qMax<qint64>(0, config.retentionMaxBytes);
+    policy.appQuotas = config.retentionAppQuotas;
+    policy.downscaleAfterMs = qMax(0, config.retentionDownscaleAfterDays) * kDayMs;
+    policy.downscaleWidth = qMax(16, config.retentionDownscaleWidth);
+    policy.downscaleQuality = qBound(1, config.retentionDownscaleQuality, 100);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_policy = policy;
+    }
+    m_timer.setInterval(qMax(1, config.retentionIntervalMinutes) * 60 * 1000);
+}
+
+RetentionPolicy RetentionEngine::policy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_policy;
+}
+
+void RetentionEngine::start()
+{
+    m_stopping.storeRelease(0);
+    m_timer.start();
+    QTimer::singleShot(kFirstPassDelayMs, this, &RetentionEngine::runNow);
+}
+
+void RetentionEngine::stop()
+{
+    m_timer.stop();
+    m_stopping.storeRelease(1);
+    m_pool.waitForDone();
+}
+
+void RetentionEngine::runNow()
+{
+    if (m_stopping.loadAcquire() || !m_busy.testAndSetAcquire(0, 1)) {
+        return;
+    }
+    m_pool.start(new RetentionTask(this));
+}
+
+bool RetentionEngine::isBusy() const
+{
+    return m_busy.loadAcquire() != 0;
+}
+
+void RetentionEngine::runPass()
+{
+    RetentionPolicy policy = this->policy();
+    RetentionReport report;
+    if (policy.enabled) {
+        enforceSegments(policy, report);
+        if (!m_stopping.loadAcquire()) {
+            enforceFrameFiles(policy, report);
+        }
+        if (!m_stopping.loadAcquire()) {
+            enforceFrameStore(policy, report);
+        }
+        if (!m_stopping.loadAcquire()) {
+            enforceTimelines(policy, report);
+        }
+    }
+
+    if (report.removedSegments || report.compactedSegments || report.removedFiles || report.expiredFrames
+        || report.removedTimelines) {
+        qDebug() << "保留策略执行完成: 删除段" << report.removedSegments << "重写段" << report.compactedSegments
+                 << "去掉记录" << report.removedRecords << "缩小截图" << report.downscaledFrames
+                 << "删除文件" << report.removedFiles << "过期帧" << report.expiredFrames
+                 << "删除时间线" << report.removedTimelines << "释放" << report.freedBytes / 1024 << "KB";
+    }
+    m_busy.storeRelease(0);
+    emit passFinished(report);
+}
+
+void RetentionEngine::enforceSegments(const RetentionPolicy &policy, RetentionReport &report)
+{
+    SegmentStore *store = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        store = m_segmentStore;
+    }
+    if (!store || !store->isOpen()) {
+        return;
+    }
+
+    QString rootPath = store->rootPath();
+    if (rootPath != m_downscaledRoot) {
+        loadDownscaled(rootPath);
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 ageCutoff = policy.maxAgeMs > 0 ? now - policy.maxAgeMs : std::numeric_limits<qint64>::min();
+    const qint64 downscaleCutoff = policy.downscaleAfterMs > 0 ? now - policy.downscaleAfterMs
+                                                               : std::numeric_limits<qint64>::min();
+
+    // 1. 按时间：过期的记录标记为丢弃
+    QVector<SegmentPlan> plans;
+    const QList<quint32> segmentIds = store->closedSegmentIds();
+    for (quint32 segmentId : segmentIds) {
+        SegmentPlan plan;
+        plan.segmentId = segmentId;
+        plan.entries = store->segmentEntries(segmentId);
+        plan.keep.fill(true, plan.entries.size());
+        for (int i = 0; i < plan.entries.size(); ++i) {
+            const SegmentEntry &entry = plan.entries[i];
+            plan.fromMs = qMin(plan.fromMs, entry.timestampMs);
+            plan.toMs = qMax(plan.toMs, entry.timestampMs);
+            if (entry.timestampMs < ageCutoff) {
+                plan.keep[i] = false;
+            }
+        }
+        plan.downscale = !plan.entries.isEmpty() && plan.toMs < downscaleCutoff && !m_downscaled.contains(segmentId);
+        plans.append(plan);
+    }
+
+    // 2. 按应用配额：统计各应用在旧段中占用的字节（同段共用的截图只算第一条记录），
+    //    超出的应用从最旧的记录开始丢弃
+    if (!policy.appQuotas.isEmpty()) {
+        QHash<QString, qint64> usage;
+        for (const SegmentPlan &plan : plans) {
+            QSet<quint64> counted;
+            for (int i = 0; i < plan.entries.size(); ++i) {
+                const SegmentEntry &entry = plan.entries[i];
+                if (plan.keep[i] && !counted.contains(entry.dataOffset)) {
+                    counted.insert(entry.dataOffset);
+                    usage[store->appName(entry.appId)] += entry.dataLength;
+                }
+            }
+        }
+
+        for (auto quota = policy.appQuotas.constBegin(); quota != policy.appQuotas.constEnd(); ++quota) {
+            qint64 excess = usage.value(quota.key()) - quota.value();
+            for (int p = 0; p < plans.size() && excess > 0; ++p) {
+                SegmentPlan &plan = plans[p];
+                QSet<quint64> counted;
+                for (int i = 0; i < plan.entries.size() && excess > 0; ++i) {
+                    const SegmentEntry &entry = plan.entries[i];
+                    if (!plan.keep[i] || store->appName(entry.appId) != quota.key()) {
+                        continue;
+                    }
+                    plan.keep[i] = false;
+                    if (!counted.contains(entry.dataOffset)) {
+                        counted.insert(entry.dataOffset);
+                        excess -= entry.dataLength;
+                    }
+                }
+            }
+        }
+    }
+
+    // 3. 执行：全部丢弃的段直接删除，其余需要时重写
+    const int downscaleWidth = policy.downscaleWidth;
+    const int downscaleQuality = policy.downscaleQuality;
+    int downscaled = 0;
+    SegmentStore::FrameRewriter rewriter = [downscaleWidth, downscaleQuality, &downscaled](
+            const SegmentEntry &, const QByteArray &jpegData) {
+        // 只解码到目标尺寸（JPEG 可以在解码时按比例缩小），比整帧解码后再缩放快得多
+        QBuffer buffer;
+        buffer.setData(jpegData);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer, "JPEG");
+        QSize size = reader.size();
+        if (!size.isValid() || size.width() <= downscaleWidth) {
+            return QByteArray();
+        }
+        reader.setScaledSize(size.scaled(downscaleWidth, size.height(), Qt::KeepAspectRatio));
+        QImage image = reader.read();
+        if (image.isNull()) {
+            return QByteArray();
+        }
+
+        QByteArray encoded;
+        QBuffer output(&encoded);
+        output.open(QIODevice::WriteOnly);
+        if (!image.save(&output, "JPEG", downscaleQuality) || encoded.size() >= jpegData.size()) {
+            return QByteArray();
+        }
+        downscaled++;
+        return encoded;
+    };
+
+    bool stateChanged = false;
+    for (const SegmentPlan &plan : plans) {
+        if (m_stopping.loadAcquire()) {
+            break;
+        }
+
+        int dropped = plan.keep.count(false);
+        if (dropped == 0 && !plan.downscale) {
+            continue;
+        }
+
+        FrameRelocation relocation;
+        relocation.segment = plan.segmentId;
+        relocation.fromMs = plan.fromMs;
+        relocation.toMs = plan.toMs;
+        qint64 bytesBefore = store->segmentBytes(plan.segmentId);
+
+        if (dropped == plan.entries.size()) {
+            if (!store->removeSegment(plan.segmentId)) {
+                emit errorOccurred(QString("Failed to remove expired segment %1").arg(plan.segmentId));
+                continue;
+            }
+            relocation.removed = true;
+            report.removedSegments++;
+            report.removedRecords += dropped;
+            report.freedBytes += bytesBefore;
+            stateChanged = m_downscaled.remove(plan.segmentId) || stateChanged;
+            emit framesRelocated(relocation);
+            continue;
+        }
+
+        QHash<quint64, SegmentEntry> moves;
+        downscaled = 0;
+        if (!store->compactSegment(plan.segmentId, plan.keep, plan.downscale ? rewriter : SegmentStore::FrameRewriter(), &moves)) {
+            emit errorOccurred(QString("Failed to compact segment %1").arg(plan.segmentId));
+            continue;
+        }
+        for (auto it = moves.constBegin(); it != moves.constEnd(); ++it) {
+            FrameRef ref;
+            if (it->dataLength > 0) {
+                ref.segment = it->dataSegment;
+                ref.offset = it->dataOffset;
+                ref.length = it->dataLength;
+            }
+            relocation.moves.insert(it.key(), ref);
+        }
+
+        report.compactedSegments++;
+        report.removedRecords += dropped;
+        report.downscaledFrames += downscaled;
+        report.freedBytes += bytesBefore - store->segmentBytes(plan.segmentId);
+        if (plan.downscale) {
+            m_downscaled.insert(plan.segmentId);
+            stateChanged = true;
+        }
+        emit framesRelocated(relocation);
+    }
+
+    // 4. 按总大小：超出上限时从最旧的段开始整段删除
+    while (policy.maxBytes > 0 && store->totalBytes() > policy.maxBytes && !m_stopping.loadAcquire()) {
+        QList<quint32> remaining = store->closedSegmentIds();
+        if (remaining.isEmpty()) {
+            break;
+        }
+
+        quint32 segmentId = remaining.first();
+        QVector<SegmentEntry> entries = store->segmentEntries(segmentId);
+        qint64 bytes = store->segmentBytes(segmentId);
+        if (!store->removeSegment(segmentId)) {
+            emit errorOccurred(QString("Failed to remove segment %1").arg(segmentId));
+            break;
+        }
+
+        FrameRelocation relocation;
+        relocation.segment = segmentId;
+        relocation.removed = true;
+        relocation.fromMs = std::numeric_limits<qint64>::max();
+        relocation.toMs = std::numeric_limits<qint64>::min();
+        for (const SegmentEntry &entry : entries) {
+            relocation.fromMs = qMin(relocation.fromMs, entry.timestampMs);
+            relocation.toMs = qMax(relocation.toMs, entry.timestampMs);
+        }
+        report.removedSegments++;
+        report.removedRecords += entries.size();
+        report.freedBytes += bytes;
+        stateChanged = m_downscaled.remove(segmentId) || stateChanged;
+        emit framesRelocated(relocation);
+    }
+
+    if (stateChanged) {
+        saveDownscaled(rootPath);
+    }
+}
+
+void RetentionEngine::enforceFrameFiles(const RetentionPolicy &policy, RetentionReport &report)
+{
+    QString frameDirectory;
+    {
+        QMutexLocker locker(&m_mutex);
+        frameDirectory = m_frameDirectory;
+    }
+
+    // 单帧文件，最旧的在前
+    if (!frameDirectory.isEmpty()) {
+        QFileInfoList files = QDir(frameDirectory).entryInfoList(QStringList() << "*.jpg", QDir::Files,
+                                                                  QDir::Time | QDir::Reversed);
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        qint64 totalBytes = 0;
+        QHash<QString, qint64> usage;
+        for (const QFileInfo &file : files) {
+            totalBytes += file.size();
+            usage[appNameFromFile(file)] += file.size();
+        }
+
+        for (const QFileInfo &file : files) {
+            if (m_stopping.loadAcquire()) {
+                break;
+            }
+
+            QString appName = appNameFromFile(file);
+            bool expired = policy.maxAgeMs > 0 && file.lastModified().toMSecsSinceEpoch() < now - policy.maxAgeMs;
+            bool overTotal = policy.maxBytes > 0 && totalBytes > policy.maxBytes;
+            bool overQuota = policy.appQuotas.contains(appName) && usage.value(appName) > policy.appQuotas.value(appName);
+            if (!expired && !overTotal && !overQuota) {
+                continue;
+            }
+            if (!QFile::remove(file.absoluteFilePath())) {
+                qDebug() << "无法删除截图文件:" << file.absoluteFilePath();
+                continue;
+            }
+            totalBytes -= file.size();
+            usage[appName] -= file.size();
+            report.removedFiles++;
+            report.freedBytes += file.size();
+        }
+    }
+}
+
+void RetentionEngine::enforceFrameStore(const RetentionPolicy &policy, RetentionReport &report)
+{
+    FrameStore *frameStore = nullptr;
+    {
+        QMutexLocker locker(&m_mutex);
+        frameStore = m_frameStore;
+    }
+    if (!frameStore || !frameStore->isOpen()) {
+        return;
+    }
+
+    // 持久化引用的帧，最久未被引用的在前
+    const QVector<FrameUsage> frames = frameStore->persistentFrames();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 totalBytes = 0;
+    QHash<QString, qint64> usage;
+    for (const FrameUsage &frame : frames) {
+        totalBytes += frame.bytes;
+        usage[frame.appName] += frame.bytes;
+    }
+
+    for (const FrameUsage &frame : frames) {
+        if (m_stopping.loadAcquire()) {
+            break;
+        }
+
+        bool expired = policy.maxAgeMs > 0 && frame.lastUsedMs < now - policy.maxAgeMs;
+        bool overTotal = policy.maxBytes > 0 && totalBytes > policy.maxBytes;
+        bool overQuota = policy.appQuotas.contains(frame.appName)
+            && usage.value(frame.appName) > policy.appQuotas.value(frame.appName);
+        if (!expired && !overTotal && !overQuota) {
+            continue;
+        }
+        frameStore->expire(frame.key);
+        totalBytes -= frame.bytes;
+        usage[frame.appName] -= frame.bytes;
+        report.expiredFrames++;
+    }
+
+    // 删除已没有记录引用的帧，并保存引用计数（避免重启后恢复已过期的引用）
+    if (!m_stopping.loadAcquire()) {
+        report.freedBytes += frameStore->collectGarbage();
+    }
+    if (frameStore->isDirty()) {
+        frameStore->save();
+    }
+}
+
+void RetentionEngine::enforceTimelines(const RetentionPolicy &policy, RetentionReport &report)
+{
+    QString timelineDirectory;
+    QString activeTimeline;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_frameDirectory.isEmpty()) {
+            timelineDirectory = QDir(m_frameDirectory).filePath("timeline");
+        }
+        activeTimeline = m_activeTimeline;
+    }
+    if (timelineDirectory.isEmpty() || (policy.maxAgeMs <= 0 && policy.maxBytes <= 0)) {
+        return;
+    }
+
+    // 时间线文件，最旧的在前；文件的修改时间即最后一帧的写入时间
+    QFileInfoList files = QDir(timelineDirectory).entryInfoList(QStringList() << "*.tlc", QDir::Files,
+                                                                 QDir::Time | QDir::Reversed);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 totalBytes = 0;
+    for (const QFileInfo &file : files) {
+        totalBytes += file.size();
+    }
+
+    for (const QFileInfo &file : files) {
+        if (m_stopping.loadAcquire()) {
+            break;
+        }
+        if (file.absoluteFilePath() == activeTimeline) {
+            continue;
+        }
+
+        bool expired = policy.maxAgeMs > 0 && file.lastModified().toMSecsSinceEpoch() < now - policy.maxAgeMs;
+        bool overTotal = policy.maxBytes > 0 && totalBytes > policy.maxBytes;
+        if (!expired && !overTotal) {
+            continue;
+        }
+        if (!QFile::remove(file.absoluteFilePath())) {
+            qDebug() << "无法删除时间线文件:" << file.absoluteFilePath();
+            continue;
+        }
+        totalBytes -= file.size();
+        report.removedTimelines++;
+        report.freedBytes += file.size();
+    }
+}
+
+bool RetentionEngine::loadDownscaled(const QString &rootPath)
+{
+    m_downscaledRoot = rootPath;
+    m_downscaled.clear();
+
+    QFile file(QDir(rootPath).filePath("retention.dat"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QSet<quint32> segments;
+    stream >> magic >> version >> segments;
+    if (stream.status() != QDataStream::Ok || magic != kStateMagic || version != kStateVersion) {
+        qDebug() << "忽略无效的保留策略状态:" << file.fileName();
+        return false;
+    }
+    m_downscaled = segments;
+    return true;
+}
+
+bool RetentionEngine::saveDownscaled(const QString &rootPath)
+{
+    QSaveFile file(QDir(rootPath).filePath("retention.dat"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入保留策略状态:" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << kStateMagic << kStateVersion << m_downscaled;
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qDebug() << "保存保留策略状态失败:" << file.fileName();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,118 @@
+#ifndef RETENTIONENGINE_H
+#define RETENTIONENGINE_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include "../common.h"
+
+class SegmentStore;
+class FrameStore;
+
+// 保留策略
+struct RetentionPolicy {
+    bool enabled = true;
+    qint64 maxAgeMs = 0;                 // 截图最长保留时间（0 表示不限）
+    qint64 maxBytes = 0;                 // 总字节上限（0 表示不限）
+    QMap<QString, qint64> appQuotas;     // 应用名 -> 字节上限
+    qint64 downscaleAfterMs = 0;         // 超过多久的截图缩小保存（0 表示不缩小）
+    int downscaleWidth = 1280;           // 缩小后的最大宽度
+    int downscaleQuality = 60;           // 缩小后的 JPEG 质量
+};
+
+// 单次执行的统计
+struct RetentionReport {
+    int removedSegments = 0;             // 整段删除
+    int compactedSegments = 0;           // 去掉部分记录或缩小截图后重写的段
+    int removedRecords = 0;              // 从段中去掉的记录
+    int downscaledFrames = 0;            // 缩小保存的截图
+    int removedFiles = 0;                // 删除的单帧文件
+    int expiredFrames = 0;               // 释放持久化引用的去重帧
+    int removedTimelines = 0;            // 删除的时间线文件
+    qint64 freedBytes = 0;               // 释放的字节数
+};
+
+// 后台保留与压缩
+// 按时间间隔在单独的最低优先级线程中执行，不与截图流水线争用 CPU：
+//   - 段存储：整段过期或超出总大小时删除最旧的段；部分过期或超出应用配额时去掉这些记录后重写段；
+//     超过一定天数的段把截图缩小后重新压缩（每段只做一次，记在 <段目录>/retention.dat）
+//   - 单帧文件（<保存路径>/<应用>_<时间>.jpg）：按修改时间和文件名中的应用名执行同样的上限
+//   - 帧存储（<保存路径>/frames/objects/..）：按最近一条引用该帧的历史记录的时间和应用执行同样的上限，
+//     超出的帧释放持久化引用，之后回收引用计数为 0 的帧（内存中的记录仍在引用的帧等其释放后再删除）
+//   - 时间线文件（<保存路径>/timeline/*.tlc）：按修改时间执行最长保留时间和总大小上限，
+//     正在录制的文件不处理；一个文件包含多个应用的帧，不适用应用配额
+// 总大小上限对段存储、单帧文件、帧存储和时间线文件分别计算。
+// 只处理已滚动的旧段，正在写入的当前段不受影响。
+// 段被重写或删除后发出 framesRelocated，记录索引据此更新截图位置。
+class RetentionEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RetentionEngine(QObject *parent = nullptr);
+    ~RetentionEngine();
+
+    // 管理的存储（存储对象的生命周期必须长于引擎）
+    void setStores(SegmentStore *segmentStore, FrameStore *frameStore, const QString &frameDirectory);
+
+    // 正在录制的时间线文件（不会被删除，空表示没有录制）
+    void setActiveTimeline(const QString &filePath);
+
+    // 从截图配置中取出保留策略
+    void setConfig(const ScreenshotConfig &config);
+    RetentionPolicy policy() const;
+
+    // 按配置的间隔定时执行
+    void start();
+    void stop();
+
+    // 立即执行一次（已在执行时忽略）
+    void runNow();
+    bool isBusy() const;
+
+signals:
+    // 段被压缩或删除（工作线程中发出）
+    void framesRelocated(const FrameRelocation &relocation);
+
+    // 一次执行完成
+    void passFinished(const RetentionReport &report);
+
+    void errorOccurred(const QString &error);
+
+private:
+    friend class RetentionTask;
+
+    // 在工作线程中执行
+    void runPass();
+    void enforceSegments(const RetentionPolicy &policy, RetentionReport &report);
+    void enforceFrameFiles(const RetentionPolicy &policy, RetentionReport &report);
+    void enforceFrameStore(const RetentionPolicy &policy, RetentionReport &report);
+    void enforceTimelines(const RetentionPolicy &policy, RetentionReport &report);
+    bool loadDownscaled(const QString &rootPath);
+    bool saveDownscaled(const QString &rootPath);
+
+    QThreadPool m_pool;                  // 单线程，最低优先级
+    QTimer m_timer;                      // 执行间隔
+    QAtomicInt m_busy;                   // 正在执行
+    QAtomicInt m_stopping;               // 请求停止，执行中的一次在下一个检查点退出
+
+    mutable QMutex m_mutex;              // 保护以下成员
+    RetentionPolicy m_policy;
+    SegmentStore *m_segmentStore;
+    FrameStore *m_frameStore;
+    QString m_frameDirectory;            // 单帧文件所在目录
+    QString m_activeTimeline;            // 正在录制的时间线文件
+
+    // 以下成员只在工作线程中访问
+    QString m_downscaledRoot;            // m_downscaled 对应的段目录
+    QSet<quint32> m_downscaled;          // 已缩小过截图的段
+};
+
+Q_DECLARE_METATYPE(RetentionReport)
+
+#endif // RETENTIONENGINE_H
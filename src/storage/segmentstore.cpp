@@ -0,0 +1,919 @@
+#include "segmentstore.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 文件头和格式版本，结构变化时递增版本号
+const quint32 kSegmentMagic = 0x53454746; // "SEGF"
+const quint32 kIndexMagic = 0x53494458;   // "SIDX"
+const quint32 kAppsMagic = 0x53415050;    // "SAPP"
+const quint32 kRecordMagic = 0x53524543;  // "SREC"
+const quint32 kFormatVersion = 1;
+
+// 记录类型
+const quint8 kDataRecord = 0;   // 截图数据
+const quint8 kRefRecord = 1;    // 引用同段中更早的截图数据
+
+// 定长结构的字节数
+const int kKeyBytes = 32;
+const qint64 kSegmentHeaderSize = 4 + 4 + 4 + 8;               // magic、版本、段号、创建时间
+const qint64 kIndexHeaderSize = 4 + 4 + 4;                     // magic、版本、段号
+const qint64 kIndexEntrySize = 8 + 4 + 8 + 4 + 8 + 4 + kKeyBytes;
+const qint64 kRecordHeaderSize = 4 + 1 + 8 + 4 + kKeyBytes + 4 + 4; // ... 数据长度、CRC
+const qint64 kRefPayloadSize = 8 + 4;                          // 数据偏移、长度
+
+// 单条截图数据的长度上限，用于识别损坏的长度字段
+const quint32 kMaxPayloadSize = 256 * 1024 * 1024;
+
+// CRC32 查表（编译期生成，提交线程、保留策略线程和同步线程池并发校验时无需初始化同步）
+struct Crc32Table {
+    quint32 values[256] = {};
+};
+
+constexpr Crc32Table makeCrc32Table()
+{
+    Crc32Table table;
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 value = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+        }
+        table.values[i] = value;
+    }
+    return table;
+}
+
+constexpr Crc32Table kCrc32Table = makeCrc32Table();
+
+quint32 crc32(const QByteArray &header, const QByteArray &payload)
+{
+    const quint32 *table = kCrc32Table.values;
+    quint32 crc = 0xFFFFFFFFu;
+    for (const QByteArray *data : { &header, &payload }) {
+        for (char byte : *data) {
+            crc = table[(crc ^ quint8(byte)) & 0xFF] ^ (crc >> 8);
+        }
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// 写入缓冲并要求操作系统把文件内容落盘
+bool syncFile(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+void writeKey(QDataStream &stream, const QByteArray &key)
+{
+    QByteArray raw = key.size() == kKeyBytes ? key : QByteArray(kKeyBytes, '\0');
+    stream.writeRawData(raw.constData(), kKeyBytes);
+}
+
+QByteArray readKey(QDataStream &stream)
+{
+    QByteArray raw(kKeyBytes, '\0');
+    stream.readRawData(raw.data(), kKeyBytes);
+    return raw.count('\0') == kKeyBytes ? QByteArray() : raw;
+}
+
+QByteArray serializeEntry(const SegmentEntry &entry)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << entry.recordEnd << entry.dataSegment << entry.dataOffset << entry.dataLength
+           << entry.timestampMs << entry.appId;
+    writeKey(stream, entry.frameKey);
+    return data;
+}
+
+// 记录头：magic | 类型 | 时间戳 | 应用编号 | 内容键 | 数据长度 | CRC32
+QByteArray recordHeader(quint8 type, const SegmentEntry &entry, const QByteArray &payload)
+{
+    QByteArray header;
+    QDataStream headerStream(&header, QIODevice::WriteOnly);
+    headerStream << kRecordMagic << type << entry.timestampMs << entry.appId;
+    writeKey(headerStream, entry.frameKey);
+    headerStream << quint32(payload.size());
+    quint32 checksum = crc32(header, payload);
+    headerStream << checksum;
+    return header;
+}
+
+// 引用记录的数据：被引用截图的偏移和长度
+QByteArray refPayload(const SegmentEntry &entry)
+{
+    QByteArray payload;
+    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+    payloadStream << entry.dataOffset << entry.dataLength;
+    return payload;
+}
+
+// 整体重写索引文件（原子替换）
+bool writeIndexFile(const QString &filePath, quint32 segmentId, const QVector<SegmentEntry> &entries)
+{
+    QSaveFile index(filePath);
+    if (!index.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream indexStream(&index);
+    indexStream << kIndexMagic << kFormatVersion << segmentId;
+    for (const SegmentEntry &entry : entries) {
+        QByteArray data = serializeEntry(entry);
+        indexStream.writeRawData(data.constData(), data.size());
+    }
+    return index.commit();
+}
+
+} // namespace
+
+SegmentStore::SegmentStore()
+    : m_activeSegment(0)
+    , m_writeOffset(0)
+    , m_segmentCreatedMs(0)
+    , m_segmentCount(0)
+    , m_closedBytes(0)
+    , m_maxSegmentBytes(256 * 1024 * 1024)
+    , m_maxSegmentAgeMs(60 * 60 * 1000)
+    , m_syncBatch(16)
+    , m_syncIntervalMs(5000)
+    , m_deduplicated(0)
+{
+}
+
+SegmentStore::~SegmentStore()
+{
+    close();
+}
+
+bool SegmentStore::open(const QString &rootPath)
+{
+    QMutexLocker locker(&m_mutex);
+    closeLocked();
+
+    if (rootPath.isEmpty() || !QDir().mkpath(rootPath)) {
+        qDebug() << "无法创建段存储目录:" << rootPath;
+        return false;
+    }
+    m_rootPath = QDir(rootPath).absolutePath();
+    loadApps();
+
+    // 按段号顺序加载，最后一段继续追加
+    QList<quint32> segmentIds;
+    const QStringList files = QDir(m_rootPath).entryList(QStringList() << "seg-*.dat", QDir::Files);
+    for (const QString &file : files) {
+        bool ok = false;
+        quint32 segmentId = file.mid(4, file.size() - 8).toUInt(&ok);
+        if (ok && segmentId > 0) {
+            segmentIds.append(segmentId);
+        }
+    }
+    std::sort(segmentIds.begin(), segmentIds.end());
+
+    for (int i = 0; i < segmentIds.size(); ++i) {
+        loadSegment(segmentIds[i], i == segmentIds.size() - 1);
+    }
+
+    bool ok = segmentIds.isEmpty()
+        ? openActiveSegment(1, true)
+        : openActiveSegment(segmentIds.last(), false);
+    if (!ok) {
+        qDebug() << "无法打开段文件:" << m_segmentFile.fileName() << m_segmentFile.errorString();
+        closeLocked();
+        return false;
+    }
+
+    m_sinceSync.start();
+    qDebug() << "段存储已打开:" << m_rootPath << "段数:" << m_segmentCount << "记录数:" << m_entries.size();
+    return true;
+}
+
+void SegmentStore::close()
+{
+    QMutexLocker locker(&m_mutex);
+    closeLocked();
+}
+
+void SegmentStore::closeLocked()
+{
+    if (m_segmentFile.isOpen()) {
+        syncLocked();
+    }
+    m_segmentFile.close();
+    m_indexFile.close();
+    m_rootPath.clear();
+    m_apps.clear();
+    m_appIds.clear();
+    m_entries.clear();
+    m_pending.clear();
+    m_segmentKeys.clear();
+    m_activeSegment = 0;
+    m_writeOffset = 0;
+    m_segmentCount = 0;
+    m_closedBytes = 0;
+}
+
+bool SegmentStore::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_segmentFile.isOpen();
+}
+
+QString SegmentStore::rootPath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rootPath;
+}
+
+void SegmentStore::setMaxSegmentBytes(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxSegmentBytes = qMax<qint64>(1024 * 1024, bytes);
+}
+
+void SegmentStore::setMaxSegmentAgeMs(qint64 ageMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxSegmentAgeMs = qMax<qint64>(60 * 1000, ageMs);
+}
+
+void SegmentStore::setSyncBatch(int records, int intervalMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_syncBatch = qMax(1, records);
+    m_syncIntervalMs = qMax(0, intervalMs);
+}
+
+bool SegmentStore::append(qint64 timestampMs, const QString &appName, const QByteArray &frameKey, const QByteArray &jpegData,
+                          SegmentEntry *appended)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_segmentFile.isOpen() || jpegData.isEmpty()) {
+        return false;
+    }
+
+    // 段超过大小或时长上限时滚动（空段不滚动）
+    if (m_writeOffset > kSegmentHeaderSize
+        && (m_writeOffset >= m_maxSegmentBytes
+            || QDateTime::currentMSecsSinceEpoch() - m_segmentCreatedMs >= m_maxSegmentAgeMs)) {
+        if (!rollOverLocked()) {
+            return false;
+        }
+    }
+
+    SegmentEntry entry;
+    entry.segmentId = m_activeSegment;
+    entry.dataSegment = m_activeSegment;
+    entry.timestampMs = timestampMs;
+    entry.appId = appIdLocked(appName);
+    entry.frameKey = QByteArray::fromHex(frameKey);
+    if (entry.frameKey.size() != kKeyBytes) {
+        entry.frameKey.clear();
+    }
+
+    // 同段内已有相同内容时只写引用
+    quint8 type = kDataRecord;
+    QByteArray payload = jpegData;
+    auto existing = m_segmentKeys.constFind(entry.frameKey);
+    if (!entry.frameKey.isEmpty() && existing != m_segmentKeys.constEnd()) {
+        type = kRefRecord;
+        entry.dataOffset = existing->dataOffset;
+        entry.dataLength = existing->dataLength;
+        payload = refPayload(entry);
+    } else {
+        entry.dataOffset = quint64(m_writeOffset + kRecordHeaderSize);
+        entry.dataLength = quint32(jpegData.size());
+    }
+
+    QByteArray header = recordHeader(type, entry, payload);
+    if (m_segmentFile.write(header) != header.size() || m_segmentFile.write(payload) != payload.size()) {
+        qDebug() << "写入段文件失败:" << m_segmentFile.fileName() << m_segmentFile.errorString();
+        return false;
+    }
+    m_writeOffset += header.size() + payload.size();
+    entry.recordEnd = quint64(m_writeOffset);
+
+    if (type == kRefRecord) {
+        m_deduplicated++;
+    } else if (!entry.frameKey.isEmpty()) {
+        m_segmentKeys.insert(entry.frameKey, entry);
+    }
+    m_pending.append(entry);
+    if (appended) {
+        *appended = entry;
+    }
+
+    // 攒够一批或距上次提交足够久时统一落盘
+    if (m_pending.size() >= m_syncBatch || m_sinceSync.elapsed() >= m_syncIntervalMs) {
+        return syncLocked();
+    }
+    return true;
+}
+
+bool SegmentStore::sync()
+{
+    QMutexLocker locker(&m_mutex);
+    return syncLocked();
+}
+
+bool SegmentStore::syncLocked()
+{
+    m_sinceSync.restart();
+    if (m_pending.isEmpty()) {
+        return true;
+    }
+
+    // 先让数据落盘，再写索引：索引项指向的数据一定完整
+    if (!syncFile(m_segmentFile)) {
+        qDebug() << "段文件落盘失败:" << m_segmentFile.fileName() << m_segmentFile.errorString();
+        return false;
+    }
+
+    QByteArray indexData;
+    for (const SegmentEntry &entry : m_pending) {
+        indexData.append(serializeEntry(entry));
+    }
+    // 索引可以从段文件恢复，不单独 fsync
+    if (m_indexFile.write(indexData) != indexData.size() || !m_indexFile.flush()) {
+        qDebug() << "写入段索引失败:" << m_indexFile.fileName() << m_indexFile.errorString();
+    }
+
+    m_entries += m_pending;
+    m_pending.clear();
+    return true;
+}
+
+int SegmentStore::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+SegmentEntry SegmentStore::entry(int index) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.value(index);
+}
+
+QVector<SegmentEntry> SegmentStore::entries(qint64 fromMs, qint64 toMs) const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<SegmentEntry> result;
+    for (const SegmentEntry &entry : m_entries) {
+        if (entry.timestampMs >= fromMs && entry.timestampMs < toMs) {
+            result.append(entry);
+        }
+    }
+    return result;
+}
+
+QString SegmentStore::appName(quint32 appId) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_apps.value(int(appId));
+}
+
+QByteArray SegmentStore::read(const SegmentEntry &entry) const
+{
+    QString path;
+    {
+        QMutexLocker locker(&m_mutex);
+        path = segmentPath(entry.dataSegment);
+        // 未提交的记录可能还在写缓冲中
+        if (entry.dataSegment == m_activeSegment && m_segmentFile.isOpen()) {
+            m_segmentFile.flush();
+        }
+    }
+
+    // 读取期间旧段不会被压缩替换；每次读取单独打开文件，不与写入共享文件位置
+    QReadLocker fileLocker(&m_fileLock);
+    qint64 recordOffset = qint64(entry.dataOffset) - kRecordHeaderSize;
+    QFile file(path);
+    if (recordOffset < kSegmentHeaderSize || !file.open(QIODevice::ReadOnly) || !file.seek(recordOffset)) {
+        return QByteArray();
+    }
+
+    // 连同记录头一起读取，校验位置上确实是这条截图数据（旧段压缩后调用方的偏移可能已过期）
+    QByteArray raw = file.read(kRecordHeaderSize + entry.dataLength);
+    if (raw.size() != int(kRecordHeaderSize + entry.dataLength)) {
+        return QByteArray();
+    }
+    QDataStream headerStream(raw);
+    quint32 recordMagic = 0;
+    quint8 type = 0;
+    qint64 timestampMs = 0;
+    quint32 appId = 0;
+    quint32 payloadSize = 0;
+    headerStream >> recordMagic >> type >> timestampMs >> appId;
+    readKey(headerStream);
+    headerStream >> payloadSize;
+    if (recordMagic != kRecordMagic || type != kDataRecord || payloadSize != entry.dataLength) {
+        return QByteArray();
+    }
+    return raw.mid(int(kRecordHeaderSize));
+}
+
+QList<quint32> SegmentStore::closedSegmentIds() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<quint32> segmentIds;
+    for (const SegmentEntry &entry : m_entries) {
+        if (entry.segmentId != m_activeSegment && (segmentIds.isEmpty() || segmentIds.last() != entry.segmentId)) {
+            segmentIds.append(entry.segmentId);
+        }
+    }
+    return segmentIds;
+}
+
+QVector<SegmentEntry> SegmentStore::segmentEntries(quint32 segmentId) const
+{
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    int first = segmentRangeLocked(segmentId, count);
+    return m_entries.mid(first, count);
+}
+
+qint64 SegmentStore::segmentBytes(quint32 segmentId) const
+{
+    QMutexLocker locker(&m_mutex);
+    return QFileInfo(segmentPath(segmentId)).size();
+}
+
+bool SegmentStore::removeSegment(quint32 segmentId)
+{
+    QWriteLocker fileLocker(&m_fileLock);
+    QMutexLocker locker(&m_mutex);
+    if (!m_segmentFile.isOpen() || segmentId == m_activeSegment) {
+        return false;
+    }
+
+    QString dataPath = segmentPath(segmentId);
+    qint64 bytes = QFileInfo(dataPath).size();
+    if (!QFile::exists(dataPath)) {
+        return false;
+    }
+    if (!QFile::remove(dataPath)) {
+        qDebug() << "无法删除段文件:" << dataPath;
+        return false;
+    }
+    QFile::remove(indexPath(segmentId));
+
+    int count = 0;
+    int first = segmentRangeLocked(segmentId, count);
+    m_entries.remove(first, count);
+    m_closedBytes -= bytes;
+    m_segmentCount--;
+    qDebug() << "已删除段:" << dataPath << "记录数:" << count << "字节数:" << bytes;
+    return true;
+}
+
+bool SegmentStore::compactSegment(quint32 segmentId, const QVector<bool> &keep, const FrameRewriter &rewrite,
+                                  QHash<quint64, SegmentEntry> *relocations)
+{
+    QString rootPath;
+    QString dataPath;
+    QString idxPath;
+    QVector<SegmentEntry> entries;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_segmentFile.isOpen() || segmentId == m_activeSegment) {
+            return false;
+        }
+        rootPath = m_rootPath;
+        dataPath = segmentPath(segmentId);
+        idxPath = indexPath(segmentId);
+        int count = 0;
+        int first = segmentRangeLocked(segmentId, count);
+        entries = m_entries.mid(first, count);
+    }
+    if (entries.isEmpty() || keep.size() != entries.size()) {
+        return false;
+    }
+
+    // 旧段已关闭，不再追加，重写期间不需要持有锁
+    QFile source(dataPath);
+    if (!source.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream sourceStream(&source);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 headerSegment = 0;
+    qint64 createdMs = 0;
+    sourceStream >> magic >> version >> headerSegment >> createdMs;
+    if (sourceStream.status() != QDataStream::Ok || magic != kSegmentMagic || headerSegment != segmentId) {
+        return false;
+    }
+
+    QSaveFile target(dataPath);
+    if (!target.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法重写段文件:" << dataPath << target.errorString();
+        return false;
+    }
+    QDataStream targetStream(&target);
+    targetStream << kSegmentMagic << kFormatVersion << segmentId << createdMs;
+
+    // 被保留的记录按原顺序写入新段；多条记录共用的截图只写一次，之后写引用
+    QHash<quint64, SegmentEntry> written;   // 旧数据偏移 -> 新数据位置
+    QVector<SegmentEntry> compacted;
+    qint64 offset = kSegmentHeaderSize;
+    for (int i = 0; i < entries.size(); ++i) {
+        if (!keep[i]) {
+            continue;
+        }
+
+        const SegmentEntry &old = entries[i];
+        SegmentEntry entry = old;
+        entry.dataSegment = segmentId;
+        quint8 type = kRefRecord;
+        QByteArray payload;
+        auto existing = written.constFind(old.dataOffset);
+        if (existing != written.constEnd()) {
+            entry.dataOffset = existing->dataOffset;
+            entry.dataLength = existing->dataLength;
+            payload = refPayload(entry);
+        } else {
+            if (!source.seek(qint64(old.dataOffset))) {
+                return false;
+            }
+            payload = source.read(old.dataLength);
+            if (payload.size() != int(old.dataLength)) {
+                qDebug() << "重写段时读取截图失败:" << dataPath << old.dataOffset;
+                return false;
+            }
+            // 内容键保持不变：它标识的是采集时的画面，缩小后的截图仍归属同一画面
+            if (rewrite) {
+                QByteArray replaced = rewrite(old, payload);
+                if (!replaced.isEmpty()) {
+                    payload = replaced;
+                }
+            }
+            type = kDataRecord;
+            entry.dataOffset = quint64(offset + kRecordHeaderSize);
+            entry.dataLength = quint32(payload.size());
+            written.insert(old.dataOffset, entry);
+        }
+
+        QByteArray header = recordHeader(type, entry, payload);
+        if (target.write(header) != header.size() || target.write(payload) != payload.size()) {
+            qDebug() << "重写段文件失败:" << dataPath << target.errorString();
+            return false;
+        }
+        offset += header.size() + payload.size();
+        entry.recordEnd = quint64(offset);
+        compacted.append(entry);
+    }
+    source.close();
+
+    // 替换文件和内存中的索引项时阻止读取，读取方不会读到替换了一半的段
+    QWriteLocker fileLocker(&m_fileLock);
+    QMutexLocker locker(&m_mutex);
+    if (m_rootPath != rootPath) {
+        return false;
+    }
+    qint64 oldBytes = QFileInfo(dataPath).size();
+    if (!target.commit()) {
+        qDebug() << "替换段文件失败:" << dataPath << target.errorString();
+        return false;
+    }
+    if (!writeIndexFile(idxPath, segmentId, compacted)) {
+        // 索引与段文件不一致时下次打开会从段文件恢复
+        qDebug() << "重写段索引失败:" << idxPath;
+    }
+
+    int count = 0;
+    int first = segmentRangeLocked(segmentId, count);
+    m_entries.remove(first, count);
+    for (int i = 0; i < compacted.size(); ++i) {
+        m_entries.insert(first + i, compacted[i]);
+    }
+    m_closedBytes += offset - oldBytes;
+
+    if (relocations) {
+        relocations->clear();
+        for (const SegmentEntry &old : entries) {
+            relocations->insert(old.dataOffset, written.value(old.dataOffset));
+        }
+    }
+
+    qDebug() << "段已压缩:" << dataPath << "记录" << entries.size() << "->" << compacted.size()
+             << "字节" << oldBytes << "->" << offset;
+    return true;
+}
+
+int SegmentStore::segmentCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_segmentCount;
+}
+
+qint64 SegmentStore::totalBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_closedBytes + m_writeOffset;
+}
+
+quint64 SegmentStore::deduplicatedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_deduplicated;
+}
+
+QString SegmentStore::segmentPath(quint32 segmentId) const
+{
+    return QDir(m_rootPath).filePath(QString("seg-%1.dat").arg(segmentId, 6, 10, QChar('0')));
+}
+
+int SegmentStore::segmentRangeLocked(quint32 segmentId, int &count) const
+{
+    // 索引项按段号顺序排列，同一段的项连续存放
+    int first = 0;
+    while (first < m_entries.size() && m_entries[first].segmentId != segmentId) {
+        first++;
+    }
+    int last = first;
+    while (last < m_entries.size() && m_entries[last].segmentId == segmentId) {
+        last++;
+    }
+    count = last - first;
+    return first;
+}
+
+QString SegmentStore::indexPath(quint32 segmentId) const
+{
+    return QDir(m_rootPath).filePath(QString("seg-%1.idx").arg(segmentId, 6, 10, QChar('0')));
+}
+
+bool SegmentStore::loadApps()
+{
+    QFile file(QDir(m_rootPath).filePath("apps.dat"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QStringList apps;
+    stream >> magic >> version >> apps;
+    if (stream.status() != QDataStream::Ok || magic != kAppsMagic || version != kFormatVersion) {
+        qDebug() << "应用名表已损坏:" << file.fileName();
+        return false;
+    }
+
+    m_apps = apps;
+    for (int i = 0; i < m_apps.size(); ++i) {
+        m_appIds.insert(m_apps[i], quint32(i));
+    }
+    return true;
+}
+
+bool SegmentStore::saveApps()
+{
+    QSaveFile file(QDir(m_rootPath).filePath("apps.dat"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << kAppsMagic << kFormatVersion << m_apps;
+    return stream.status() == QDataStream::Ok && file.commit();
+}
+
+quint32 SegmentStore::appIdLocked(const QString &appName)
+{
+    auto it = m_appIds.constFind(appName);
+    if (it != m_appIds.constEnd()) {
+        return *it;
+    }
+
+    // 新应用名先写入名表，再写引用它的记录
+    quint32 appId = quint32(m_apps.size());
+    m_apps.append(appName);
+    m_appIds.insert(appName, appId);
+    if (!saveApps()) {
+        qDebug() << "保存应用名表失败:" << m_rootPath;
+    }
+    return appId;
+}
+
+bool SegmentStore::loadSegment(quint32 segmentId, bool active)
+{
+    QVector<SegmentEntry> entries;
+    const qint64 segmentSize = QFileInfo(segmentPath(segmentId)).size();
+
+    // 读取索引，只保留指向段文件范围内的项
+    QFile index(indexPath(segmentId));
+    if (index.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&index);
+        quint32 magic = 0;
+        quint32 version = 0;
+        quint32 indexSegment = 0;
+        stream >> magic >> version >> indexSegment;
+        if (stream.status() == QDataStream::Ok && magic == kIndexMagic
+            && version == kFormatVersion && indexSegment == segmentId) {
+            qint64 entryCount = (index.size() - kIndexHeaderSize) / kIndexEntrySize;
+            entries.reserve(int(entryCount));
+            for (qint64 i = 0; i < entryCount; ++i) {
+                SegmentEntry entry;
+                entry.segmentId = segmentId;
+                stream >> entry.recordEnd >> entry.dataSegment >> entry.dataOffset >> entry.dataLength
+                       >> entry.timestampMs >> entry.appId;
+                entry.frameKey = readKey(stream);
+                if (stream.status() != QDataStream::Ok || qint64(entry.recordEnd) > segmentSize) {
+                    break;
+                }
+                entries.append(entry);
+            }
+        }
+        index.close();
+    }
+
+    // 段文件比索引覆盖的范围长：上次退出前有未写入索引的记录，逐条校验补回
+    qint64 covered = entries.isEmpty() ? kSegmentHeaderSize : qint64(entries.last().recordEnd);
+    if (segmentSize > covered || index.size() != kIndexHeaderSize + entries.size() * kIndexEntrySize) {
+        if (!recoverSegment(segmentId, entries)) {
+            qDebug() << "段文件无法恢复，已跳过:" << segmentPath(segmentId);
+            return false;
+        }
+    }
+
+    m_entries += entries;
+    m_segmentCount++;
+    if (active) {
+        for (const SegmentEntry &entry : entries) {
+            if (!entry.frameKey.isEmpty() && !m_segmentKeys.contains(entry.frameKey)) {
+                m_segmentKeys.insert(entry.frameKey, entry);
+            }
+        }
+    } else {
+        m_closedBytes += QFileInfo(segmentPath(segmentId)).size();
+    }
+    return true;
+}
+
+bool SegmentStore::recoverSegment(quint32 segmentId, QVector<SegmentEntry> &entries)
+{
+    QFile segment(segmentPath(segmentId));
+    if (!segment.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    QDataStream stream(&segment);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 headerSegment = 0;
+    qint64 createdMs = 0;
+    stream >> magic >> version >> headerSegment >> createdMs;
+    if (stream.status() != QDataStream::Ok || magic != kSegmentMagic
+        || version != kFormatVersion || headerSegment != segmentId) {
+        return false;
+    }
+
+    int recovered = 0;
+    qint64 offset = entries.isEmpty() ? kSegmentHeaderSize : qint64(entries.last().recordEnd);
+    const qint64 segmentSize = segment.size();
+    while (offset + kRecordHeaderSize <= segmentSize) {
+        segment.seek(offset);
+        QByteArray raw = segment.read(kRecordHeaderSize);
+        if (raw.size() != kRecordHeaderSize) {
+            break;
+        }
+
+        // CRC 覆盖除 CRC 字段以外的记录头和数据
+        QByteArray header = raw.left(int(kRecordHeaderSize) - 4);
+        QDataStream headerStream(raw);
+        quint32 recordMagic = 0;
+        quint8 type = 0;
+        SegmentEntry entry;
+        quint32 payloadSize = 0;
+        quint32 checksum = 0;
+        headerStream >> recordMagic >> type >> entry.timestampMs >> entry.appId;
+        entry.frameKey = readKey(headerStream);
+        headerStream >> payloadSize >> checksum;
+        if (headerStream.status() != QDataStream::Ok || recordMagic != kRecordMagic
+            || payloadSize > kMaxPayloadSize || offset + kRecordHeaderSize + payloadSize > segmentSize) {
+            break;
+        }
+
+        QByteArray payload = segment.read(payloadSize);
+        if (payload.size() != int(payloadSize) || crc32(header, payload) != checksum) {
+            break;
+        }
+
+        entry.segmentId = segmentId;
+        entry.dataSegment = segmentId;
+        entry.recordEnd = quint64(offset + kRecordHeaderSize + payloadSize);
+        if (type == kRefRecord && payloadSize == kRefPayloadSize) {
+            QDataStream payloadStream(payload);
+            payloadStream >> entry.dataOffset >> entry.dataLength;
+        } else if (type == kDataRecord) {
+            entry.dataOffset = quint64(offset + kRecordHeaderSize);
+            entry.dataLength = payloadSize;
+        } else {
+            break;
+        }
+
+        entries.append(entry);
+        offset = qint64(entry.recordEnd);
+        recovered++;
+    }
+
+    // 截掉写了一半的记录，之后从完整记录的末尾继续追加
+    if (offset < segmentSize) {
+        qDebug() << "截断段文件末尾的不完整记录:" << segment.fileName() << segmentSize - offset << "字节";
+        segment.resize(offset);
+    }
+    segment.close();
+
+    // 重写索引
+    writeIndexFile(indexPath(segmentId), segmentId, entries);
+
+    qDebug() << "段文件已恢复:" << segment.fileName() << "补回记录" << recovered << "条";
+    return true;
+}
+
+bool SegmentStore::openActiveSegment(quint32 segmentId, bool create)
+{
+    m_segmentFile.close();
+    m_indexFile.close();
+    m_segmentFile.setFileName(segmentPath(segmentId));
+    m_indexFile.setFileName(indexPath(segmentId));
+
+    if (create) {
+        if (!m_segmentFile.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || !m_indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+
+        m_segmentCreatedMs = QDateTime::currentMSecsSinceEpoch();
+        QDataStream segmentStream(&m_segmentFile);
+        segmentStream << kSegmentMagic << kFormatVersion << segmentId << m_segmentCreatedMs;
+        QDataStream indexStream(&m_indexFile);
+        indexStream << kIndexMagic << kFormatVersion << segmentId;
+        if (!syncFile(m_segmentFile) || !m_indexFile.flush()) {
+            return false;
+        }
+
+        m_segmentKeys.clear();
+        m_segmentCount++;
+    } else {
+        if (!m_segmentFile.open(QIODevice::ReadWrite) || !m_indexFile.open(QIODevice::ReadWrite)) {
+            return false;
+        }
+
+        QDataStream segmentStream(&m_segmentFile);
+        quint32 magic = 0;
+        quint32 version = 0;
+        quint32 headerSegment = 0;
+        segmentStream >> magic >> version >> headerSegment >> m_segmentCreatedMs;
+        if (segmentStream.status() != QDataStream::Ok || magic != kSegmentMagic || headerSegment != segmentId) {
+            // 最后一段已损坏，另起新段
+            m_segmentFile.close();
+            m_indexFile.close();
+            return openActiveSegment(segmentId + 1, true);
+        }
+        m_segmentFile.seek(m_segmentFile.size());
+        m_indexFile.seek(m_indexFile.size());
+    }
+
+    m_activeSegment = segmentId;
+    m_writeOffset = m_segmentFile.pos();
+    return true;
+}
+
+bool SegmentStore::rollOverLocked()
+{
+    if (!syncLocked()) {
+        return false;
+    }
+
+    m_closedBytes += m_writeOffset;
+    if (!openActiveSegment(m_activeSegment + 1, true)) {
+        qDebug() << "无法创建新段:" << m_segmentFile.fileName() << m_segmentFile.errorString();
+        return false;
+    }
+    qDebug() << "段存储滚动到新段:" << m_segmentFile.fileName();
+    return true;
+}
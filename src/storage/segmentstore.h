@@ -0,0 +1,129 @@
+#ifndef SEGMENTSTORE_H
+#define SEGMENTSTORE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+// 段存储中一条记录的索引项
+struct SegmentEntry {
+    quint32 segmentId = 0;      // 记录所在的段
+    quint64 recordEnd = 0;      // 记录在所在段中的结束偏移（恢复时从这里继续扫描）
+    quint32 dataSegment = 0;    // 截图数据所在的段（去重引用时指向同段中更早的记录）
+    quint64 dataOffset = 0;     // 截图数据偏移
+    quint32 dataLength = 0;     // 截图数据长度
+    qint64 timestampMs = 0;     // 截图时间
+    quint32 appId = 0;          // 应用编号（见 SegmentStore::appName）
+    QByteArray frameKey;        // 内容键（32 字节 SHA-256，未计算时为空）
+};
+
+// 追加写入的段存储
+// 截图依次追加到大的段文件中，每个段配一个定长项的索引文件（偏移、长度、时间戳、应用编号），
+// 目录中只有少量大文件。段按大小或时长滚动。
+//
+// 写入按批提交：一批记录写完后只做一次 fsync，之后才把这批的索引项追加到索引文件，
+// 因此索引项指向的数据一定已落盘。打开时如果段文件比索引覆盖的范围长，
+// 从索引末尾开始逐条校验（魔数 + CRC32）补回索引，遇到写了一半的记录则截断段文件。
+//
+// 同一段内内容相同的截图只保存一次，后续记录写入一个指向原数据的引用；
+// 引用不跨段，删除整个旧段不会影响其他段。旧段可以整体删除，或去掉部分记录后重写（压缩）。
+//
+// 目录结构：<root>/seg-000001.dat、seg-000001.idx ...，应用名表保存在 <root>/apps.dat。
+// 所有方法线程安全。
+class SegmentStore
+{
+public:
+    SegmentStore();
+    ~SegmentStore();
+
+    // 打开存储目录，恢复未完成的段
+    bool open(const QString &rootPath);
+    void close();
+    bool isOpen() const;
+    QString rootPath() const;
+
+    // 配置
+    void setMaxSegmentBytes(qint64 bytes);       // 段大小上限
+    void setMaxSegmentAgeMs(qint64 ageMs);       // 段时长上限
+    void setSyncBatch(int records, int intervalMs); // 累计多少条或多久做一次 fsync
+
+    // 追加一条记录；frameKey 为十六进制 SHA-256（可为空），appended 不为空时返回新记录的索引项
+    bool append(qint64 timestampMs, const QString &appName, const QByteArray &frameKey, const QByteArray &jpegData,
+                SegmentEntry *appended = nullptr);
+
+    // 把未提交的记录落盘并写入索引
+    bool sync();
+
+    // 查询（只包含已提交的记录）
+    int count() const;
+    SegmentEntry entry(int index) const;
+    QVector<SegmentEntry> entries(qint64 fromMs, qint64 toMs) const;  // 时间范围 [fromMs, toMs)
+    QString appName(quint32 appId) const;
+
+    // 读取截图数据（也可以读取尚未提交的记录），位置上的记录与 entry 不符时返回空
+    QByteArray read(const SegmentEntry &entry) const;
+
+    // 维护（供保留策略使用，只作用于已滚动的旧段，当前段不受影响）
+    QList<quint32> closedSegmentIds() const;                     // 按段号（时间）顺序
+    QVector<SegmentEntry> segmentEntries(quint32 segmentId) const;
+    qint64 segmentBytes(quint32 segmentId) const;
+    bool removeSegment(quint32 segmentId);
+
+    // 重写旧段：keep[i] 为 false 的记录被丢弃，rewrite 返回非空数据时替换截图。
+    // relocations 返回旧数据偏移 -> 新索引项，dataLength 为 0 表示该截图已删除
+    using FrameRewriter = std::function<QByteArray(const SegmentEntry &entry, const QByteArray &jpegData)>;
+    bool compactSegment(quint32 segmentId, const QVector<bool> &keep, const FrameRewriter &rewrite,
+                        QHash<quint64, SegmentEntry> *relocations);
+
+    // 统计
+    int segmentCount() const;
+    qint64 totalBytes() const;
+    quint64 deduplicatedCount() const;
+
+private:
+    QString segmentPath(quint32 segmentId) const;
+    QString indexPath(quint32 segmentId) const;
+    int segmentRangeLocked(quint32 segmentId, int &count) const;
+    bool loadApps();
+    bool saveApps();
+    quint32 appIdLocked(const QString &appName);
+    bool loadSegment(quint32 segmentId, bool active);
+    bool recoverSegment(quint32 segmentId, QVector<SegmentEntry> &entries);
+    bool openActiveSegment(quint32 segmentId, bool create);
+    bool rollOverLocked();
+    bool syncLocked();
+    void closeLocked();
+
+    mutable QReadWriteLock m_fileLock;           // 读取截图时持读锁，删除或替换旧段时持写锁
+    mutable QMutex m_mutex;                      // 保护以下成员
+    QString m_rootPath;                          // 存储根目录
+    QStringList m_apps;                          // 应用编号 -> 应用名
+    QHash<QString, quint32> m_appIds;            // 应用名 -> 应用编号
+    QVector<SegmentEntry> m_entries;             // 已提交的记录（按追加顺序）
+    QVector<SegmentEntry> m_pending;             // 已写入段文件、尚未 fsync 的记录
+    QHash<QByteArray, SegmentEntry> m_segmentKeys; // 当前段内的内容键 -> 数据位置
+
+    mutable QFile m_segmentFile;                 // 当前段（读取当前段前先 flush 写缓冲）
+    QFile m_indexFile;                           // 当前段的索引
+    quint32 m_activeSegment;                     // 当前段编号
+    qint64 m_writeOffset;                        // 当前段的写入位置
+    qint64 m_segmentCreatedMs;                   // 当前段的创建时间
+    QElapsedTimer m_sinceSync;                   // 距上次提交的时长
+    int m_segmentCount;                          // 段数量
+    qint64 m_closedBytes;                        // 已滚动的旧段总字节数
+
+    qint64 m_maxSegmentBytes;
+    qint64 m_maxSegmentAgeMs;
+    int m_syncBatch;
+    int m_syncIntervalMs;
+    quint64 m_deduplicated;
+};
+
+#endif // SEGMENTSTORE_H
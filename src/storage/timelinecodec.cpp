@@ -0,0 +1,519 @@
+#include "timelinecodec.h"
+#include "../capture/framekernels.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QtMath>
+#include <cstring>
+
+namespace {
+
+// 文件头和格式版本，结构变化时递增版本号
+const quint32 kFileMagic = 0x544c4346;  // "TLCF"
+const quint32 kFileVersion = 1;
+const quint32 kFrameMagic = 0x46524d45; // "FRME"
+
+// 帧类型
+const quint8 kKeyframe = 0;
+const quint8 kDeltaFrame = 1;
+
+// 编码积压上限，超过时丢弃新帧（下一帧与参考帧比较，不影响正确性）
+const int kMaxPending = 8;
+
+// 变化图块超过这个比例时，增量帧不比关键帧小，直接写关键帧
+const double kKeyframeDirtyRatio = 0.5;
+
+QByteArray encodeJpeg(const QImage &image, int quality)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "JPEG", quality)) {
+        return QByteArray();
+    }
+    return data;
+}
+
+// 32 位像素矩形拷贝，调用方保证两边都在图像范围内
+void copyPixels(const QImage &source, int sourceX, int sourceY,
+                QImage &target, int targetX, int targetY, int width, int height)
+{
+    size_t rowBytes = size_t(width) * 4;
+    for (int row = 0; row < height; ++row) {
+        std::memcpy(target.scanLine(targetY + row) + targetX * 4,
+                    source.constScanLine(sourceY + row) + sourceX * 4, rowBytes);
+    }
+}
+
+// 马赛克图像的列数：变化图块排成接近正方形的网格
+int mosaicColumns(int tileCount)
+{
+    return qMax(1, qCeil(qSqrt(double(tileCount))));
+}
+
+} // namespace
+
+// 单帧编码任务
+class TimelineEncodeTask : public QRunnable
+{
+public:
+    TimelineEncodeTask(TimelineEncoder *encoder, const AppRecord &record)
+        : m_encoder(encoder)
+        , m_record(record)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_encoder->encodeFrame(m_record);
+    }
+
+private:
+    TimelineEncoder *m_encoder;
+    AppRecord m_record;
+};
+
+TimelineEncoder::TimelineEncoder(QObject *parent)
+    : QObject(parent)
+    , m_tileSize(64)
+    , m_keyframeInterval(30)
+    , m_quality(85)
+    , m_framesSinceKeyframe(0)
+    , m_pending(0)
+    , m_frameCount(0)
+    , m_keyframeCount(0)
+    , m_bytesWritten(0)
+    , m_jpegBytes(0)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+TimelineEncoder::~TimelineEncoder()
+{
+    close();
+}
+
+bool TimelineEncoder::open(const QString &filePath, int tileSize, int keyframeInterval, int quality)
+{
+    close();
+
+    // 图块边长对齐到 16，马赛克中的图块与 JPEG 的 MCU 边界重合
+    m_tileSize = qMax(16, (tileSize + 15) / 16 * 16);
+    m_keyframeInterval = qMax(1, keyframeInterval);
+    m_quality = quality;
+    m_framesSinceKeyframe = 0;
+    m_reference = QImage();
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit errorOccurred("Failed to create timeline: " + filePath + " (" + m_file.errorString() + ")");
+        return false;
+    }
+
+    QDataStream stream(&m_file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << kFileMagic << kFileVersion << qint32(m_tileSize) << qint32(m_keyframeInterval);
+
+    QMutexLocker locker(&m_mutex);
+    m_frameCount = 0;
+    m_keyframeCount = 0;
+    m_bytesWritten = m_file.pos();
+    m_jpegBytes = 0;
+    qDebug() << "时间线录制开始:" << filePath;
+    return true;
+}
+
+void TimelineEncoder::close()
+{
+    // 已提交的帧仍然写完
+    m_pool.waitForDone();
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    m_file.close();
+    m_reference = QImage();
+    qDebug() << "时间线录制结束:" << m_file.fileName() << "帧数:" << frameCount()
+             << "关键帧:" << keyframeCount() << "压缩比:" << compressionRatio();
+}
+
+bool TimelineEncoder::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString TimelineEncoder::filePath() const
+{
+    return m_file.fileName();
+}
+
+bool TimelineEncoder::appendFrame(const AppRecord &record)
+{
+    if (!m_file.isOpen() || record.screenshot.isNull()) {
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_pending >= kMaxPending) {
+            return false;
+        }
+        m_pending++;
+    }
+
+    m_pool.start(new TimelineEncodeTask(this, record));
+    return true;
+}
+
+int TimelineEncoder::frameCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_frameCount;
+}
+
+int TimelineEncoder::keyframeCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_keyframeCount;
+}
+
+qint64 TimelineEncoder::bytesWritten() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytesWritten;
+}
+
+qint64 TimelineEncoder::jpegBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_jpegBytes;
+}
+
+double TimelineEncoder::compressionRatio() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytesWritten > 0 ? double(m_jpegBytes) / m_bytesWritten : 0.0;
+}
+
+void TimelineEncoder::encodeFrame(const AppRecord &record)
+{
+    QImage frame = record.screenshot.format() == QImage::Format_RGB32
+        ? record.screenshot
+        : record.screenshot.convertToFormat(QImage::Format_RGB32);
+
+    // 首帧、尺寸变化或达到关键帧间隔时写关键帧，保证随机访问的解码量有上限
+    bool keyframe = m_reference.isNull()
+        || m_reference.size() != frame.size()
+        || m_framesSinceKeyframe >= m_keyframeInterval;
+
+    QByteArray data;
+    if (!keyframe) {
+        int dirtyCount = 0;
+        data = encodeDelta(frame, dirtyCount);
+        keyframe = dirtyCount < 0;
+    }
+    if (keyframe) {
+        data = encodeJpeg(frame, m_quality);
+    }
+
+    bool ok = !data.isEmpty() && writeFrame(keyframe ? kKeyframe : kDeltaFrame, record, frame, data);
+    if (ok) {
+        m_reference = frame;
+        m_framesSinceKeyframe = keyframe ? 1 : m_framesSinceKeyframe + 1;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pending--;
+        if (ok) {
+            m_frameCount++;
+            m_keyframeCount += keyframe ? 1 : 0;
+            m_bytesWritten = m_file.pos();
+            m_jpegBytes += record.encodedScreenshot.size();
+        }
+    }
+
+    if (!ok) {
+        emit errorOccurred("Failed to write timeline frame: " + m_file.fileName());
+    }
+}
+
+QByteArray TimelineEncoder::encodeDelta(const QImage &frame, int &dirtyCount)
+{
+    const int columns = (frame.width() + m_tileSize - 1) / m_tileSize;
+    const int rows = (frame.height() + m_tileSize - 1) / m_tileSize;
+    const int totalTiles = columns * rows;
+    const int stride = frame.bytesPerLine();
+    const int referenceStride = m_reference.bytesPerLine();
+
+    // 与上一帧原图逐块比较（SIMD）
+    QVector<qint32> dirtyTiles;
+    for (int tileY = 0; tileY < rows; ++tileY) {
+        for (int tileX = 0; tileX < columns; ++tileX) {
+            int x = tileX * m_tileSize;
+            int y = tileY * m_tileSize;
+            int width = qMin(m_tileSize, frame.width() - x);
+            int height = qMin(m_tileSize, frame.height() - y);
+            if (!FrameKernels::tilesEqual(frame.constBits() + y * stride + x * 4, stride,
+                                          m_reference.constBits() + y * referenceStride + x * 4, referenceStride,
+                                          width, height)) {
+                dirtyTiles.append(tileY * columns + tileX);
+            }
+        }
+    }
+
+    if (dirtyTiles.size() > totalTiles * kKeyframeDirtyRatio) {
+        dirtyCount = -1;
+        return QByteArray();
+    }
+    dirtyCount = dirtyTiles.size();
+
+    // 变化图块按顺序排进马赛克，边缘图块只占槽位的左上部分
+    QByteArray mosaicJpeg;
+    if (!dirtyTiles.isEmpty()) {
+        int mosaicCols = mosaicColumns(dirtyTiles.size());
+        int mosaicRows = (dirtyTiles.size() + mosaicCols - 1) / mosaicCols;
+        QImage mosaic(mosaicCols * m_tileSize, mosaicRows * m_tileSize, QImage::Format_RGB32);
+        mosaic.fill(Qt::black);
+        for (int slot = 0; slot < dirtyTiles.size(); ++slot) {
+            int x = (dirtyTiles[slot] % columns) * m_tileSize;
+            int y = (dirtyTiles[slot] / columns) * m_tileSize;
+            copyPixels(frame, x, y, mosaic, (slot % mosaicCols) * m_tileSize, (slot / mosaicCols) * m_tileSize,
+                       qMin(m_tileSize, frame.width() - x), qMin(m_tileSize, frame.height() - y));
+        }
+        mosaicJpeg = encodeJpeg(mosaic, m_quality);
+        if (mosaicJpeg.isEmpty()) {
+            return QByteArray();
+        }
+    }
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << dirtyTiles << mosaicJpeg;
+    return data;
+}
+
+bool TimelineEncoder::writeFrame(quint8 type, const AppRecord &record, const QImage &frame, const QByteArray &data)
+{
+    QByteArray meta;
+    QDataStream metaStream(&meta, QIODevice::WriteOnly);
+    metaStream.setVersion(QDataStream::Qt_5_12);
+    metaStream << record.timestamp.toMSecsSinceEpoch() << record.appName << record.appPath
+               << record.windowTitle << qint32(frame.width()) << qint32(frame.height());
+
+    QDataStream stream(&m_file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << kFrameMagic << type << meta << data;
+
+    // 每帧落盘，录制中断时只丢失最后一帧
+    return stream.status() == QDataStream::Ok && m_file.flush();
+}
+
+TimelineDecoder::TimelineDecoder()
+    : m_tileSize(0)
+    , m_currentIndex(-1)
+{
+}
+
+bool TimelineDecoder::open(const QString &filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qDebug() << "无法打开时间线:" << filePath << m_file.errorString();
+        return false;
+    }
+
+    QDataStream stream(&m_file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 tileSize = 0;
+    qint32 keyframeInterval = 0;
+    stream >> magic >> version >> tileSize >> keyframeInterval;
+    if (stream.status() != QDataStream::Ok || magic != kFileMagic || version != kFileVersion || tileSize <= 0) {
+        qDebug() << "不是有效的时间线文件:" << filePath;
+        m_file.close();
+        return false;
+    }
+    m_tileSize = tileSize;
+
+    // 只读取元数据建立索引，跳过帧数据
+    const qint64 fileSize = m_file.size();
+    int keyframeIndex = -1;
+    while (!m_file.atEnd()) {
+        quint32 frameMagic = 0;
+        quint8 type = 0;
+        QByteArray meta;
+        quint32 dataSize = 0;
+        stream >> frameMagic >> type >> meta >> dataSize;
+        if (stream.status() != QDataStream::Ok || frameMagic != kFrameMagic
+            || m_file.pos() + qint64(dataSize) > fileSize) {
+            qDebug() << "时间线末尾有不完整的帧，已忽略:" << filePath;
+            break;
+        }
+
+        TimelineFrameInfo info;
+        qint64 timestampMs = 0;
+        qint32 width = 0;
+        qint32 height = 0;
+        QDataStream metaStream(meta);
+        metaStream.setVersion(QDataStream::Qt_5_12);
+        metaStream >> timestampMs >> info.appName >> info.appPath >> info.windowTitle >> width >> height;
+
+        info.timestamp = QDateTime::fromMSecsSinceEpoch(timestampMs);
+        info.width = width;
+        info.height = height;
+        info.keyframe = type == kKeyframe;
+        if (info.keyframe) {
+            keyframeIndex = m_frames.size();
+        }
+        info.keyframeIndex = keyframeIndex;
+        info.dataOffset = m_file.pos();
+        info.dataSize = qint32(dataSize);
+        m_frames.append(info);
+
+        if (!m_file.seek(info.dataOffset + dataSize)) {
+            break;
+        }
+    }
+
+    qDebug() << "已打开时间线:" << filePath << "帧数:" << m_frames.size();
+    return true;
+}
+
+void TimelineDecoder::close()
+{
+    m_file.close();
+    m_frames.clear();
+    m_current = QImage();
+    m_currentIndex = -1;
+}
+
+bool TimelineDecoder::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString TimelineDecoder::filePath() const
+{
+    return m_file.fileName();
+}
+
+int TimelineDecoder::frameCount() const
+{
+    return m_frames.size();
+}
+
+const TimelineFrameInfo &TimelineDecoder::frameInfo(int index) const
+{
+    return m_frames.at(index);
+}
+
+QList<AppRecord> TimelineDecoder::records() const
+{
+    QList<AppRecord> records;
+    records.reserve(m_frames.size());
+    for (const TimelineFrameInfo &info : m_frames) {
+        AppRecord record;
+        record.appName = info.appName;
+        record.timestamp = info.timestamp;
+        record.appPath = info.appPath;
+        record.windowTitle = info.windowTitle;
+        records.append(record);
+    }
+    return records;
+}
+
+QImage TimelineDecoder::frame(int index)
+{
+    if (index < 0 || index >= m_frames.size() || m_frames[index].keyframeIndex < 0) {
+        return QImage();
+    }
+    if (index == m_currentIndex) {
+        return m_current;
+    }
+
+    // 同一关键帧区间内向后浏览时，从当前画面继续应用增量帧
+    int keyframeIndex = m_frames[index].keyframeIndex;
+    int first = (m_currentIndex >= keyframeIndex && m_currentIndex < index) ? m_currentIndex + 1 : keyframeIndex;
+    for (int i = first; i <= index; ++i) {
+        if (!applyFrame(i)) {
+            m_current = QImage();
+            m_currentIndex = -1;
+            return QImage();
+        }
+    }
+
+    m_currentIndex = index;
+    return m_current;
+}
+
+bool TimelineDecoder::readData(int index, QByteArray &data)
+{
+    const TimelineFrameInfo &info = m_frames[index];
+    if (!m_file.seek(info.dataOffset)) {
+        return false;
+    }
+    data = m_file.read(info.dataSize);
+    return data.size() == info.dataSize;
+}
+
+bool TimelineDecoder::applyFrame(int index)
+{
+    const TimelineFrameInfo &info = m_frames[index];
+    QByteArray data;
+    if (!readData(index, data)) {
+        qDebug() << "读取时间线帧失败:" << index;
+        return false;
+    }
+
+    if (info.keyframe) {
+        m_current = QImage::fromData(data, "JPEG").convertToFormat(QImage::Format_RGB32);
+        return m_current.width() == info.width && m_current.height() == info.height;
+    }
+
+    if (m_current.width() != info.width || m_current.height() != info.height) {
+        return false;
+    }
+
+    QVector<qint32> dirtyTiles;
+    QByteArray mosaicJpeg;
+    QDataStream stream(data);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream >> dirtyTiles >> mosaicJpeg;
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+    if (dirtyTiles.isEmpty()) {
+        return true;
+    }
+
+    QImage mosaic = QImage::fromData(mosaicJpeg, "JPEG").convertToFormat(QImage::Format_RGB32);
+    int columns = (info.width + m_tileSize - 1) / m_tileSize;
+    int mosaicCols = mosaicColumns(dirtyTiles.size());
+    int mosaicRows = (dirtyTiles.size() + mosaicCols - 1) / mosaicCols;
+    if (mosaic.width() != mosaicCols * m_tileSize || mosaic.height() != mosaicRows * m_tileSize) {
+        return false;
+    }
+
+    for (int slot = 0; slot < dirtyTiles.size(); ++slot) {
+        int x = (dirtyTiles[slot] % columns) * m_tileSize;
+        int y = (dirtyTiles[slot] / columns) * m_tileSize;
+        if (dirtyTiles[slot] < 0 || x >= info.width || y >= info.height) {
+            return false;
+        }
+        copyPixels(mosaic, (slot % mosaicCols) * m_tileSize, (slot / mosaicCols) * m_tileSize, m_current, x, y,
+                   qMin(m_tileSize, info.width - x), qMin(m_tileSize, info.height - y));
+    }
+    return true;
+}
@@ -0,0 +1,134 @@
+#ifndef TIMELINECODEC_H
+#define TIMELINECODEC_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include "../common.h"
+
+// 时间线容器格式（.tlc）
+// 同一次录制的截图按时间顺序写入一个文件：关键帧保存整帧 JPEG，
+// 增量帧只保存与上一帧相比发生变化的图块。变化图块拼成一张马赛克图像后整体压缩一次，
+// 避免每个小图块各自带一份 JPEG 文件头。
+//
+// 文件头: magic "TLCF" | 版本 | 图块边长 | 关键帧间隔
+// 每帧:   magic "FRME" | 类型 | 元数据长度 | 元数据 | 数据长度 | 数据
+//   元数据: 时间戳、应用名、路径、窗口标题、宽、高
+//   关键帧数据: 整帧 JPEG
+//   增量帧数据: 变化图块索引列表 + 马赛克 JPEG
+//
+// 随机访问时从目标帧之前最近的关键帧开始，最多解码一个关键帧加 (关键帧间隔 - 1) 个增量帧。
+// 录制中断时文件末尾可能有不完整的帧，打开时会被忽略。
+
+// 时间线中单帧的元数据
+struct TimelineFrameInfo {
+    QDateTime timestamp;       // 截图时间
+    QString appName;           // 应用名
+    QString appPath;           // 可执行文件路径
+    QString windowTitle;       // 窗口标题
+    int width = 0;             // 帧宽
+    int height = 0;            // 帧高
+    bool keyframe = false;     // 是否关键帧
+    int keyframeIndex = 0;     // 所属关键帧的帧序号
+    qint64 dataOffset = 0;     // 帧数据在文件中的偏移
+    qint32 dataSize = 0;       // 帧数据长度
+};
+
+// 时间线编码器
+// 在单个后台线程中按提交顺序编码并追加写入，调用方（GUI 线程）只投递帧。
+// 增量帧的变化图块由编码器自己与上一帧原图逐块比较得出，与流水线的变化检测互不依赖。
+class TimelineEncoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TimelineEncoder(QObject *parent = nullptr);
+    ~TimelineEncoder();
+
+    // 新建时间线文件（已有文件会被覆盖）
+    bool open(const QString &filePath, int tileSize, int keyframeInterval, int quality);
+    void close();
+    bool isOpen() const;
+    QString filePath() const;
+
+    // 追加一帧（record.screenshot 必须是原图），积压过多时丢弃并返回 false
+    bool appendFrame(const AppRecord &record);
+
+    // 统计
+    int frameCount() const;            // 已写入帧数
+    int keyframeCount() const;         // 已写入关键帧数
+    qint64 bytesWritten() const;       // 时间线文件字节数
+    qint64 jpegBytes() const;          // 同样的帧各自保存为整帧 JPEG 时的字节数
+    double compressionRatio() const;   // jpegBytes / bytesWritten
+
+signals:
+    void errorOccurred(const QString &error);
+
+private:
+    friend class TimelineEncodeTask;
+
+    // 在工作线程中执行
+    void encodeFrame(const AppRecord &record);
+    bool writeFrame(quint8 type, const AppRecord &record, const QImage &frame, const QByteArray &data);
+    QByteArray encodeDelta(const QImage &frame, int &dirtyCount);
+
+    QThreadPool m_pool;               // 单线程，保证帧按顺序写入
+    mutable QMutex m_mutex;           // 保护统计和积压计数
+
+    // 以下成员只在工作线程（或等待工作线程结束后）访问
+    QFile m_file;                     // 时间线文件
+    QImage m_reference;               // 上一帧原图（Format_RGB32）
+    int m_tileSize;                   // 图块边长
+    int m_keyframeInterval;           // 关键帧间隔
+    int m_quality;                    // JPEG 质量
+    int m_framesSinceKeyframe;        // 距上一关键帧的帧数
+
+    int m_pending;                    // 排队中的帧数
+    int m_frameCount;
+    int m_keyframeCount;
+    qint64 m_bytesWritten;
+    qint64 m_jpegBytes;
+};
+
+// 时间线解码器
+// 打开时只扫描各帧的元数据建立索引，帧数据按需解码。
+// 缓存最近一次解码得到的画面，顺序浏览时每帧只需应用一个增量帧。
+class TimelineDecoder
+{
+public:
+    TimelineDecoder();
+
+    bool open(const QString &filePath);
+    void close();
+    bool isOpen() const;
+    QString filePath() const;
+
+    // 帧索引
+    int frameCount() const;
+    const TimelineFrameInfo &frameInfo(int index) const;
+
+    // 各帧的记录（不含截图，用 frame() 解码）
+    QList<AppRecord> records() const;
+
+    // 解码指定帧，失败时返回空图像
+    QImage frame(int index);
+
+private:
+    bool readData(int index, QByteArray &data);
+    bool applyFrame(int index);
+
+    QFile m_file;                           // 时间线文件
+    int m_tileSize;                         // 图块边长
+    QVector<TimelineFrameInfo> m_frames;    // 帧索引
+    QImage m_current;                       // 最近一次解码的画面
+    int m_currentIndex;                     // m_current 对应的帧序号（-1 表示无）
+};
+
+#endif // TIMELINECODEC_H